@@ -5,5 +5,6 @@ class plane : entity {
         super(position, rotation, scale);
         impl_.add_staticmesh_component("meshes/plane.msh");
         impl_.add_physics_component(triangle_mesh_shape("meshes/plane.col"), true);
+        impl_.add_static_batch_component();
     }
 }
@@ -15,7 +15,8 @@ uniform sampler2D normal_texture;
 uniform vec3 view_vector;
 uniform float disp_map_scale;
 uniform float disp_map_bias;
-uniform bool parallax_mapping;
+uniform bool octahedral_normals;
+flat in int parallax_mapping_;
 
 vec3 calc_normal(sampler2D normal_map, vec2 texcoord, mat3 tbn) {
 	vec3 normal = normalize(2.0 * texture(normal_map, texcoord).xyz - vec3(1.0, 1.0, 1.0));
@@ -23,6 +24,15 @@ vec3 calc_normal(sampler2D normal_map, vec2 texcoord, mat3 tbn) {
 	return normal;
 }
 
+// the normal target stores normals octahedral encoded in two unsigned channels when octahedral_normals is set
+vec2 encode_octahedral(vec3 n) {
+	n /= abs(n.x) + abs(n.y) + abs(n.z);
+	if (n.z < 0.0) {
+		n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+	}
+	return n.xy * 0.5 + 0.5;
+}
+
 void main() {
 	vec3 normal = normalize(normal_);
 	vec3 tangent = normalize(tangent_);
@@ -34,12 +44,13 @@ void main() {
 
 	vec2 texcoord = texcoord_;
 
-	if (parallax_mapping) {
+	if (parallax_mapping_ != 0) {
 		texcoord = texcoord_ + (tbn * direction_to_view).xy * (texture(specular_texture, texcoord_).b
 			* disp_map_scale + disp_map_bias);
 	}
 
-    normal_color = calc_normal(normal_texture, texcoord, tbn);
+    normal = calc_normal(normal_texture, texcoord, tbn);
+    normal_color = octahedral_normals ? vec3(encode_octahedral(normal), 0.0) : normal;
     albedo_color = texture(color_texture, texcoord);
     specular_color = texture(specular_texture, texcoord);
 }
@@ -8,14 +8,17 @@ uniform sampler2D albedo_texture;
 uniform sampler2D normal_texture;
 uniform sampler2D specular_texture;
 uniform sampler2D depth_texture;
-uniform sampler2D shadow_texture;
+uniform bool octahedral_normals;
+uniform sampler2DArray shadow_texture;
 uniform mat4 inv_view_projection;
 uniform vec3 view_vector;
-uniform int point_light_num;
-// uniform arry size is a magic magic number. super magic.
-uniform vec3 point_light_positions[40];
-uniform vec3 point_light_colors[40];
-uniform float point_light_radii[40];
+uniform samplerBuffer light_texture;
+uniform usamplerBuffer cluster_texture;
+uniform usamplerBuffer light_index_texture;
+uniform mat4 view;
+uniform ivec3 cluster_dimensions;
+uniform float cluster_near_plane;
+uniform float cluster_depth_scale;
 uniform int directional_light_num;
 // uniform arry size is a magic magic number. super magic.
 uniform vec3 directional_light_directions[40];
@@ -24,6 +27,20 @@ uniform float directional_light_energy[40];
 uniform mat4 shadow_projection;
 uniform vec3 ambient_term;
 
+vec3 decode_octahedral(vec2 e) {
+	e = 2.0 * e - 1.0;
+	vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	float t = max(-n.z, 0.0);
+	n.x += n.x >= 0.0 ? -t : t;
+	n.y += n.y >= 0.0 ? -t : t;
+	return n;
+}
+
+vec3 read_normal(vec2 texcoord) {
+	vec4 normal = texture(normal_texture, texcoord);
+	return normalize(octahedral_normals ? decode_octahedral(normal.xy) : normal.xyz);
+}
+
 vec3 blinn_phong(vec3 N, vec3 L, vec3 V, vec3 light_color, vec3 diff_color, vec3 spec_color, float shininess) {
 	vec3 H = normalize(L + V);
 
@@ -33,7 +50,7 @@ vec3 blinn_phong(vec3 N, vec3 L, vec3 V, vec3 light_color, vec3 diff_color, vec3
 	return ambient_term + light_color * diff_color * NdotL + light_color * spec_color * pow(NdotH, shininess);
 }
 
-float sample_shadow(sampler2D shadow_map, vec2 texcoord, float compare) {
+float sample_shadow(sampler2DArray shadow_map, vec3 texcoord, float compare) {
 	return step(compare, texture(shadow_map, texcoord).r);
 }
 
@@ -41,7 +58,7 @@ float linstep(float low, float high, float v) {
 	return clamp((v - low) / (high - low), 0.0, 1.0);
 }
 
-float sample_variance_shadow(sampler2D shadow_map, vec2 texcoord, float compare) {
+float sample_variance_shadow(sampler2DArray shadow_map, vec3 texcoord, float compare) {
 	vec2 moments = texture(shadow_map, texcoord).xy;
 
 	float p = step(compare, moments.x);
@@ -53,9 +70,17 @@ float sample_variance_shadow(sampler2D shadow_map, vec2 texcoord, float compare)
 	return min(max(p, p_max), 1.0);
 }
 
-float calculate_shadow_amount(sampler2D shadow_map, vec4 initial_shadow_coord) {
+float calculate_shadow_amount(sampler2DArray shadow_map, vec4 initial_shadow_coord) {
 	vec3 shadow_coord = initial_shadow_coord.xyz / initial_shadow_coord.w;
-	return sample_variance_shadow(shadow_map, shadow_coord.xy, shadow_coord.z);
+	return sample_variance_shadow(shadow_map, vec3(shadow_coord.xy, 0.0), shadow_coord.z);
+}
+
+int find_cluster(vec2 screen_coord, vec3 p) {
+	float view_depth = -(view * vec4(p, 1.0)).z;
+	int slice = int(log(max(view_depth, cluster_near_plane) / cluster_near_plane) * cluster_depth_scale);
+	ivec3 cluster = ivec3(ivec2(screen_coord * vec2(cluster_dimensions.xy)), slice);
+	cluster = clamp(cluster, ivec3(0), cluster_dimensions - 1);
+	return (cluster.z * cluster_dimensions.y + cluster.y) * cluster_dimensions.x + cluster.x;
 }
 
 void main() {
@@ -72,24 +97,28 @@ void main() {
 	float shadow_amount = 1.0;
 	shadow_amount = calculate_shadow_amount(shadow_texture, position_shadow);
 
-	vec3 N = normalize(texture(normal_texture, texcoord_).xyz);
+	vec3 N = read_normal(texcoord_);
 	vec3 V = normalize(view_vector - p);
 	vec3 diffuse_color = texture(albedo_texture, texcoord_).rgb;
 	vec3 spec_color = texture(specular_texture, texcoord_).rrr;
 	float emission = texture(specular_texture, texcoord_).g;
 	vec3 final_color = vec3(0.0);
-	for (int i = 0; i < point_light_num; ++i) {
-		vec3 L = point_light_positions[i] - p;
+	uvec2 cluster = texelFetch(cluster_texture, find_cluster(texcoord_, p)).xy;
+	for (uint i = 0u; i < cluster.y; ++i) {
+		int light = int(texelFetch(light_index_texture, int(cluster.x + i)).x);
+		vec4 position_radius = texelFetch(light_texture, 2 * light);
+		vec3 light_color = texelFetch(light_texture, 2 * light + 1).rgb;
+		vec3 L = position_radius.xyz - p;
 
 		float d = length(L);
-		float r = point_light_radii[i];
+		float r = position_radius.w;
 		float ac = 1;
 		float al = 2 / r;
 		float ae = 1 / pow(r, 2.0);
 		float attenuation_denominator = ac + al * d + ae * pow(d, 2.0);
 
 		L = normalize(L);
-		final_color += blinn_phong(N, L, V, point_light_colors[i], diffuse_color, spec_color, 50)
+		final_color += blinn_phong(N, L, V, light_color, diffuse_color, spec_color, 50)
 			/ attenuation_denominator;
 	}
 
@@ -0,0 +1,16 @@
+#version 330
+
+in vec3 _position;
+in float _draw_id;
+
+// the per draw data of staticmesh.vs, of which only the model matrix is read
+uniform samplerBuffer draw_data;
+uniform int draw_offset;
+uniform mat4 projection_view;
+
+void main() {
+    int texel = 7 * (draw_offset + int(_draw_id));
+    mat4 m = mat4(texelFetch(draw_data, texel), texelFetch(draw_data, texel + 1),
+        texelFetch(draw_data, texel + 2), texelFetch(draw_data, texel + 3));
+    gl_Position = projection_view * m * vec4(_position, 1.0);
+}
@@ -8,16 +8,41 @@ uniform sampler2D albedo_texture;
 uniform sampler2D normal_texture;
 uniform sampler2D specular_texture;
 uniform sampler2D depth_texture;
-uniform sampler2D shadow_texture;
+uniform bool octahedral_normals;
+uniform sampler2DArray shadow_texture;
 uniform mat4 inv_view_projection;
 uniform vec3 view_vector;
 uniform vec3 directional_light_direction;
 uniform vec3 directional_light_color;
 uniform float directional_light_energy;
-uniform mat4 shadow_projection;
+uniform mat4 shadow_projections[4];
+uniform float cascade_splits[4];
+uniform int cascade_count;
+uniform mat4 view;
 uniform float ambient_term;
 uniform vec2 resolution;
+// the g-buffer is larger than the rendered viewport with dynamic resolution
+uniform vec2 g_buffer_size;
 uniform bool shadow_casting;
+uniform int shadow_filter;
+uniform float min_variance;
+
+const float positive_exponent = 5.0;
+const float negative_exponent = 5.0;
+
+vec3 decode_octahedral(vec2 e) {
+	e = 2.0 * e - 1.0;
+	vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	float t = max(-n.z, 0.0);
+	n.x += n.x >= 0.0 ? -t : t;
+	n.y += n.y >= 0.0 ? -t : t;
+	return n;
+}
+
+vec3 read_normal(vec2 texcoord) {
+	vec4 normal = texture(normal_texture, texcoord);
+	return normalize(octahedral_normals ? decode_octahedral(normal.xy) : normal.xyz);
+}
 
 vec3 blinn_phong(vec3 N, vec3 L, vec3 V, vec3 light_color, vec3 diff_color, vec3 spec_color, float shininess) {
 	vec3 H = normalize(L + V);
@@ -28,7 +53,7 @@ vec3 blinn_phong(vec3 N, vec3 L, vec3 V, vec3 light_color, vec3 diff_color, vec3
 	return light_color * diff_color * NdotL + light_color * spec_color * pow(NdotH, shininess);
 }
 
-float sample_shadow(sampler2D shadow_map, vec2 texcoord, float compare) {
+float sample_shadow(sampler2DArray shadow_map, vec3 texcoord, float compare) {
 	return step(compare, texture(shadow_map, texcoord).r);
 }
 
@@ -36,11 +61,9 @@ float linstep(float low, float high, float v) {
 	return clamp((v - low) / (high - low), 0.0, 1.0);
 }
 
-float sample_variance_shadow(sampler2D shadow_map, vec2 texcoord, float compare) {
-	vec2 moments = texture(shadow_map, texcoord).xy;
-
+float chebyshev_upper_bound(vec2 moments, float compare, float variance_bias) {
 	float p = step(compare, moments.x);
-	float variance = max(moments.y - moments.x * moments.x, 0.000002);
+	float variance = max(moments.y - moments.x * moments.x, variance_bias);
 
 	float d = compare - moments.x;
 	float p_max = linstep(0.2, 1.0, variance / (variance + d * d));
@@ -48,13 +71,49 @@ float sample_variance_shadow(sampler2D shadow_map, vec2 texcoord, float compare)
 	return min(max(p, p_max), 1.0);
 }
 
-float calculate_shadow_amount(sampler2D shadow_map, vec4 initial_shadow_coord) {
+float sample_variance_shadow(sampler2DArray shadow_map, vec3 texcoord, float compare) {
+	vec2 moments = texture(shadow_map, texcoord).xy;
+	return chebyshev_upper_bound(moments, compare, min_variance);
+}
+
+float sample_exponential_variance_shadow(sampler2DArray shadow_map, vec3 texcoord, float compare) {
+	vec4 moments = texture(shadow_map, texcoord);
+
+	float depth = 2.0 * compare - 1.0;
+	float positive = exp(positive_exponent * depth);
+	float negative = -exp(-negative_exponent * depth);
+
+	// the variance bias has to be scaled into the warped space of each exponent
+	float positive_bias = min_variance * positive_exponent * positive * positive_exponent * positive;
+	float negative_bias = min_variance * negative_exponent * negative * negative_exponent * negative;
+
+	float positive_amount = chebyshev_upper_bound(moments.xy, positive, positive_bias);
+	float negative_amount = chebyshev_upper_bound(moments.zw, negative, negative_bias);
+	return min(positive_amount, negative_amount);
+}
+
+float calculate_shadow_amount(sampler2DArray shadow_map, vec4 initial_shadow_coord, int cascade) {
 	vec3 shadow_coord = initial_shadow_coord.xyz / initial_shadow_coord.w;
-	return sample_variance_shadow(shadow_map, shadow_coord.xy, shadow_coord.z);
+	vec3 texcoord = vec3(shadow_coord.xy, float(cascade));
+	if (shadow_filter == 1) {
+		return sample_exponential_variance_shadow(shadow_map, texcoord, shadow_coord.z);
+	}
+	return sample_variance_shadow(shadow_map, texcoord, shadow_coord.z);
+}
+
+int select_cascade(vec3 p) {
+	float view_depth = -(view * vec4(p, 1.0)).z;
+	for (int i = 0; i < cascade_count; ++i) {
+		if (view_depth <= cascade_splits[i]) {
+			return i;
+		}
+	}
+	return cascade_count;
 }
 
 void main() {
-    float depth = 2.0 * texture(depth_texture, gl_FragCoord.xy / resolution).x - 1.0;
+    vec2 texcoord = gl_FragCoord.xy / g_buffer_size;
+    float depth = 2.0 * texture(depth_texture, texcoord).x - 1.0;
     vec3 clip_space;
     clip_space.xy = 2.0 * gl_FragCoord.xy / resolution - 1.0;
     clip_space.z = depth;
@@ -62,18 +121,19 @@ void main() {
     vec3 p = world_space.xyz / world_space.w;
 
 	float shadow_amount = 1.0;
-	if (shadow_casting) {
+	int cascade = select_cascade(p);
+	if (shadow_casting && cascade < cascade_count) {
 	    mat4 bias = mat4(0.5);
 	    bias[3] = vec4(0.5, 0.5, 0.5, 1.0);
-	    vec4 position_shadow = bias * shadow_projection * vec4(p, 1.0);
-	    shadow_amount = calculate_shadow_amount(shadow_texture, position_shadow);
+	    vec4 position_shadow = bias * shadow_projections[cascade] * vec4(p, 1.0);
+	    shadow_amount = calculate_shadow_amount(shadow_texture, position_shadow, cascade);
 	}
 
-    vec3 N = normalize(texture(normal_texture, gl_FragCoord.xy / resolution).xyz);
+    vec3 N = read_normal(texcoord);
     vec3 V = normalize(view_vector - p);
-    vec3 diffuse_color = texture(albedo_texture, gl_FragCoord.xy / resolution).rgb;
-    vec3 spec_color = texture(specular_texture, gl_FragCoord.xy / resolution).rrr;
-    float emission = texture(specular_texture, gl_FragCoord.xy / resolution).g;
+    vec3 diffuse_color = texture(albedo_texture, texcoord).rgb;
+    vec3 spec_color = texture(specular_texture, texcoord).rrr;
+    float emission = texture(specular_texture, texcoord).g;
 
     vec3 L = normalize(directional_light_direction);
 
@@ -2,7 +2,8 @@
 
 in vec2 texcoord_;
 
-uniform sampler2D shadow_texture;
+uniform sampler2DArray shadow_texture;
+uniform float layer;
 uniform vec2 blur_scale;
 
 out vec4 frag_color;
@@ -10,13 +11,13 @@ out vec4 frag_color;
 void main() {
     vec4 color = vec4(0.0);
 
-    color += texture(shadow_texture, texcoord_ + (vec2(-3.0) * blur_scale.xy)) * (1.0 / 64.0);
-    color += texture(shadow_texture, texcoord_ + (vec2(-2.0) * blur_scale.xy)) * (6.0 / 64.0);
-    color += texture(shadow_texture, texcoord_ + (vec2(-1.0) * blur_scale.xy)) * (15.0 / 64.0);
-    color += texture(shadow_texture, texcoord_ + (vec2(0.0) * blur_scale.xy)) * (20.0 / 64.0);
-    color += texture(shadow_texture, texcoord_ + (vec2(1.0) * blur_scale.xy)) * (15.0 / 64.0);
-    color += texture(shadow_texture, texcoord_ + (vec2(2.0) * blur_scale.xy)) * (6.0 / 64.0);
-    color += texture(shadow_texture, texcoord_ + (vec2(3.0) * blur_scale.xy)) * (1.0 / 64.0);
+    color += texture(shadow_texture, vec3(texcoord_ + (vec2(-3.0) * blur_scale.xy), layer)) * (1.0 / 64.0);
+    color += texture(shadow_texture, vec3(texcoord_ + (vec2(-2.0) * blur_scale.xy), layer)) * (6.0 / 64.0);
+    color += texture(shadow_texture, vec3(texcoord_ + (vec2(-1.0) * blur_scale.xy), layer)) * (15.0 / 64.0);
+    color += texture(shadow_texture, vec3(texcoord_ + (vec2(0.0) * blur_scale.xy), layer)) * (20.0 / 64.0);
+    color += texture(shadow_texture, vec3(texcoord_ + (vec2(1.0) * blur_scale.xy), layer)) * (15.0 / 64.0);
+    color += texture(shadow_texture, vec3(texcoord_ + (vec2(2.0) * blur_scale.xy), layer)) * (6.0 / 64.0);
+    color += texture(shadow_texture, vec3(texcoord_ + (vec2(3.0) * blur_scale.xy), layer)) * (1.0 / 64.0);
 
     frag_color = color;
 }
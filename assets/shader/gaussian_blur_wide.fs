@@ -0,0 +1,24 @@
+#version 330
+
+in vec2 texcoord_;
+
+uniform sampler2DArray shadow_texture;
+uniform float layer;
+uniform vec2 blur_scale;
+
+out vec4 frag_color;
+
+// 9 tap gaussian in 5 fetches, the outer taps sample between two texels with linear filtering
+const float offsets[3] = float[](0.0, 1.3846153846, 3.2307692308);
+const float weights[3] = float[](0.2270270270, 0.3162162162, 0.0702702703);
+
+void main() {
+    vec4 color = texture(shadow_texture, vec3(texcoord_, layer)) * weights[0];
+
+    for (int i = 1; i < 3; ++i) {
+        color += texture(shadow_texture, vec3(texcoord_ + offsets[i] * blur_scale, layer)) * weights[i];
+        color += texture(shadow_texture, vec3(texcoord_ - offsets[i] * blur_scale, layer)) * weights[i];
+    }
+
+    frag_color = color;
+}
@@ -5,9 +5,20 @@ out vec4 normal_color;
 out vec4 material_color;
 
 uniform vec3 color;
+uniform bool octahedral_normals;
+
+// the normal target stores normals octahedral encoded in two unsigned channels when octahedral_normals is set
+vec2 encode_octahedral(vec3 n) {
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    if (n.z < 0.0) {
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    }
+    return n.xy * 0.5 + 0.5;
+}
 
 void main() {
     albedo_color = vec4(color * 2, 1.0);
-    normal_color = vec4(0.33333, 0.33333 , 0.33333, 1.0);
+    vec3 normal = vec3(0.33333, 0.33333, 0.33333);
+    normal_color = vec4(octahedral_normals ? vec3(encode_octahedral(normal), 0.0) : normal, 1.0);
     material_color = vec4(1.0, 1.0, 0.0, 1.0);
 }
@@ -1,9 +1,6 @@
 #version 140
 
-flat in vec3 point_light_position;
-flat in vec3 point_light_color;
-flat in float point_light_radius;
-flat in float point_light_exponent;
+in vec2 texcoord_;
 
 out vec4 frag_color;
 
@@ -11,9 +8,33 @@ uniform sampler2D albedo_texture;
 uniform sampler2D normal_texture;
 uniform sampler2D specular_texture;
 uniform sampler2D depth_texture;
+uniform bool octahedral_normals;
+uniform samplerBuffer light_texture;
+uniform usamplerBuffer cluster_texture;
+uniform usamplerBuffer light_index_texture;
 uniform mat4 inv_view_projection;
+uniform mat4 view;
 uniform vec3 view_vector;
 uniform vec2 resolution;
+// the g-buffer is larger than the rendered viewport with dynamic resolution
+uniform vec2 g_buffer_size;
+uniform ivec3 cluster_dimensions;
+uniform float cluster_near_plane;
+uniform float cluster_depth_scale;
+
+vec3 decode_octahedral(vec2 e) {
+	e = 2.0 * e - 1.0;
+	vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	float t = max(-n.z, 0.0);
+	n.x += n.x >= 0.0 ? -t : t;
+	n.y += n.y >= 0.0 ? -t : t;
+	return n;
+}
+
+vec3 read_normal(vec2 texcoord) {
+	vec4 normal = texture(normal_texture, texcoord);
+	return normalize(octahedral_normals ? decode_octahedral(normal.xy) : normal.xyz);
+}
 
 vec3 blinn_phong(vec3 N, vec3 L, vec3 V, vec3 light_color, vec3 diff_color, vec3 spec_color, float shininess) {
 	vec3 H = normalize(L + V);
@@ -24,32 +45,50 @@ vec3 blinn_phong(vec3 N, vec3 L, vec3 V, vec3 light_color, vec3 diff_color, vec3
 	return light_color * diff_color * NdotL + light_color * spec_color * pow(NdotH, shininess);
 }
 
+int find_cluster(vec2 screen_coord, vec3 p) {
+	float view_depth = -(view * vec4(p, 1.0)).z;
+	int slice = int(log(max(view_depth, cluster_near_plane) / cluster_near_plane) * cluster_depth_scale);
+	ivec3 cluster = ivec3(ivec2(screen_coord * vec2(cluster_dimensions.xy)), slice);
+	cluster = clamp(cluster, ivec3(0), cluster_dimensions - 1);
+	return (cluster.z * cluster_dimensions.y + cluster.y) * cluster_dimensions.x + cluster.x;
+}
+
 void main() {
-    float depth = 2.0 * texture(depth_texture, gl_FragCoord.xy / resolution).x - 1.0;
+    vec2 screen_coord = gl_FragCoord.xy / resolution;
+    vec2 texcoord = gl_FragCoord.xy / g_buffer_size;
+    float depth = 2.0 * texture(depth_texture, texcoord).x - 1.0;
     vec3 clip_space;
-    clip_space.xy = 2.0 * gl_FragCoord.xy / resolution - 1.0;
+    clip_space.xy = 2.0 * screen_coord - 1.0;
     clip_space.z = depth;
     vec4 world_space = inv_view_projection *  vec4(clip_space,1.0);
     vec3 p = world_space.xyz / world_space.w;
 
-    vec3 N = normalize(texture(normal_texture, gl_FragCoord.xy / resolution).xyz);
+    vec3 N = read_normal(texcoord);
     vec3 V = normalize(view_vector - p);
-    vec3 diffuse_color = texture(albedo_texture, gl_FragCoord.xy / resolution).rgb;
-    vec3 spec_color = texture(specular_texture, gl_FragCoord.xy / resolution).rrr;
-    float emission = texture(specular_texture, gl_FragCoord.xy / resolution).g;
+    vec3 diffuse_color = texture(albedo_texture, texcoord).rgb;
+    vec3 spec_color = texture(specular_texture, texcoord).rrr;
+    float emission = texture(specular_texture, texcoord).g;
 
-    vec3 L = point_light_position - p;
+    uvec2 cluster = texelFetch(cluster_texture, find_cluster(screen_coord, p)).xy;
+    if (cluster.y == 0u) {
+        discard;
+    }
 
-	float d = length(L);
-	float r = point_light_radius;
-	if (d <= r) {
-		float attenuation = 1.0 - (pow(d / r, point_light_exponent));
+    vec3 final_color = vec3(0.0);
+    for (uint i = 0u; i < cluster.y; ++i) {
+        int light = int(texelFetch(light_index_texture, int(cluster.x + i)).x);
+        vec4 position_radius = texelFetch(light_texture, 2 * light);
+        vec4 color_exponent = texelFetch(light_texture, 2 * light + 1);
 
-		L = normalize(L);
-		vec3 final_color = blinn_phong(N, L, V, point_light_color, diffuse_color, spec_color, 50) * attenuation;
+        vec3 L = position_radius.xyz - p;
+        float d = length(L);
+        float r = position_radius.w;
+        if (d <= r) {
+            float attenuation = 1.0 - (pow(d / r, color_exponent.w));
+            final_color += blinn_phong(N, normalize(L), V, color_exponent.rgb, diffuse_color, spec_color, 50)
+                * attenuation;
+        }
+    }
 
-		frag_color = vec4(mix(final_color, vec3(0.f, 0.f, 0.f), emission), 1.0);
-	} else {
-		discard;
-	}
+    frag_color = vec4(mix(final_color, vec3(0.f, 0.f, 0.f), emission), 1.0);
 }
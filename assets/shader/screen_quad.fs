@@ -8,13 +8,16 @@ uniform sampler2D color_texture;
 uniform bool linearize;
 uniform float near_plane;
 uniform float far_plane;
+// the part of the texture that is shown
+uniform vec2 texcoord_scale;
+uniform vec2 texcoord_max;
 
 float linearize_depth(float depth) {
 	return (2.f * near_plane) / (far_plane + near_plane - depth * (far_plane - near_plane));
 }
 
 void main() {
-	vec4 color = texture(color_texture, texcoord_);
+	vec4 color = texture(color_texture, min(texcoord_ * texcoord_scale, texcoord_max));
 	if (linearize == true) {
 		float z_linear = linearize_depth(color.r);
 		color = vec4(z_linear, z_linear, z_linear, 1.0);
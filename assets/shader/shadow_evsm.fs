@@ -0,0 +1,15 @@
+#version 330
+
+const float positive_exponent = 5.0;
+const float negative_exponent = 5.0;
+
+out vec4 frag_color;
+
+void main() {
+    float depth = 2.0 * gl_FragCoord.z - 1.0;
+
+    float positive = exp(positive_exponent * depth);
+    float negative = -exp(-negative_exponent * depth);
+
+    frag_color = vec4(positive, positive * positive, negative, negative * negative);
+}
@@ -0,0 +1,52 @@
+#version 330
+
+in vec3 _position;
+in vec2 _texcoord;
+in vec3 _normal;
+in vec3 _tangent;
+in ivec4 _index;
+in vec4 _weight;
+
+out vec3 skinned_position;
+out vec2 skinned_texcoord;
+out vec2 skinned_normal;
+out vec2 skinned_tangent;
+
+// four texels per bone matrix, the palette of this mesh starts at bone pose_offset
+uniform samplerBuffer pose_texture;
+uniform int pose_offset;
+
+mat4 bone(int index) {
+    int texel = 4 * (pose_offset + index);
+    return mat4(texelFetch(pose_texture, texel),
+        texelFetch(pose_texture, texel + 1),
+        texelFetch(pose_texture, texel + 2),
+        texelFetch(pose_texture, texel + 3));
+}
+
+// the skinned normals and tangents are stored octahedral encoded, like the ones of static meshes
+vec2 encode_octahedral(vec3 n) {
+    float l = abs(n.x) + abs(n.y) + abs(n.z);
+    if (l == 0.0) {
+        return vec2(0.0);
+    }
+    n /= l;
+    if (n.z >= 0.0) {
+        return n.xy;
+    }
+    return (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+}
+
+void main() {
+    mat4 skin = mat4(0.0);
+    for (int i = 0; i < 4; ++i) {
+        skin += _weight[i] * bone(_index[i]);
+    }
+
+    skinned_position = (skin * vec4(_position, 1.0)).xyz;
+    skinned_texcoord = _texcoord;
+    skinned_normal = encode_octahedral((skin * vec4(_normal, 0.0)).xyz);
+    skinned_tangent = encode_octahedral((skin * vec4(_tangent, 0.0)).xyz);
+
+    gl_Position = vec4(0.0, 0.0, 0.0, 1.0);
+}
@@ -9,20 +9,32 @@ out vec4 albedo_color;
 out vec3 normal_color;
 out vec4 specular_color;
 
-uniform sampler2D color_texture;
-uniform sampler2D specular_texture;
-uniform sampler2D normal_texture;
+// the layers of the diffuse, material and normal textures are picked by the material of the draw
+uniform sampler2DArray color_texture;
+uniform sampler2DArray specular_texture;
+uniform sampler2DArray normal_texture;
 uniform vec3 view_vector;
 uniform float disp_map_scale;
 uniform float disp_map_bias;
-uniform bool parallax_mapping;
+uniform bool octahedral_normals;
+flat in int parallax_mapping_;
+flat in ivec3 layers_;
 
-vec3 calc_normal(sampler2D normal_map, vec2 texcoord, mat3 tbn) {
+vec3 calc_normal(sampler2DArray normal_map, vec3 texcoord, mat3 tbn) {
 	vec3 normal = normalize(2.0 * texture(normal_map, texcoord).xyz - vec3(1.0, 1.0, 1.0));
 	normal = normalize(tbn * normal);
 	return normal;
 }
 
+// the normal target stores normals octahedral encoded in two unsigned channels when octahedral_normals is set
+vec2 encode_octahedral(vec3 n) {
+	n /= abs(n.x) + abs(n.y) + abs(n.z);
+	if (n.z < 0.0) {
+		n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+	}
+	return n.xy * 0.5 + 0.5;
+}
+
 void main() {
 	vec3 normal = normalize(normal_);
 	vec3 tangent = normalize(tangent_);
@@ -34,12 +46,13 @@ void main() {
 
 	vec2 texcoord = texcoord_;
 
-	if (parallax_mapping) {
-		texcoord = texcoord_ + (tbn * direction_to_view).xy * (texture(specular_texture, texcoord_).b
-			* disp_map_scale + disp_map_bias);
+	if (parallax_mapping_ != 0) {
+		texcoord = texcoord_ + (tbn * direction_to_view).xy * (texture(specular_texture,
+			vec3(texcoord_, layers_.y)).b * disp_map_scale + disp_map_bias);
 	}
 
-    normal_color = calc_normal(normal_texture, texcoord, tbn);
-    albedo_color = texture(color_texture, texcoord);
-    specular_color = vec4(texture(specular_texture, texcoord).rg, 0.0, 1.0);
+    normal = calc_normal(normal_texture, vec3(texcoord, layers_.z), tbn);
+    normal_color = octahedral_normals ? vec3(encode_octahedral(normal), 0.0) : normal;
+    albedo_color = texture(color_texture, vec3(texcoord, layers_.x));
+    specular_color = vec4(texture(specular_texture, vec3(texcoord, layers_.y)).rg, 0.0, 1.0);
 }
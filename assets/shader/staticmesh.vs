@@ -1,23 +1,50 @@
 #version 330
 
 in vec3 _position;
-in vec3 _normal;
-in vec3 _tangent;
+in vec2 _normal;
+in vec2 _tangent;
 in vec2 _texcoord;
+in float _draw_id;
 
 out vec2 texcoord_;
 out vec3 normal_;
 out vec3 tangent_;
 out vec3 world_pos_;
+flat out int parallax_mapping_;
+flat out ivec3 layers_;
 
-uniform mat4 m;
-uniform mat4 mit;
-uniform mat4 mvp;
+// seven texels per draw, the model matrix and the columns of the inverse transposed model matrix. the w of
+// the first column is 1 for meshes with parallax mapping.
+uniform samplerBuffer draw_data;
+// the index of the draw data and the material id of every draw, which the draw id addresses
+uniform isamplerBuffer draw_records;
+// the diffuse, material and normal layer of every material
+uniform isamplerBuffer material_table;
+uniform int draw_offset;
+uniform mat4 projection_view;
+
+// normals and tangents are octahedral encoded
+vec3 decode_octahedral(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
 
 void main() {
+    ivec2 record = texelFetch(draw_records, draw_offset + int(_draw_id)).xy;
+    int texel = 7 * record.x;
+    mat4 m = mat4(texelFetch(draw_data, texel), texelFetch(draw_data, texel + 1),
+        texelFetch(draw_data, texel + 2), texelFetch(draw_data, texel + 3));
+    vec4 mit0 = texelFetch(draw_data, texel + 4);
+    mat3 mit = mat3(mit0.xyz, texelFetch(draw_data, texel + 5).xyz, texelFetch(draw_data, texel + 6).xyz);
+
     texcoord_ = _texcoord;
-    normal_ = (mit * vec4(_normal, 0.0)).xyz;
-    tangent_ = (mit * vec4(_tangent, 0.0)).xyz;
+    normal_ = mit * decode_octahedral(_normal);
+    tangent_ = mit * decode_octahedral(_tangent);
     world_pos_ = (m * vec4(_position, 1.0)).xyz;
-    gl_Position = mvp * vec4(_position, 1.0);
+    parallax_mapping_ = int(mit0.w);
+    layers_ = texelFetch(material_table, record.y).xyz;
+    gl_Position = projection_view * vec4(world_pos_, 1.0);
 }
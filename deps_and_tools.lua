@@ -72,6 +72,26 @@ solution "deps_and_tools"
                 links "c++"
             end
 
+    project "texture_benchmark"
+        kind "ConsoleApp"
+	targetdir "texture_benchmark/"
+        location "texture_benchmark"
+
+        buildoptions "-std=c++1y"
+
+        includedirs "src/include"
+
+        files "texture_benchmark/src/**.cpp"
+
+        defines "GLM_FORCE_RADIANS"
+
+        configuration {"gmake", "linux"}
+            if _OPTIONS["cc"] == "clang" then
+                toolset "clang"
+                buildoptions "-stdlib=libc++"
+                links "c++"
+            end
+
     project "bullet3"
         kind "StaticLib"
 	targetdir "deps/bullet3"
@@ -1,9 +1,13 @@
 #ifndef __DEVTOOLS_MESH_CONVERTER_HPP__
 #define __DEVTOOLS_MESH_CONVERTER_HPP__
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <string>
 
 #include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
 #include <json/json.h>
 
 namespace devtools {
@@ -15,6 +19,114 @@ namespace devtools {
         bool parallax_mapping = true;
     };
 
+    // version 2 of the mesh format. static meshes store a position stream, a stream of packed_attributes,
+    // the indices with index_size bytes each and the submeshes. skinned meshes keep the interleaved float
+    // vertex and skin attributes of version 1 in place of the two streams.
+    //
+    // version 3 appends lod_count lods behind the submeshes. lod_count is only valid from version 3 on,
+    // older files have a single level of detail.
+    struct packed_header {
+        const uint32_t magic = 0x32424D5A;
+        uint32_t version = 3;
+        uint64_t vertex_count = 0;
+        uint64_t index_count = 0;
+        uint64_t submesh_count = 0;
+        uint32_t vertex_format = 0;
+        uint32_t index_size = sizeof(uint32_t);
+        bool parallax_mapping = true;
+        uint32_t lod_count = 1;
+    };
+
+    // a level of detail is a range of submeshes, whose indices are stored contiguously. all levels index the
+    // same vertices. error is the distance in model units by which the level deviates from the full mesh.
+    struct lod {
+        uint64_t first_submesh = 0;
+        uint64_t submesh_count = 0;
+        float error = 0.f;
+    };
+
+    // bits of packed_header::vertex_format. positions are three floats unless half_positions is set, in which
+    // case they are four halfs. texcoords are halfs unless unorm_texcoords is set.
+    enum vertex_format_bits : uint32_t {
+        half_positions = 1,
+        unorm_texcoords = 2
+    };
+
+    // normal and tangent are octahedral encoded unit vectors
+    struct packed_attributes {
+        uint16_t texcoord[2];
+        int16_t normal[2];
+        int16_t tangent[2];
+    };
+
+    inline glm::vec2 encode_octahedral(glm::vec3 n) noexcept {
+        auto length = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+        if (length == 0.f) {
+            return glm::vec2{0.f};
+        }
+        n /= length;
+        if (n.z >= 0.f) {
+            return glm::vec2{n.x, n.y};
+        }
+        return glm::vec2{(1.f - std::abs(n.y)) * (n.x >= 0.f ? 1.f : -1.f),
+            (1.f - std::abs(n.x)) * (n.y >= 0.f ? 1.f : -1.f)};
+    }
+
+    inline int16_t pack_snorm16(float value) noexcept {
+        return static_cast<int16_t>(std::round(glm::clamp(value, -1.f, 1.f) * 32767.f));
+    }
+
+    inline uint16_t pack_unorm16(float value) noexcept {
+        return static_cast<uint16_t>(std::round(glm::clamp(value, 0.f, 1.f) * 65535.f));
+    }
+
+    inline bool fits_unorm(const glm::vec2& texcoord) noexcept {
+        return texcoord.x >= 0.f && texcoord.x <= 1.f && texcoord.y >= 0.f && texcoord.y <= 1.f;
+    }
+
+    inline packed_attributes pack_attributes(const glm::vec2& texcoord, const glm::vec3& normal,
+    const glm::vec3& tangent, bool unorm_texcoords) noexcept {
+        auto attributes = packed_attributes{};
+        for (auto i = 0; i < 2; ++i) {
+            attributes.texcoord[i] = unorm_texcoords ? pack_unorm16(texcoord[i]) : glm::packHalf1x16(texcoord[i]);
+        }
+        auto n = encode_octahedral(normal);
+        auto t = encode_octahedral(tangent);
+        for (auto i = 0; i < 2; ++i) {
+            attributes.normal[i] = pack_snorm16(n[i]);
+            attributes.tangent[i] = pack_snorm16(t[i]);
+        }
+        return attributes;
+    }
+
+    inline glm::vec3 decode_octahedral(const glm::vec2& e) noexcept {
+        auto n = glm::vec3{e, 1.f - std::abs(e.x) - std::abs(e.y)};
+        auto t = std::max(-n.z, 0.f);
+        n.x += n.x >= 0.f ? -t : t;
+        n.y += n.y >= 0.f ? -t : t;
+        return glm::normalize(n);
+    }
+
+    inline float unpack_snorm16(int16_t value) noexcept {
+        return glm::clamp(value / 32767.f, -1.f, 1.f);
+    }
+
+    inline float unpack_unorm16(uint16_t value) noexcept {
+        return value / 65535.f;
+    }
+
+    // the inverse of pack_attributes, up to the precision of the packed formats
+    inline void unpack_attributes(const packed_attributes& attributes, bool unorm_texcoords, glm::vec2& texcoord,
+    glm::vec3& normal, glm::vec3& tangent) noexcept {
+        for (auto i = 0; i < 2; ++i) {
+            texcoord[i] = unorm_texcoords ? unpack_unorm16(attributes.texcoord[i])
+                : glm::unpackHalf1x16(attributes.texcoord[i]);
+        }
+        normal = decode_octahedral(glm::vec2{unpack_snorm16(attributes.normal[0]), unpack_snorm16(attributes.normal[1])});
+        tangent = decode_octahedral(glm::vec2{unpack_snorm16(attributes.tangent[0]),
+            unpack_snorm16(attributes.tangent[1])});
+    }
+
     struct collision_header {
         const uint32_t magic = 0x3142435A;
         uint64_t vertex_count = 0;
@@ -57,7 +169,12 @@ namespace devtools {
         mesh_converter(mesh_converter&& rhs) = delete;
         mesh_converter& operator=(mesh_converter&& rhs) = delete;
 
-        void run(bool collision_meshes = false);
+        // half_positions stores positions as halfs, which only pays off for small meshes near the origin.
+        // every level of detail after the first has about half the triangles of the previous one, levels
+        // are only generated as long as the simplification makes progress. overdraw sorts the triangle clusters
+        // of every submesh front to back after the vertex cache optimisation.
+        void run(bool collision_meshes = false, bool half_positions = false, size_t lod_count = 3,
+            bool overdraw = false);
     };
 }
 
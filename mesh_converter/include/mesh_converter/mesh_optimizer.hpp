@@ -0,0 +1,31 @@
+#ifndef __DEVTOOLS_MESH_OPTIMIZER_HPP__
+#define __DEVTOOLS_MESH_OPTIMIZER_HPP__
+
+#include <cstdint>
+#include <vector>
+
+#include <mesh_converter/mesh_converter.hpp>
+
+namespace devtools {
+    // average cache miss ratio, the vertices transformed per triangle with a fifo post transform cache of
+    // cache_size entries. 0.5 is the optimum for large regular meshes, 3 the worst case.
+    float acmr(const uint32_t* indices, size_t index_count, size_t cache_size = 16);
+
+    // merges vertices that are identical in position, texcoord, normal and skin. tangents are sums over the
+    // triangles of a vertex, so the tangents of merged vertices are added up. skins is empty for static meshes.
+    void weld_vertices(std::vector<vertex>& vertices, std::vector<skin>& skins, std::vector<uint32_t>& indices);
+
+    // reorders the triangles of the index range for a post transform vertex cache, following tom forsyth's
+    // linear-speed vertex cache optimisation
+    void optimize_vertex_cache(uint32_t* indices, size_t index_count, size_t vertex_count);
+
+    // splits the cache optimised triangles of the index range into clusters at cache restarts and sorts the
+    // clusters so that outward facing ones come first and occlude the rest. the triangle order inside the
+    // clusters is kept, which keeps most of the vertex cache efficiency.
+    void optimize_overdraw(uint32_t* indices, size_t index_count, const std::vector<vertex>& vertices);
+
+    // renumbers the vertices in the order of their first use in the indices and drops unused vertices
+    void optimize_vertex_fetch(std::vector<vertex>& vertices, std::vector<skin>& skins, std::vector<uint32_t>& indices);
+}
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef __DEVTOOLS_MESH_SIMPLIFIER_HPP__
+#define __DEVTOOLS_MESH_SIMPLIFIER_HPP__
+
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace devtools {
+    // quadric error edge collapse simplification. a collapse moves the vertices at one end point of an edge onto
+    // the vertices at the other end, so vertices are neither moved nor created and every level of detail can
+    // index the vertices of the full mesh.
+    //
+    // vertices with the same position are welded for the topology, so texture seams of meshes with split
+    // vertices can be collapsed along. every split vertex is moved onto the vertex on its side of the seam and
+    // a collapse without one is rejected. end points on open borders are locked.
+    class mesh_simplifier {
+        struct collapse {
+            double cost;
+            uint32_t from;
+            uint32_t to;
+            uint32_t from_version;
+            uint32_t to_version;
+
+            bool operator>(const collapse& rhs) const noexcept {
+                return cost > rhs.cost;
+            }
+        };
+
+        std::vector<glm::vec3> positions_;
+        std::vector<uint32_t> indices_;
+        std::vector<bool> removed_triangles_;
+        std::vector<std::vector<uint32_t>> vertex_triangles_;
+
+        // per welded position, indexed by the first vertex with that position
+        std::vector<uint32_t> position_ids_;
+        std::vector<std::vector<uint32_t>> position_vertices_;
+        std::vector<glm::dmat4> quadrics_;
+        std::vector<double> weights_;
+        std::vector<bool> locked_;
+        std::vector<bool> removed_positions_;
+        std::vector<uint32_t> versions_;
+
+        std::priority_queue<collapse, std::vector<collapse>, std::greater<collapse>> collapses_;
+        std::vector<uint32_t> targets_;
+        size_t triangle_count_;
+        double max_cost_;
+
+    public:
+        mesh_simplifier(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices);
+        ~mesh_simplifier() = default;
+
+        mesh_simplifier(const mesh_simplifier& rhs) = delete;
+        mesh_simplifier& operator=(const mesh_simplifier& rhs) = delete;
+
+        mesh_simplifier(mesh_simplifier&& rhs) = delete;
+        mesh_simplifier& operator=(mesh_simplifier&& rhs) = delete;
+
+        // collapses edges until at most target_triangles remain or no edge can be collapsed anymore. returns the
+        // largest error introduced so far, as a distance in model units.
+        float simplify(size_t target_triangles);
+
+        // the remaining triangles of the input triangles [first_triangle, first_triangle + triangle_count)
+        std::vector<uint32_t> indices(size_t first_triangle, size_t triangle_count) const;
+
+        auto triangle_count() const noexcept {
+            return triangle_count_;
+        }
+
+    private:
+        double cost(uint32_t from, uint32_t to) const noexcept;
+        void push_edge(uint32_t a, uint32_t b);
+        bool find_targets(uint32_t from, uint32_t to);
+        bool flips(uint32_t from, uint32_t to) const noexcept;
+        void apply(const collapse& c);
+    };
+}
+
+#endif
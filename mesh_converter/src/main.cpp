@@ -1,4 +1,6 @@
+#include <algorithm>
 #include <stdexcept>
+#include <string>
 
 #include <mesh_converter/mesh_converter.hpp>
 
@@ -7,14 +9,23 @@ int main(int argc, char const* argv[]) {
         throw std::runtime_error("too view arguments passed to mesh_converter");
     }
     devtools::mesh_converter mc(argv[1], argv[2]);
-    if (argc == 4) {
-        if (std::string{argv[3]} == "-col") {
-            mc.run(true);
+    auto collision_meshes = false;
+    auto half_positions = false;
+    auto lod_count = size_t{3};
+    auto overdraw = false;
+    for (auto i = 3; i < argc; ++i) {
+        if (std::string{argv[i]} == "-col") {
+            collision_meshes = true;
+        } else if (std::string{argv[i]} == "-half") {
+            half_positions = true;
+        } else if (std::string{argv[i]} == "-lods" && i + 1 < argc) {
+            lod_count = std::max(std::stoul(argv[++i]), 1ul);
+        } else if (std::string{argv[i]} == "-overdraw") {
+            overdraw = true;
         } else {
             throw std::runtime_error("unrecognized option");
         }
-    } else {
-        mc.run();
     }
+    mc.run(collision_meshes, half_positions, lod_count, overdraw);
     return 0;
 }
@@ -6,6 +6,8 @@
 #include <glm/gtx/string_cast.hpp>
 
 #include <mesh_converter/mesh_converter.hpp>
+#include <mesh_converter/mesh_optimizer.hpp>
+#include <mesh_converter/mesh_simplifier.hpp>
 
 namespace devtools {
     mesh_converter::mesh_converter(const std::string& input_file, const std::string& output_path) {
@@ -24,7 +26,7 @@ namespace devtools {
         file.close();
     }
 
-    void mesh_converter::run(bool collision_meshes) {
+    void mesh_converter::run(bool collision_meshes, bool half_positions, size_t lod_count, bool overdraw) {
         std::ifstream material_database("material_database.json");
         if (!material_database.is_open()) {
             std::ofstream mdb("material_database.json", std::ios::trunc);
@@ -278,11 +280,76 @@ namespace devtools {
             mdb_write << sw.write(mdb_root);
             mdb_write.close();
 
-            header h;
+            auto acmr_before = acmr(indices.data(), indices.size());
+            auto unwelded_vertex_count = vertices.size();
+            weld_vertices(vertices, skin_attributes, indices);
+
+            // the levels of detail are appended as further submeshes, which index the vertices of the full mesh
+            auto base_index_count = indices.size();
+            auto base_submesh_count = submeshes.size();
+            std::vector<lod> lods(1);
+            lods[0].submesh_count = base_submesh_count;
+            if (lod_count > 1) {
+                std::vector<glm::vec3> positions;
+                for (auto& v : vertices) {
+                    positions.emplace_back(v.position);
+                }
+                mesh_simplifier simplifier{positions, indices};
+                auto triangle_count = indices.size() / 3;
+                while (lods.size() < lod_count) {
+                    auto error = simplifier.simplify(triangle_count / 2);
+                    if (simplifier.triangle_count() == 0 || simplifier.triangle_count() > triangle_count * 4 / 5) {
+                        break;
+                    }
+                    triangle_count = simplifier.triangle_count();
+
+                    lod l;
+                    l.first_submesh = submeshes.size();
+                    l.submesh_count = base_submesh_count;
+                    l.error = error;
+                    for (auto i = size_t{0}; i < base_submesh_count; ++i) {
+                        auto sm = submeshes[i];
+                        auto lod_indices = simplifier.indices(sm.offset / 3, sm.index_count / 3);
+                        sm.offset = indices.size();
+                        sm.index_count = lod_indices.size();
+                        indices.insert(indices.end(), lod_indices.begin(), lod_indices.end());
+                        submeshes.emplace_back(sm);
+                    }
+                    lods.emplace_back(l);
+                    std::cout << mesh_name << ": lod " << lods.size() - 1 << " with " << triangle_count
+                        << " triangles, error " << error << std::endl;
+                }
+            }
+
+            // every submesh is drawn on its own, so the triangles are only reordered within the submeshes. the
+            // vertices are renumbered afterwards, which does not change the triangle order.
+            for (auto& sm : submeshes) {
+                optimize_vertex_cache(indices.data() + sm.offset, sm.index_count, vertices.size());
+                if (overdraw) {
+                    optimize_overdraw(indices.data() + sm.offset, sm.index_count, vertices);
+                }
+            }
+            optimize_vertex_fetch(vertices, skin_attributes, indices);
+            std::cout << mesh_name << ": " << unwelded_vertex_count << " -> " << vertices.size()
+                << " vertices, acmr " << acmr_before << " -> " << acmr(indices.data(), base_index_count) << std::endl;
+
+            auto skinned = skin_attributes.size() > 0;
+            auto unorm_texcoords = true;
+            for (auto& v : vertices) {
+                unorm_texcoords = unorm_texcoords && fits_unorm(v.texcoord);
+            }
+
+            packed_header h;
             h.vertex_count = vertices.size();
             h.index_count = indices.size();
             h.submesh_count = submeshes.size();
             h.parallax_mapping = parallax_mapping.asBool();
+            h.lod_count = lods.size();
+            h.index_size = vertices.size() < 65536 ? sizeof(uint16_t) : sizeof(uint32_t);
+            if (!skinned) {
+                h.vertex_format = (half_positions ? devtools::half_positions : 0)
+                    | (unorm_texcoords ? devtools::unorm_texcoords : 0);
+            }
 
             std::string output_file = output_path_ + "meshes/" + mesh_name + ".msh";
             std::ofstream output(output_file, std::ios::binary | std::ios::trunc);
@@ -290,22 +357,51 @@ namespace devtools {
                 throw std::runtime_error("could not open output file " + output_file);
             }
 
-            output.write(reinterpret_cast<char*>(&h), sizeof(header));
-            for (auto i = 0ul; i < vertices.size(); ++i) {
-                output.write(reinterpret_cast<char*>(&vertices[i]), sizeof(vertex));
-                if (skin_attributes.size() > 0) {
+            output.write(reinterpret_cast<char*>(&h), sizeof(packed_header));
+            if (skinned) {
+                for (auto i = 0ul; i < vertices.size(); ++i) {
+                    output.write(reinterpret_cast<char*>(&vertices[i]), sizeof(vertex));
                     output.write(reinterpret_cast<char*>(&skin_attributes[i]), sizeof(skin));
                 }
+            } else {
+                // the position stream comes first, so depth only passes can use it on its own
+                for (auto& v : vertices) {
+                    if (half_positions) {
+                        uint16_t position[4] = {glm::packHalf1x16(v.position.x), glm::packHalf1x16(v.position.y),
+                            glm::packHalf1x16(v.position.z), 0};
+                        output.write(reinterpret_cast<char*>(position), sizeof(position));
+                    } else {
+                        output.write(reinterpret_cast<char*>(&v.position), sizeof(glm::vec3));
+                    }
+                }
+                for (auto& v : vertices) {
+                    auto attributes = pack_attributes(v.texcoord, v.normal, v.tangent, unorm_texcoords);
+                    output.write(reinterpret_cast<char*>(&attributes), sizeof(packed_attributes));
+                }
+            }
+            if (h.index_size == sizeof(uint16_t)) {
+                std::vector<uint16_t> short_indices{indices.begin(), indices.end()};
+                output.write(reinterpret_cast<char*>(short_indices.data()), short_indices.size() * sizeof(uint16_t));
+            } else {
+                output.write(reinterpret_cast<char*>(indices.data()), indices.size() * sizeof(unsigned int));
             }
-            output.write(reinterpret_cast<char*>(indices.data()), indices.size() * sizeof(unsigned int));
             output.write(reinterpret_cast<char*>(submeshes.data()), submeshes.size() * sizeof(submesh));
+            output.write(reinterpret_cast<char*>(lods.data()), lods.size() * sizeof(lod));
+
+            // the same mesh in the version 1 layout, interleaved floats with 32 bit indices
+            auto uncompressed_size = vertices.size() * (sizeof(vertex) + (skinned ? sizeof(skin) : 0))
+                + base_index_count * sizeof(unsigned int);
+            auto compressed_size = static_cast<size_t>(output.tellp()) - sizeof(packed_header)
+                - submeshes.size() * sizeof(submesh) - lods.size() * sizeof(lod);
+            std::cout << mesh_name << ": " << uncompressed_size << " -> " << compressed_size << " bytes of vertex and index data"
+                << std::endl;
 
             output.close();
 
             if (collision_meshes) {
                 collision_header ch;
                 ch.vertex_count = vertices.size();
-                ch.index_count = indices.size();
+                ch.index_count = base_index_count;
 
                 output_file = output_path_ + "meshes/" + mesh_name + ".col";
                 output.open(output_file, std::ios::binary | std::ios::trunc);
@@ -317,7 +413,7 @@ namespace devtools {
                 for (auto i = 0ul; i < vertices.size(); ++i) {
                     output.write(reinterpret_cast<char*>(&vertices[i].position), sizeof(glm::vec3));
                 }
-                output.write(reinterpret_cast<char*>(indices.data()), indices.size() * sizeof(unsigned int));
+                output.write(reinterpret_cast<char*>(indices.data()), base_index_count * sizeof(unsigned int));
 
                 output.close();
             }
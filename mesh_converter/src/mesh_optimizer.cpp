@@ -0,0 +1,293 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <unordered_map>
+
+#include <mesh_converter/mesh_optimizer.hpp>
+
+namespace devtools {
+    namespace {
+        // scoring constants of forsyth's paper
+        const int cache_size = 32;
+        const float cache_decay_power = 1.5f;
+        const float last_triangle_score = 0.75f;
+        const float valence_boost_scale = 2.f;
+        const float valence_boost_power = 0.5f;
+
+        float vertex_score(int cache_position, uint32_t remaining_triangles) {
+            if (remaining_triangles == 0) {
+                return -1.f;
+            }
+            auto score = 0.f;
+            if (cache_position >= 0) {
+                if (cache_position < 3) {
+                    score = last_triangle_score;
+                } else {
+                    auto scale = 1.f / (cache_size - 3);
+                    score = std::pow(1.f - (cache_position - 3) * scale, cache_decay_power);
+                }
+            }
+            return score + valence_boost_scale * std::pow(static_cast<float>(remaining_triangles), -valence_boost_power);
+        }
+    }
+
+    float acmr(const uint32_t* indices, size_t index_count, size_t cache_size) {
+        if (index_count < 3) {
+            return 0.f;
+        }
+        std::deque<uint32_t> cache;
+        auto misses = size_t{0};
+        for (auto i = size_t{0}; i < index_count; ++i) {
+            if (std::find(cache.begin(), cache.end(), indices[i]) == cache.end()) {
+                ++misses;
+                cache.push_back(indices[i]);
+                if (cache.size() > cache_size) {
+                    cache.pop_front();
+                }
+            }
+        }
+        return static_cast<float>(misses) / (index_count / 3);
+    }
+
+    void weld_vertices(std::vector<vertex>& vertices, std::vector<skin>& skins, std::vector<uint32_t>& indices) {
+        auto skinned = !skins.empty();
+        auto key_size = sizeof(glm::vec3) + sizeof(glm::vec2) + sizeof(glm::vec3) + (skinned ? sizeof(skin) : 0);
+
+        std::unordered_map<std::string, uint32_t> unique_vertices;
+        std::vector<uint32_t> remap(vertices.size());
+        std::vector<vertex> welded_vertices;
+        std::vector<skin> welded_skins;
+        for (auto i = size_t{0}; i < vertices.size(); ++i) {
+            auto& v = vertices[i];
+            auto key = std::string(key_size, '\0');
+            auto offset = size_t{0};
+            std::memcpy(&key[offset], &v.position, sizeof(glm::vec3));
+            offset += sizeof(glm::vec3);
+            std::memcpy(&key[offset], &v.texcoord, sizeof(glm::vec2));
+            offset += sizeof(glm::vec2);
+            std::memcpy(&key[offset], &v.normal, sizeof(glm::vec3));
+            offset += sizeof(glm::vec3);
+            if (skinned) {
+                std::memcpy(&key[offset], &skins[i], sizeof(skin));
+            }
+
+            auto entry = unique_vertices.emplace(key, static_cast<uint32_t>(welded_vertices.size()));
+            if (entry.second) {
+                welded_vertices.emplace_back(v);
+                if (skinned) {
+                    welded_skins.emplace_back(skins[i]);
+                }
+            } else {
+                welded_vertices[entry.first->second].tangent += v.tangent;
+            }
+            remap[i] = entry.first->second;
+        }
+
+        for (auto& index : indices) {
+            index = remap[index];
+        }
+        vertices.swap(welded_vertices);
+        skins.swap(welded_skins);
+    }
+
+    void optimize_vertex_cache(uint32_t* indices, size_t index_count, size_t vertex_count) {
+        auto triangle_count = index_count / 3;
+        if (triangle_count == 0) {
+            return;
+        }
+
+        // the not yet emitted triangles of a vertex are kept at the front of its adjacency range
+        std::vector<uint32_t> remaining(vertex_count, 0);
+        for (auto i = size_t{0}; i < index_count; ++i) {
+            ++remaining[indices[i]];
+        }
+        std::vector<uint32_t> offsets(vertex_count + 1, 0);
+        for (auto v = size_t{0}; v < vertex_count; ++v) {
+            offsets[v + 1] = offsets[v] + remaining[v];
+        }
+        std::vector<uint32_t> adjacency(index_count);
+        std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+        for (auto t = size_t{0}; t < triangle_count; ++t) {
+            for (auto k = 0; k < 3; ++k) {
+                adjacency[fill[indices[3 * t + k]]++] = t;
+            }
+        }
+
+        std::vector<int> cache_positions(vertex_count, -1);
+        std::vector<float> vertex_scores(vertex_count);
+        for (auto v = size_t{0}; v < vertex_count; ++v) {
+            vertex_scores[v] = vertex_score(-1, remaining[v]);
+        }
+        std::vector<float> triangle_scores(triangle_count);
+        for (auto t = size_t{0}; t < triangle_count; ++t) {
+            triangle_scores[t] = vertex_scores[indices[3 * t]] + vertex_scores[indices[3 * t + 1]]
+                + vertex_scores[indices[3 * t + 2]];
+        }
+
+        std::vector<bool> emitted(triangle_count, false);
+        std::vector<uint32_t> output;
+        output.reserve(index_count);
+        std::vector<uint32_t> cache;
+        std::vector<uint32_t> next_cache;
+        auto scan = size_t{0};
+
+        while (output.size() < index_count) {
+            auto best = triangle_count;
+            auto best_score = -1.f;
+            for (auto v : cache) {
+                for (auto i = offsets[v]; i < offsets[v] + remaining[v]; ++i) {
+                    auto t = adjacency[i];
+                    if (triangle_scores[t] > best_score) {
+                        best = t;
+                        best_score = triangle_scores[t];
+                    }
+                }
+            }
+            // nothing left next to the cache, continue with the next triangle in input order
+            if (best == triangle_count) {
+                while (emitted[scan]) {
+                    ++scan;
+                }
+                best = scan;
+            }
+
+            emitted[best] = true;
+            auto triangle = &indices[3 * best];
+            output.insert(output.end(), triangle, triangle + 3);
+            for (auto k = 0; k < 3; ++k) {
+                auto v = triangle[k];
+                auto begin = adjacency.begin() + offsets[v];
+                auto end = begin + remaining[v];
+                std::iter_swap(std::find(begin, end, best), end - 1);
+                --remaining[v];
+            }
+
+            next_cache.assign(triangle, triangle + 3);
+            for (auto v : cache) {
+                if (v != triangle[0] && v != triangle[1] && v != triangle[2]) {
+                    next_cache.emplace_back(v);
+                }
+            }
+            for (auto i = size_t{0}; i < next_cache.size(); ++i) {
+                auto v = next_cache[i];
+                cache_positions[v] = i < cache_size ? static_cast<int>(i) : -1;
+                vertex_scores[v] = vertex_score(cache_positions[v], remaining[v]);
+            }
+            for (auto v : next_cache) {
+                for (auto i = offsets[v]; i < offsets[v] + remaining[v]; ++i) {
+                    auto t = adjacency[i];
+                    triangle_scores[t] = vertex_scores[indices[3 * t]] + vertex_scores[indices[3 * t + 1]]
+                        + vertex_scores[indices[3 * t + 2]];
+                }
+            }
+            if (next_cache.size() > cache_size) {
+                next_cache.resize(cache_size);
+            }
+            cache.swap(next_cache);
+        }
+
+        std::copy(output.begin(), output.end(), indices);
+    }
+
+    void optimize_overdraw(uint32_t* indices, size_t index_count, const std::vector<vertex>& vertices) {
+        const auto fifo_size = size_t{16};
+        const auto min_cluster_triangles = size_t{16};
+
+        auto triangle_count = index_count / 3;
+        if (triangle_count == 0) {
+            return;
+        }
+
+        // a triangle whose vertices all miss the cache starts a new cluster
+        std::vector<size_t> cluster_starts{0};
+        std::deque<uint32_t> cache;
+        for (auto t = size_t{0}; t < triangle_count; ++t) {
+            auto misses = 0;
+            for (auto k = 0; k < 3; ++k) {
+                auto v = indices[3 * t + k];
+                if (std::find(cache.begin(), cache.end(), v) == cache.end()) {
+                    ++misses;
+                    cache.push_back(v);
+                    if (cache.size() > fifo_size) {
+                        cache.pop_front();
+                    }
+                }
+            }
+            if (misses == 3 && t - cluster_starts.back() >= min_cluster_triangles) {
+                cluster_starts.emplace_back(t);
+            }
+        }
+        cluster_starts.emplace_back(triangle_count);
+
+        auto mesh_center = glm::vec3{0.f};
+        for (auto i = size_t{0}; i < index_count; ++i) {
+            mesh_center += vertices[indices[i]].position;
+        }
+        mesh_center /= static_cast<float>(index_count);
+
+        struct cluster {
+            size_t first_triangle;
+            size_t triangle_count;
+            float sort_key;
+        };
+        std::vector<cluster> clusters;
+        for (auto c = size_t{0}; c + 1 < cluster_starts.size(); ++c) {
+            auto center = glm::vec3{0.f};
+            auto normal = glm::vec3{0.f};
+            auto area = 0.f;
+            for (auto t = cluster_starts[c]; t < cluster_starts[c + 1]; ++t) {
+                auto& p0 = vertices[indices[3 * t]].position;
+                auto& p1 = vertices[indices[3 * t + 1]].position;
+                auto& p2 = vertices[indices[3 * t + 2]].position;
+                auto n = glm::cross(p1 - p0, p2 - p0);
+                auto a = glm::length(n);
+                center += (p0 + p1 + p2) * (a / 3.f);
+                normal += n;
+                area += a;
+            }
+            auto key = 0.f;
+            if (area > 0.f && glm::length(normal) > 0.f) {
+                key = glm::dot(center / area - mesh_center, glm::normalize(normal));
+            }
+            clusters.emplace_back(cluster{cluster_starts[c], cluster_starts[c + 1] - cluster_starts[c], key});
+        }
+        std::stable_sort(clusters.begin(), clusters.end(), [](const cluster& lhs, const cluster& rhs) {
+            return lhs.sort_key > rhs.sort_key;
+        });
+
+        std::vector<uint32_t> output;
+        output.reserve(index_count);
+        for (auto& c : clusters) {
+            output.insert(output.end(), indices + 3 * c.first_triangle, indices + 3 * (c.first_triangle + c.triangle_count));
+        }
+        std::copy(output.begin(), output.end(), indices);
+    }
+
+    void optimize_vertex_fetch(std::vector<vertex>& vertices, std::vector<skin>& skins, std::vector<uint32_t>& indices) {
+        const auto unused = ~uint32_t{0};
+        std::vector<uint32_t> remap(vertices.size(), unused);
+        auto next = uint32_t{0};
+        for (auto& index : indices) {
+            if (remap[index] == unused) {
+                remap[index] = next++;
+            }
+            index = remap[index];
+        }
+
+        std::vector<vertex> ordered_vertices(next);
+        std::vector<skin> ordered_skins(skins.empty() ? 0 : next);
+        for (auto v = size_t{0}; v < vertices.size(); ++v) {
+            if (remap[v] == unused) {
+                continue;
+            }
+            ordered_vertices[remap[v]] = vertices[v];
+            if (!skins.empty()) {
+                ordered_skins[remap[v]] = skins[v];
+            }
+        }
+        vertices.swap(ordered_vertices);
+        skins.swap(ordered_skins);
+    }
+}
@@ -0,0 +1,223 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+
+#include <mesh_converter/mesh_simplifier.hpp>
+
+namespace devtools {
+    mesh_simplifier::mesh_simplifier(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices)
+    : positions_{positions}, indices_{indices}, removed_triangles_(indices.size() / 3, false),
+    vertex_triangles_(positions.size()), position_ids_(positions.size()), position_vertices_(positions.size()),
+    quadrics_(positions.size(), glm::dmat4{0.0}), weights_(positions.size(), 0.0), locked_(positions.size(), false),
+    removed_positions_(positions.size(), false), versions_(positions.size(), 0), triangle_count_{indices.size() / 3},
+    max_cost_{0.0} {
+        std::unordered_map<std::string, uint32_t> welded;
+        for (auto v = uint32_t{0}; v < positions_.size(); ++v) {
+            auto key = std::string(sizeof(glm::vec3), '\0');
+            std::memcpy(&key[0], &positions_[v], sizeof(glm::vec3));
+            auto id = welded.emplace(key, v).first->second;
+            position_ids_[v] = id;
+            position_vertices_[id].emplace_back(v);
+        }
+
+        // every position starts with the area weighted planes of its triangles, each edge between positions
+        // counts the triangles it belongs to
+        std::unordered_map<uint64_t, int> edges;
+        auto edge_key = [](uint32_t a, uint32_t b) {
+            return (static_cast<uint64_t>(std::min(a, b)) << 32) | std::max(a, b);
+        };
+        for (auto t = size_t{0}; t < triangle_count_; ++t) {
+            auto i = &indices_[3 * t];
+            auto& p0 = positions_[i[0]];
+            auto normal = glm::cross(positions_[i[1]] - p0, positions_[i[2]] - p0);
+            auto length = glm::length(normal);
+            if (length > 0.f) {
+                auto area = 0.5 * length;
+                auto plane = glm::dvec4{glm::dvec3{normal / length}, -glm::dot(normal / length, p0)};
+                auto quadric = glm::dmat4{0.0};
+                for (auto c = 0; c < 4; ++c) {
+                    quadric[c] = plane * (plane[c] * area);
+                }
+                for (auto k = 0; k < 3; ++k) {
+                    quadrics_[position_ids_[i[k]]] += quadric;
+                    weights_[position_ids_[i[k]]] += area;
+                }
+            }
+            for (auto k = 0; k < 3; ++k) {
+                vertex_triangles_[i[k]].emplace_back(t);
+                ++edges[edge_key(position_ids_[i[k]], position_ids_[i[(k + 1) % 3]])];
+            }
+        }
+
+        for (auto& edge : edges) {
+            if (edge.second != 2) {
+                locked_[edge.first >> 32] = true;
+                locked_[edge.first & 0xffffffff] = true;
+            }
+        }
+        for (auto& edge : edges) {
+            push_edge(edge.first >> 32, edge.first & 0xffffffff);
+        }
+    }
+
+    float mesh_simplifier::simplify(size_t target_triangles) {
+        while (triangle_count_ > target_triangles && !collapses_.empty()) {
+            auto c = collapses_.top();
+            collapses_.pop();
+            if (removed_positions_[c.from] || removed_positions_[c.to] || versions_[c.from] != c.from_version
+                || versions_[c.to] != c.to_version) {
+                continue;
+            }
+            if (!find_targets(c.from, c.to) || flips(c.from, c.to)) {
+                continue;
+            }
+            apply(c);
+        }
+        return static_cast<float>(std::sqrt(max_cost_));
+    }
+
+    std::vector<uint32_t> mesh_simplifier::indices(size_t first_triangle, size_t triangle_count) const {
+        std::vector<uint32_t> result;
+        for (auto t = first_triangle; t < first_triangle + triangle_count; ++t) {
+            if (!removed_triangles_[t]) {
+                result.insert(result.end(), indices_.begin() + 3 * t, indices_.begin() + 3 * t + 3);
+            }
+        }
+        return result;
+    }
+
+    double mesh_simplifier::cost(uint32_t from, uint32_t to) const noexcept {
+        // the mean squared distance to the planes, so the error does not grow with the number of planes
+        auto v = glm::dvec4{glm::dvec3{positions_[to]}, 1.0};
+        auto weight = weights_[from] + weights_[to];
+        if (weight <= 0.0) {
+            return 0.0;
+        }
+        return std::max(glm::dot(v, (quadrics_[from] + quadrics_[to]) * v), 0.0) / weight;
+    }
+
+    void mesh_simplifier::push_edge(uint32_t a, uint32_t b) {
+        if (locked_[a] && locked_[b]) {
+            return;
+        }
+        auto from = a;
+        auto to = b;
+        auto c = 0.0;
+        if (locked_[a]) {
+            std::swap(from, to);
+            c = cost(from, to);
+        } else if (locked_[b]) {
+            c = cost(from, to);
+        } else {
+            c = cost(a, b);
+            auto backward = cost(b, a);
+            if (backward < c) {
+                std::swap(from, to);
+                c = backward;
+            }
+        }
+        collapses_.emplace(collapse{c, from, to, versions_[from], versions_[to]});
+    }
+
+    bool mesh_simplifier::find_targets(uint32_t from, uint32_t to) {
+        targets_.clear();
+        for (auto v : position_vertices_[from]) {
+            auto target = v;
+            for (auto t : vertex_triangles_[v]) {
+                if (removed_triangles_[t]) {
+                    continue;
+                }
+                for (auto k = 0; k < 3; ++k) {
+                    if (position_ids_[indices_[3 * t + k]] == to) {
+                        target = indices_[3 * t + k];
+                    }
+                }
+            }
+            if (target == v) {
+                return false;
+            }
+            targets_.emplace_back(target);
+        }
+        return true;
+    }
+
+    bool mesh_simplifier::flips(uint32_t from, uint32_t to) const noexcept {
+        for (auto v : position_vertices_[from]) {
+            for (auto t : vertex_triangles_[v]) {
+                if (removed_triangles_[t]) {
+                    continue;
+                }
+                auto i = &indices_[3 * t];
+                glm::vec3 before[3], after[3];
+                auto collapsed = false;
+                for (auto k = 0; k < 3; ++k) {
+                    auto id = position_ids_[i[k]];
+                    collapsed = collapsed || id == to;
+                    before[k] = positions_[i[k]];
+                    after[k] = id == from ? positions_[to] : before[k];
+                }
+                if (collapsed) {
+                    continue;
+                }
+                auto old_normal = glm::cross(before[1] - before[0], before[2] - before[0]);
+                auto new_normal = glm::cross(after[1] - after[0], after[2] - after[0]);
+                if (glm::dot(old_normal, new_normal) <= 0.f) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    void mesh_simplifier::apply(const collapse& c) {
+        auto& vertices = position_vertices_[c.from];
+        for (auto j = size_t{0}; j < vertices.size(); ++j) {
+            auto v = vertices[j];
+            auto target = targets_[j];
+            for (auto t : vertex_triangles_[v]) {
+                if (removed_triangles_[t]) {
+                    continue;
+                }
+                auto i = &indices_[3 * t];
+                for (auto k = 0; k < 3; ++k) {
+                    if (i[k] == v) {
+                        i[k] = target;
+                    }
+                }
+                auto a = position_ids_[i[0]];
+                auto b = position_ids_[i[1]];
+                auto d = position_ids_[i[2]];
+                if (a == b || b == d || a == d) {
+                    removed_triangles_[t] = true;
+                    --triangle_count_;
+                } else {
+                    vertex_triangles_[target].emplace_back(t);
+                }
+            }
+            vertex_triangles_[v].clear();
+        }
+        vertices.clear();
+        quadrics_[c.to] += quadrics_[c.from];
+        weights_[c.to] += weights_[c.from];
+        removed_positions_[c.from] = true;
+        ++versions_[c.to];
+        max_cost_ = std::max(max_cost_, c.cost);
+
+        for (auto v : position_vertices_[c.to]) {
+            auto& triangles = vertex_triangles_[v];
+            triangles.erase(std::remove_if(triangles.begin(), triangles.end(), [this](uint32_t t) {
+                return removed_triangles_[t];
+            }), triangles.end());
+            for (auto t : triangles) {
+                for (auto k = 0; k < 3; ++k) {
+                    auto id = position_ids_[indices_[3 * t + k]];
+                    if (id != c.to) {
+                        push_edge(c.to, id);
+                    }
+                }
+            }
+        }
+    }
+}
@@ -16,6 +16,7 @@ namespace zombye {
     class game_state;
     class input_system;
     class physics_system;
+    class profiler;
     class rendering_system;
     class logger;
     class scripting_system;
@@ -55,6 +56,11 @@ namespace zombye {
             return *scripting_system_;
         }
 
+        // cpu timings of the systems and cpu and gpu timings of the render passes
+        auto& profiler() noexcept {
+            return *profiler_;
+        }
+
         input_system* input();
         audio_system* audio();
         gameplay_system* gameplay();
@@ -72,6 +78,7 @@ namespace zombye {
         std::unique_ptr<zombye::asset_manager> asset_manager_;
 
         std::unique_ptr<zombye::config_system> config_system_;
+        std::unique_ptr<zombye::profiler> profiler_;
         std::unique_ptr<zombye::scripting_system> scripting_system_;
         std::unique_ptr<input_system> input_system_;
         std::unique_ptr<audio_system> audio_system_;
@@ -136,25 +136,19 @@ namespace zombye {
             return position_;
         }
 
-        void position(const glm::vec3& position) noexcept {
-            position_ = position;
-        }
+        void position(const glm::vec3& position) noexcept;
 
         const glm::quat& rotation() const noexcept {
             return rotation_;
         }
 
-        void rotation(const glm::quat& rotation) noexcept {
-            rotation_ = rotation;
-        }
+        void rotation(const glm::quat& rotation) noexcept;
 
         const glm::vec3& scalation() const noexcept {
             return scalation_;
         }
 
-        void scalation(const glm::vec3& scalation) noexcept {
-            scalation_ = scalation;
-        }
+        void scalation(const glm::vec3& scalation) noexcept;
 
         glm::mat4 transform() const;
     };
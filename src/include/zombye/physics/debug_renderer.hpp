@@ -8,6 +8,7 @@
 
 #include <zombye/rendering/vertex_array.hpp>
 #include <zombye/rendering/buffer.hpp>
+#include <zombye/rendering/stream_buffer.hpp>
 #include <zombye/rendering/vertex_layout.hpp>
 #include <zombye/rendering/shader.hpp>
 #include <zombye/rendering/program.hpp>
@@ -24,8 +25,9 @@ namespace zombye {
         game& game_;
         rendering_system& rs_;
         vertex_layout debug_vertex_layout_;
-        vertex_buffer vbo_;
+        vertex_stream_buffer vbo_;
         vertex_array vao_;
+        uint32_t vbo_generation_;
         program debug_program_;
         std::vector<debug_vertex> line_buffer_;
         std::vector<debug_vertex> point_buffer_;
@@ -37,6 +39,9 @@ namespace zombye {
         void buffer_contact_point(const glm::vec3& point, const glm::vec3& normal, float distance, float lifetime, const glm::vec3& color);
 
         void draw();
+
+    private:
+        void draw_buffer(GLenum mode, const std::vector<debug_vertex>& vertices);
     };
 }
 
@@ -9,6 +9,7 @@
 
 #include <zombye/ecs/component.hpp>
 #include <zombye/ecs/reflective.hpp>
+#include <zombye/rendering/mesh.hpp>
 
 namespace zombye {
     class entity;
@@ -40,6 +41,7 @@ namespace zombye {
         std::vector<glm::mat4> pose_;
         bool blend_;
         bool blend_next_;
+        lod_state lod_;
     public:
         animation_component(game& game, entity& owner, const std::string& mesh, const std::string& skeleton);
         ~animation_component() noexcept;
@@ -54,6 +56,11 @@ namespace zombye {
 
         void load(const std::string& mesh);
 
+        // updated by the rendering system when commands are recorded
+        auto& lod() noexcept {
+            return lod_;
+        }
+
         auto skeleton() const noexcept {
             return skeleton_;
         }
@@ -3,6 +3,12 @@
 
 #include <GL/glew.h>
 
+#include <zombye/rendering/gl_backend.hpp>
+
+namespace zombye {
+    class texture;
+}
+
 namespace zombye {
     template <GLenum target>
     class buffer {
@@ -11,16 +17,16 @@ namespace zombye {
     public:
         buffer(size_t size, GLenum usage) noexcept
         : usage_{usage} {
-            glGenBuffers(1, &id_);
-            glBindBuffer(target, id_);
-            glBufferData(target, size, nullptr, usage_);
+            gl.gen_buffers(1, &id_);
+            gl.bind_buffer(target, id_);
+            gl.buffer_data(target, size, nullptr, usage_);
         }
 
         buffer(size_t size, const void* data, GLenum usage) noexcept
         : usage_{usage} {
-            glGenBuffers(1, &id_);
-            glBindBuffer(target, id_);
-            glBufferData(target, size, data, usage_);
+            gl.gen_buffers(1, &id_);
+            gl.bind_buffer(target, id_);
+            gl.buffer_data(target, size, data, usage_);
         }
 
         buffer(const buffer& other) = delete;
@@ -31,7 +37,7 @@ namespace zombye {
         }
 
         ~buffer() noexcept {
-            glDeleteBuffers(1, &id_);
+            gl.delete_buffers(1, &id_);
         }
 
         buffer& operator=(const buffer& other) = delete;
@@ -45,22 +51,35 @@ namespace zombye {
         }
 
         void data(size_t size, const void* data) noexcept {
-            glBindBuffer(target, id_);
-            glBufferData(target, size, data, usage_);
+            gl.bind_buffer(target, id_);
+            gl.buffer_data(target, size, data, usage_);
         }
 
         void subdata(intptr_t offset, size_t size, const void* data) noexcept {
-            glBindBuffer(target, id_);
-            glBufferSubData(target, offset, size, data);
+            gl.bind_buffer(target, id_);
+            gl.buffer_sub_data(target, offset, size, data);
         }
 
         void bind() const noexcept {
-            glBindBuffer(target, id_);
+            gl.bind_buffer(target, id_);
         }
+
+        GLuint id() const noexcept {
+            return id_;
+        }
+
+        // binds a part of the buffer to an indexed target like GL_TRANSFORM_FEEDBACK_BUFFER
+        void bind_range(GLenum indexed_target, GLuint index, intptr_t offset, size_t size) const noexcept {
+            gl.bind_buffer_range(indexed_target, index, id_, offset, size);
+        }
+
+    private:
+        friend class texture;
     };
 
     using vertex_buffer = buffer<GL_ARRAY_BUFFER>;
     using index_buffer = buffer<GL_ELEMENT_ARRAY_BUFFER>;
+    using texture_buffer = buffer<GL_TEXTURE_BUFFER>;
 }
 
 #endif
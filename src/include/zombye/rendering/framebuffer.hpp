@@ -6,6 +6,8 @@
 
 #include <GL/glew.h>
 
+#include <zombye/rendering/gl_backend.hpp>
+
 namespace zombye {
 	class texture;
 }
@@ -14,7 +16,7 @@ namespace zombye {
 	class framebuffer {
 	private:
 		GLuint id_;
-		std::unordered_map<GLenum, std::unique_ptr<texture>> attachments_;
+		std::unordered_map<GLenum, std::shared_ptr<texture>> attachments_;
 
 	public:
 		framebuffer() noexcept;
@@ -27,12 +29,13 @@ namespace zombye {
 		framebuffer& operator=(framebuffer&& rhs) noexcept;
 
 		void bind() const noexcept;
+		void bind_read() const noexcept;
 
 		template <typename... arguments>
 		void attach(GLenum attachment, arguments&&... args) {
 			bind();
 			auto tex = std::make_unique<texture>(std::forward<arguments>(args)...);
-			glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, tex->id_, 0);
+			gl.framebuffer_texture_2d(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, tex->id_, 0);
 			attachments_.insert(std::make_pair(attachment, std::move(tex)));
 			bind_default();
 		}
@@ -42,12 +45,29 @@ namespace zombye {
 			bind();
 			auto tex = std::make_unique<texture>(std::forward<arguments>(args)...);
 			for (auto i = 0; i < 6; ++i) {
-				glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, tex->id_, 0);
+				gl.framebuffer_texture_2d(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, tex->id_, 0);
 			}
 			attachments_.insert(std::make_pair(GL_TEXTURE_CUBE_MAP, std::move(tex)));
 			bind_default();
 		}
 
+		// attaches an array texture. layer 0 is bound until select_layer picks another one.
+		template <typename... arguments>
+		void attach_array(GLenum attachment, arguments&&... args) {
+			bind();
+			auto tex = std::make_unique<texture>(std::forward<arguments>(args)...);
+			gl.framebuffer_texture_layer(GL_FRAMEBUFFER, attachment, tex->id_, 0, 0);
+			attachments_.insert(std::make_pair(attachment, std::move(tex)));
+			bind_default();
+		}
+
+		// attaches a texture the framebuffer shares with its owner. layer 0 of array textures is bound until
+		// select_layer picks another one.
+		void attach_texture(GLenum attachment, std::shared_ptr<texture> texture);
+
+		// expects the framebuffer to be bound to target
+		void select_layer(GLenum attachment, GLint layer, GLenum target = GL_FRAMEBUFFER) const;
+
 		texture& attachment(GLenum attachment) const;
 		static void bind_default() noexcept;
 	};
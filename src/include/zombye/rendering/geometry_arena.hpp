@@ -0,0 +1,132 @@
+#ifndef __ZOMBYE_GEOMETRY_ARENA_HPP__
+#define __ZOMBYE_GEOMETRY_ARENA_HPP__
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include <zombye/rendering/buffer.hpp>
+#include <zombye/rendering/vertex_array.hpp>
+
+namespace zombye {
+    class rendering_system;
+}
+
+namespace zombye {
+    // first fit allocator over a range of elements. freed blocks are merged with their free neighbours.
+    class range_allocator {
+        std::map<uint64_t, uint64_t> free_blocks_;
+        uint64_t capacity_;
+        uint64_t used_;
+    public:
+        explicit range_allocator(uint64_t capacity);
+
+        // returns false when no free block can hold size elements
+        bool allocate(uint64_t size, uint64_t& offset);
+        void free(uint64_t offset, uint64_t size);
+
+        uint64_t largest_free_block() const noexcept;
+
+        auto capacity() const noexcept {
+            return capacity_;
+        }
+
+        auto used() const noexcept {
+            return used_;
+        }
+
+        auto free_blocks() const noexcept {
+            return free_blocks_.size();
+        }
+    };
+
+    // a set of large buffers holding the vertices and indices of many meshes with the same vertex format and
+    // index type. vao reads the position and attribute streams, depth_vao only the positions. both read the
+    // draw id stream of the arena as an instanced attribute.
+    struct geometry_page {
+        uint32_t vertex_format;
+        GLenum index_type;
+        size_t position_size;
+        size_t index_size;
+        // creating a vertex array binds it. the vertex arrays come first, so creating the index buffer binds it
+        // to a vertex array of this page and never to the one of the page created before.
+        vertex_array vao;
+        vertex_array depth_vao;
+        vertex_buffer positions;
+        vertex_buffer attributes;
+        index_buffer indices;
+        range_allocator vertex_allocator;
+        range_allocator index_allocator;
+
+        geometry_page(uint32_t vertex_format, GLenum index_type, uint64_t vertex_capacity, uint64_t index_capacity);
+    };
+
+    // the part of a page a mesh was uploaded to. its indices are relative to base_vertex.
+    struct geometry_allocation {
+        geometry_page* page = nullptr;
+        int32_t base_vertex = 0;
+        uint32_t vertex_count = 0;
+        uint32_t first_index = 0;
+        uint32_t index_count = 0;
+    };
+
+    // occupancy is used over capacity bytes. fragmentation is the share of free bytes outside the largest free
+    // block of their allocator, zero when the free space of every page is contiguous.
+    struct geometry_arena_statistics {
+        uint64_t pages = 0;
+        uint64_t allocations = 0;
+        uint64_t capacity_bytes = 0;
+        uint64_t used_bytes = 0;
+        uint64_t free_blocks = 0;
+        float occupancy = 0.f;
+        float fragmentation = 0.f;
+    };
+
+    // sub-allocates the geometry of all static meshes from a few pages per vertex format and index type, so
+    // meshes sharing a page are drawn without switching vertex arrays and can be batched into one indirect
+    // draw. a new page is added when no page of the kind has room, pages are never released.
+    //
+    // the draw id stream holds 0, 1, 2, ... and is read with a divisor of one, so a draw with base instance n
+    // reads n. multi draw indirect passes the index of the draw data that way, the fallback loop passes it as
+    // a uniform and reads 0.
+    class geometry_arena {
+        static const uint64_t default_page_vertices = 1 << 18;
+        static const uint64_t default_page_indices = 1 << 20;
+
+        rendering_system& rendering_system_;
+        std::vector<std::unique_ptr<geometry_page>> pages_;
+        vertex_buffer draw_ids_;
+        size_t draw_capacity_;
+        uint64_t allocations_;
+
+    public:
+        explicit geometry_arena(rendering_system& rendering_system);
+        ~geometry_arena() noexcept = default;
+
+        geometry_arena(const geometry_arena& other) = delete;
+        geometry_arena(geometry_arena&& other) = delete;
+        geometry_arena& operator=(const geometry_arena& other) = delete;
+        geometry_arena& operator=(geometry_arena&& other) = delete;
+
+        // positions hold vertex_count positions in the layout of vertex_format, attributes vertex_count
+        // devtools::packed_attributes and indices index_count indices of index_type
+        geometry_allocation allocate(uint32_t vertex_format, GLenum index_type, uint64_t vertex_count,
+            const void* positions, const void* attributes, uint64_t index_count, const void* indices);
+        void free(const geometry_allocation& allocation) noexcept;
+
+        // grows the draw id stream to at least draw_count draws
+        void reserve_draws(size_t draw_count);
+
+        geometry_arena_statistics statistics() const noexcept;
+
+    private:
+        void setup_page(geometry_page& page);
+        // throws when a vertex array of a page does not draw from the index buffer of the page
+        void check_index_buffers() const;
+    };
+}
+
+#endif
@@ -0,0 +1,192 @@
+#ifndef __ZOMBYE_GL_BACKEND_HPP__
+#define __ZOMBYE_GL_BACKEND_HPP__
+
+#include <cstdint>
+#include <string>
+
+#include <GL/glew.h>
+
+// KHR_parallel_shader_compile is newer than the glew the project builds against
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+namespace zombye {
+    enum class gl_backend_type {
+        native,
+        null
+    };
+
+    // counters filled in by the null backend. the native backend leaves them untouched.
+    struct gl_statistics {
+        uint64_t calls = 0;
+        uint64_t draw_calls = 0;
+        uint64_t state_changes = 0;
+        uint64_t uniform_uploads = 0;
+        uint64_t bytes_uploaded = 0;
+
+        gl_statistics& operator+=(const gl_statistics& rhs) noexcept {
+            calls += rhs.calls;
+            draw_calls += rhs.draw_calls;
+            state_changes += rhs.state_changes;
+            uniform_uploads += rhs.uniform_uploads;
+            bytes_uploaded += rhs.bytes_uploaded;
+            return *this;
+        }
+    };
+
+    // optional features the renderer takes advantage of when the driver has them. the null backend reports none.
+    struct gl_capabilities {
+        bool buffer_storage = false;
+        bool texture_buffer_range = false;
+        // ARB_multi_draw_indirect together with ARB_base_instance, so every indirect draw can carry its own
+        // per draw data index
+        bool multi_draw_indirect = false;
+        // ARB_get_program_binary, linked programs can be saved and loaded without compiling their shaders
+        bool program_binary = false;
+        // KHR_parallel_shader_compile or its ARB twin, the driver compiles and links on its own threads and
+        // GL_COMPLETION_STATUS_KHR can be polled without blocking
+        bool parallel_shader_compile = false;
+        // ARB_timer_query, gpu timestamps can be recorded in the command stream
+        bool timer_query = false;
+    };
+
+    // every gl call of the renderer goes through this table, so the backend can be swapped at startup
+    // before any gl object is created.
+    struct gl_dispatch {
+        void (*active_texture)(GLenum texture);
+        void (*attach_shader)(GLuint program, GLuint shader);
+        void (*begin_transform_feedback)(GLenum primitive_mode);
+        void (*bind_attrib_location)(GLuint program, GLuint index, const GLchar* name);
+        void (*bind_buffer)(GLenum target, GLuint buffer);
+        void (*bind_buffer_range)(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+        void (*bind_frag_data_location)(GLuint program, GLuint color_number, const GLchar* name);
+        void (*bind_framebuffer)(GLenum target, GLuint framebuffer);
+        void (*bind_texture)(GLenum target, GLuint texture);
+        void (*bind_vertex_array)(GLuint array);
+        void (*blend_equation)(GLenum mode);
+        void (*blit_framebuffer)(GLint src_x0, GLint src_y0, GLint src_x1, GLint src_y1, GLint dst_x0, GLint dst_y0,
+            GLint dst_x1, GLint dst_y1, GLbitfield mask, GLenum filter);
+        void (*blend_func)(GLenum sfactor, GLenum dfactor);
+        void (*buffer_data)(GLenum target, GLsizeiptr size, const GLvoid* data, GLenum usage);
+        void (*buffer_storage)(GLenum target, GLsizeiptr size, const GLvoid* data, GLbitfield flags);
+        void (*buffer_sub_data)(GLenum target, GLintptr offset, GLsizeiptr size, const GLvoid* data);
+        void (*clear)(GLbitfield mask);
+        GLenum (*client_wait_sync)(GLsync sync, GLbitfield flags, GLuint64 timeout);
+        void (*clear_color)(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha);
+        void (*compile_shader)(GLuint shader);
+        void (*compressed_tex_image_2d)(GLenum target, GLint level, GLenum internal_format, GLsizei width,
+            GLsizei height, GLint border, GLsizei image_size, const GLvoid* data);
+        void (*compressed_tex_image_3d)(GLenum target, GLint level, GLenum internal_format, GLsizei width,
+            GLsizei height, GLsizei depth, GLint border, GLsizei image_size, const GLvoid* data);
+        void (*compressed_tex_sub_image_3d)(GLenum target, GLint level, GLint x_offset, GLint y_offset,
+            GLint z_offset, GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLsizei image_size,
+            const GLvoid* data);
+        GLuint (*create_program)();
+        GLuint (*create_shader)(GLenum type);
+        void (*cull_face)(GLenum mode);
+        void (*delete_buffers)(GLsizei n, const GLuint* buffers);
+        void (*delete_framebuffers)(GLsizei n, const GLuint* framebuffers);
+        void (*delete_program)(GLuint program);
+        void (*delete_queries)(GLsizei n, const GLuint* ids);
+        void (*delete_shader)(GLuint shader);
+        void (*delete_sync)(GLsync sync);
+        void (*delete_textures)(GLsizei n, const GLuint* textures);
+        void (*delete_vertex_arrays)(GLsizei n, const GLuint* arrays);
+        void (*detach_shader)(GLuint program, GLuint shader);
+        void (*disable)(GLenum cap);
+        void (*draw_arrays)(GLenum mode, GLint first, GLsizei count);
+        void (*draw_buffers)(GLsizei n, const GLenum* bufs);
+        void (*draw_elements)(GLenum mode, GLsizei count, GLenum type, const GLvoid* indices);
+        void (*draw_elements_base_vertex)(GLenum mode, GLsizei count, GLenum type, const GLvoid* indices,
+            GLint base_vertex);
+        void (*draw_elements_instanced)(GLenum mode, GLsizei count, GLenum type, const GLvoid* indices,
+            GLsizei instance_count);
+        void (*enable)(GLenum cap);
+        void (*enable_vertex_attrib_array)(GLuint index);
+        void (*end_transform_feedback)();
+        GLsync (*fence_sync)(GLenum condition, GLbitfield flags);
+        void (*framebuffer_texture_2d)(GLenum target, GLenum attachment, GLenum textarget, GLuint texture,
+            GLint level);
+        void (*framebuffer_texture_layer)(GLenum target, GLenum attachment, GLuint texture, GLint level, GLint layer);
+        void (*front_face)(GLenum mode);
+        void (*gen_buffers)(GLsizei n, GLuint* buffers);
+        void (*gen_framebuffers)(GLsizei n, GLuint* framebuffers);
+        void (*gen_queries)(GLsizei n, GLuint* ids);
+        void (*gen_textures)(GLsizei n, GLuint* textures);
+        void (*gen_vertex_arrays)(GLsizei n, GLuint* arrays);
+        void (*generate_mipmap)(GLenum target);
+        void (*get_floatv)(GLenum pname, GLfloat* params);
+        void (*get_integerv)(GLenum pname, GLint* params);
+        void (*get_program_binary)(GLuint program, GLsizei buf_size, GLsizei* length, GLenum* binary_format,
+            GLvoid* binary);
+        void (*get_program_info_log)(GLuint program, GLsizei buf_size, GLsizei* length, GLchar* info_log);
+        void (*get_programiv)(GLuint program, GLenum pname, GLint* params);
+        void (*get_query_objectiv)(GLuint id, GLenum pname, GLint* params);
+        void (*get_query_objectui64v)(GLuint id, GLenum pname, GLuint64* params);
+        void (*get_shader_info_log)(GLuint shader, GLsizei buf_size, GLsizei* length, GLchar* info_log);
+        void (*get_shaderiv)(GLuint shader, GLenum pname, GLint* params);
+        const GLubyte* (*get_string)(GLenum name);
+        GLint (*get_uniform_location)(GLuint program, const GLchar* name);
+        void (*link_program)(GLuint program);
+        void* (*map_buffer_range)(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access);
+        void (*max_shader_compiler_threads)(GLuint count);
+        void (*multi_draw_elements_indirect)(GLenum mode, GLenum type, const GLvoid* indirect, GLsizei draw_count,
+            GLsizei stride);
+        void (*pixel_storei)(GLenum pname, GLint param);
+        void (*program_binary)(GLuint program, GLenum binary_format, const GLvoid* binary, GLsizei length);
+        void (*program_parameteri)(GLuint program, GLenum pname, GLint value);
+        void (*query_counter)(GLuint id, GLenum target);
+        void (*shader_source)(GLuint shader, GLsizei count, const GLchar* const* string, const GLint* length);
+        void (*tex_buffer)(GLenum target, GLenum internal_format, GLuint buffer);
+        void (*tex_buffer_range)(GLenum target, GLenum internal_format, GLuint buffer, GLintptr offset,
+            GLsizeiptr size);
+        void (*tex_image_2d)(GLenum target, GLint level, GLint internal_format, GLsizei width, GLsizei height,
+            GLint border, GLenum format, GLenum type, const GLvoid* data);
+        void (*tex_image_3d)(GLenum target, GLint level, GLint internal_format, GLsizei width, GLsizei height,
+            GLsizei depth, GLint border, GLenum format, GLenum type, const GLvoid* data);
+        void (*tex_parameteri)(GLenum target, GLenum pname, GLint param);
+        void (*tex_sub_image_3d)(GLenum target, GLint level, GLint x_offset, GLint y_offset, GLint z_offset,
+            GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, const GLvoid* data);
+        void (*transform_feedback_varyings)(GLuint program, GLsizei count, const GLchar* const* varyings,
+            GLenum buffer_mode);
+        void (*uniform_1f)(GLint location, GLfloat v0);
+        void (*uniform_1i)(GLint location, GLint v0);
+        void (*uniform_1ui)(GLint location, GLuint v0);
+        void (*uniform_1fv)(GLint location, GLsizei count, const GLfloat* value);
+        void (*uniform_2fv)(GLint location, GLsizei count, const GLfloat* value);
+        void (*uniform_3fv)(GLint location, GLsizei count, const GLfloat* value);
+        void (*uniform_4fv)(GLint location, GLsizei count, const GLfloat* value);
+        void (*uniform_1iv)(GLint location, GLsizei count, const GLint* value);
+        void (*uniform_2iv)(GLint location, GLsizei count, const GLint* value);
+        void (*uniform_3iv)(GLint location, GLsizei count, const GLint* value);
+        void (*uniform_4iv)(GLint location, GLsizei count, const GLint* value);
+        void (*uniform_1uiv)(GLint location, GLsizei count, const GLuint* value);
+        void (*uniform_matrix_2fv)(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value);
+        void (*uniform_matrix_3fv)(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value);
+        void (*uniform_matrix_4fv)(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value);
+        GLboolean (*unmap_buffer)(GLenum target);
+        void (*use_program)(GLuint program);
+        void (*vertex_attrib_divisor)(GLuint index, GLuint divisor);
+        void (*vertex_attrib_i_pointer)(GLuint index, GLint size, GLenum type, GLsizei stride, const GLvoid* pointer);
+        void (*vertex_attrib_pointer)(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride,
+            const GLvoid* pointer);
+        void (*viewport)(GLint x, GLint y, GLsizei width, GLsizei height);
+    };
+
+    extern gl_dispatch gl;
+
+    void select_gl_backend(gl_backend_type type) noexcept;
+    gl_backend_type active_gl_backend() noexcept;
+    gl_backend_type gl_backend_from_string(const std::string& name);
+
+    // reads the capabilities of the current context, must be called after glewInit. entry points glew does
+    // not know are resolved here as well.
+    void query_gl_capabilities() noexcept;
+    const gl_capabilities& gl_caps() noexcept;
+
+    const gl_statistics& gl_stats() noexcept;
+    void reset_gl_stats() noexcept;
+}
+
+#endif
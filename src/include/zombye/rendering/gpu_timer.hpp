@@ -0,0 +1,46 @@
+#ifndef __ZOMBYE_GPU_TIMER_HPP__
+#define __ZOMBYE_GPU_TIMER_HPP__
+
+#include <vector>
+
+#include <GL/glew.h>
+
+namespace zombye {
+    // measures the gpu time between begin and end with a timestamp on either side, so timers may overlap and
+    // nest. results arrive a few frames later. every measurement uses its own pair of queries out of a ring of
+    // latency pairs, and a measurement is skipped while its pair is still in flight instead of waiting for it.
+    // without timer queries nothing is measured.
+    class gpu_timer {
+        struct sample {
+            GLuint begin;
+            GLuint end;
+            bool pending;
+        };
+
+        std::vector<sample> samples_;
+        size_t current_;
+        bool active_;
+        float milliseconds_;
+    public:
+        gpu_timer(size_t latency = 4) noexcept;
+        ~gpu_timer() noexcept;
+
+        gpu_timer(const gpu_timer& other) = delete;
+        gpu_timer(gpu_timer&& other) = delete;
+        gpu_timer& operator=(const gpu_timer& other) = delete;
+        gpu_timer& operator=(gpu_timer&& other) = delete;
+
+        void begin() noexcept;
+        void end() noexcept;
+
+        // reads the finished measurements and returns whether there was a new one
+        bool poll() noexcept;
+
+        // the last finished measurement
+        float milliseconds() const noexcept {
+            return milliseconds_;
+        }
+    };
+}
+
+#endif
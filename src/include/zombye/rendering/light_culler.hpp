@@ -0,0 +1,118 @@
+#ifndef __ZOMBYE_LIGHT_CULLER_HPP__
+#define __ZOMBYE_LIGHT_CULLER_HPP__
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <zombye/rendering/stream_buffer.hpp>
+#include <zombye/rendering/texture.hpp>
+
+namespace zombye {
+    class camera_component;
+    class light_component;
+    class program;
+    class thread_pool;
+}
+
+namespace zombye {
+    struct light_attributes {
+        glm::vec3 position;
+        glm::vec3 color;
+        // the attenuation radius the lighting pass shades with
+        float radius;
+        // the distance at which the light no longer contributes visibly, which bounds the froxels it is binned to
+        float extent;
+        float exponent;
+        const light_component* source;
+    };
+
+    // bins point lights into a grid of view space froxels. the screen is split into tiles_x * tiles_y tiles
+    // and the depth range into exponentially growing slices. the lighting pass looks up the cluster
+    // of a pixel and only shades the lights listed for it.
+    //
+    // the results are read with texelFetch from three buffer textures:
+    //   light texture   (rgba32f) two texels per visible light, position and radius, color and exponent
+    //   cluster texture (rg32ui)  offset into the index texture and light count per cluster
+    //   index texture   (r32ui)   indices into the light texture
+    //
+    // lights outside the view frustum are skipped. when more than max_lights remain, they are ranked by
+    // screen coverage times intensity and only the most important ones are kept. lights entering or leaving
+    // the budget fade in and out over fade_time seconds instead of popping.
+    class light_culler {
+        struct light_range {
+            int min_x, max_x;
+            int min_y, max_y;
+            int min_z, max_z;
+            float importance;
+        };
+
+        struct light_fade {
+            float value;
+            uint64_t frame;
+        };
+
+        int tiles_x_;
+        int tiles_y_;
+        int slices_;
+        float near_plane_;
+        float far_plane_;
+        size_t max_lights_;
+        float fade_time_;
+        uint64_t frame_;
+        uint64_t uploaded_frame_;
+
+        std::vector<light_range> ranges_;
+        std::vector<size_t> candidates_;
+        std::vector<float> fade_values_;
+        std::unordered_map<const light_component*, light_fade> fades_;
+        std::vector<glm::vec4> light_data_;
+        std::vector<uint32_t> cluster_data_;
+        std::vector<uint32_t> light_indices_;
+
+        texture_stream_buffer light_buffer_;
+        texture_stream_buffer cluster_buffer_;
+        texture_stream_buffer index_buffer_;
+        std::unique_ptr<texture> light_texture_;
+        std::unique_ptr<texture> cluster_texture_;
+        std::unique_ptr<texture> index_texture_;
+
+        size_t visible_lights_;
+
+    public:
+        light_culler(int tiles_x, int tiles_y, int slices, size_t max_lights, float fade_time);
+        ~light_culler() = default;
+
+        light_culler(const light_culler& other) = delete;
+        light_culler(light_culler&& other) = delete;
+        light_culler& operator=(const light_culler& other) = delete;
+        light_culler& operator=(light_culler&& other) = delete;
+
+        // lights with an extent of zero or less are skipped
+        void cull(const std::vector<light_attributes>& lights, const camera_component& camera, float delta_time,
+            thread_pool& pool);
+        // streams the results of the last cull into the buffer textures. further calls before the next cull
+        // keep the uploaded data.
+        void upload();
+
+        void bind(uint32_t light_unit, uint32_t cluster_unit, uint32_t index_unit) const noexcept;
+        // sets the uniforms the lighting shaders need to find the cluster of a fragment
+        void setup_program(program& program) const;
+
+        auto visible_lights() const noexcept {
+            return visible_lights_;
+        }
+
+        auto light_indices() const noexcept {
+            return light_indices_.size();
+        }
+
+    private:
+        int slice(float depth) const noexcept;
+    };
+}
+
+#endif
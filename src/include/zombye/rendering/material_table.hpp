@@ -0,0 +1,53 @@
+#ifndef __ZOMBYE_MATERIAL_TABLE_HPP__
+#define __ZOMBYE_MATERIAL_TABLE_HPP__
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <tuple>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <zombye/rendering/buffer.hpp>
+
+namespace zombye {
+    class texture;
+    class texture_layer;
+}
+
+namespace zombye {
+    // the layers of the diffuse, material and normal texture arrays a material samples, indexed by material id.
+    // the mesh vertex shaders read the table from a buffer texture with one RGBA32I texel per material, so
+    // submeshes with different materials in the same arrays are drawn together. id 0 is no material.
+    class material_table {
+        using key = std::tuple<size_t, size_t, size_t>;
+
+        std::map<key, uint32_t> ids_;
+        std::vector<glm::ivec4> materials_;
+        std::unique_ptr<texture_buffer> buffer_;
+        std::unique_ptr<zombye::texture> texture_;
+        bool dirty_;
+    public:
+        material_table();
+        ~material_table() noexcept;
+
+        material_table(const material_table& other) = delete;
+        material_table(material_table&& other) = delete;
+        material_table& operator=(const material_table& other) = delete;
+        material_table& operator=(material_table&& other) = delete;
+
+        // the id of the material sampling the layers, which is added on first use. materials are never removed,
+        // since only the layers are stored and a freed layer is taken by the next texture of the same kind.
+        uint32_t id(const texture_layer& diffuse, const texture_layer& material, const texture_layer& normal);
+
+        // uploads added materials and binds the table
+        void bind(uint32_t unit);
+
+        size_t size() const noexcept {
+            return materials_.size();
+        }
+    };
+}
+
+#endif
@@ -2,16 +2,20 @@
 #define __ZOMBYE_MESH_HPP__
 
 #include <memory>
+#include <string>
 #include <vector>
 
 #include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
 
+#include <mesh_converter/mesh_converter.hpp>
 #include <zombye/rendering/buffer.hpp>
-#include <zombye/rendering/vertex_array.hpp>
+#include <zombye/rendering/geometry_arena.hpp>
 
 namespace zombye {
     class rendering_system;
     class texture;
+    class texture_layer;
 }
 
 namespace zombye {
@@ -30,41 +34,165 @@ namespace zombye {
         glm::vec3 tangent;
     };
 
+    // skinned meshes bind the textures of their submeshes. static meshes sample layers of texture arrays
+    // instead, which material_id looks up in the material table.
     struct submesh {
         uint64_t index_count;
         uint64_t offset;
         std::shared_ptr<const texture> diffuse;
         std::shared_ptr<const texture> normal;
         std::shared_ptr<const texture> material;
+        std::shared_ptr<const texture_layer> diffuse_layer;
+        std::shared_ptr<const texture_layer> normal_layer;
+        std::shared_ptr<const texture_layer> material_layer;
+        uint32_t material_id = 0;
     };
 
+    struct bounding_box {
+        glm::vec3 min;
+        glm::vec3 max;
+
+        auto center() const noexcept {
+            return 0.5f * (min + max);
+        }
+
+        auto extent() const noexcept {
+            return 0.5f * (max - min);
+        }
+    };
+
+    // a level of detail is a range of submeshes, whose indices are stored contiguously. error is the distance
+    // in model units by which it deviates from the full mesh.
+    struct mesh_lod {
+        size_t first_submesh;
+        size_t submesh_count;
+        uint64_t first_index;
+        uint64_t index_count;
+        float error;
+    };
+
+    // the content of a static mesh file with the vertices in the two streams of the geometry arena. positions
+    // are three floats or, with devtools::half_positions in vertex_format, four halfs per vertex. version 1 files
+    // are packed while reading.
+    struct mesh_data {
+        uint32_t vertex_format = 0;
+        uint64_t vertex_count = 0;
+        std::vector<char> positions;
+        std::vector<devtools::packed_attributes> attributes;
+        std::vector<uint32_t> indices;
+        std::vector<devtools::submesh> submeshes;
+        std::vector<devtools::lod> lods;
+        bool parallax_mapping = false;
+        bounding_box bounds;
+
+        glm::vec3 position(uint64_t i) const noexcept {
+            if (vertex_format & devtools::half_positions) {
+                auto p = reinterpret_cast<const uint16_t*>(positions.data()) + 4 * i;
+                return glm::vec3{glm::unpackHalf1x16(p[0]), glm::unpackHalf1x16(p[1]), glm::unpackHalf1x16(p[2])};
+            }
+            return reinterpret_cast<const glm::vec3*>(positions.data())[i];
+        }
+    };
+
+    // reads version 1 files with interleaved float vertices and version 2 and 3 files with packed vertex streams
+    mesh_data read_mesh(const std::vector<char>& source, const std::string& file_name);
+
+    // the finest level of detail of a mesh with at most max_occluder_triangles triangles in model space, kept on
+    // the cpu for occlusion culling. simplified levels are not inside the real surface, so error is the distance
+    // in model units by which the occluder may stick out of it. meshes without such a level have no occluder.
+    struct occluder_mesh {
+        static const uint64_t max_occluder_triangles = 2048;
+
+        std::vector<glm::vec3> positions;
+        std::vector<uint32_t> indices;
+        float error = 0.f;
+    };
+
+    // the levels of detail an object was drawn with in the last frame
+    struct lod_state {
+        size_t lod = 0;
+        size_t shadow_lod = 0;
+    };
+
+    // reads lod_count devtools::lod entries and checks them against the submeshes. files without levels of
+    // detail pass a lod_count of zero and get a single level covering all submeshes.
+    std::vector<mesh_lod> read_lods(const char* data, uint64_t lod_count, const std::vector<submesh>& submeshes,
+        const std::string& file_name);
+
+    // picks the coarsest level of detail whose error projects to at most max_pixel_error pixels. a coarser level
+    // than current is only taken once its error stays below (1 - hysteresis) times the limit, so objects near a
+    // threshold do not switch back and forth every frame.
+    size_t select_lod(const std::vector<mesh_lod>& lods, size_t current, float pixels_per_unit, float max_pixel_error,
+        float hysteresis) noexcept;
+
+    // the gl type of index_size byte indices addressing vertex_count vertices. 32 bit indices are narrowed to
+    // 16 bit when the vertices can be addressed with them.
+    GLenum index_type(uint32_t index_size, uint64_t vertex_count) noexcept;
+
+    // returns index_count indices of index_size bytes as type, narrowing them into storage when needed
+    const void* convert_indices(const char* data, uint64_t index_count, uint32_t index_size, GLenum type,
+        std::vector<uint16_t>& storage);
+
+    // uploads index_count indices of index_size bytes as index_type(index_size, vertex_count) and returns
+    // that type
+    GLenum upload_indices(index_buffer& ibo, const char* data, uint64_t index_count, uint32_t index_size,
+        uint64_t vertex_count);
+
+    // the vertices and indices of a static mesh live in the geometry arena of the rendering system and are
+    // freed together with the mesh. submesh offsets are relative to the first index of the allocation.
     class mesh {
+        geometry_arena& arena_;
+        std::string name_;
         std::vector<submesh> submeshes_;
-        vertex_array vao_;
-        vertex_buffer vbo_;
-        index_buffer ibo_;
+        std::vector<mesh_lod> lods_;
+        geometry_allocation geometry_;
+        uint64_t index_count_;
+        GLenum index_type_;
         bool parallax_mapping_;
+        bounding_box bounds_;
+        occluder_mesh occluder_;
     public:
         mesh(rendering_system& rendering_system, const std::vector<char>& source, const std::string& file_name) noexcept;
+        mesh(rendering_system& rendering_system, const mesh_data& data, const std::string& name);
         mesh(const mesh& other) = delete;
-        mesh(mesh&& other) = default;
-        ~mesh() noexcept = default;
+        mesh(mesh&& other) = delete;
+        ~mesh() noexcept;
         mesh& operator=(const mesh& other) = delete;
-        mesh& operator=(mesh&& other) noexcept = default;
+        mesh& operator=(mesh&& other) = delete;
 
-        void draw() const noexcept;
+        // binds the texture arrays of every submesh, whose layers are not passed on
+        void draw(size_t lod = 0) const noexcept;
+        // draws all submeshes of a level at once from the position stream, without binding any textures
+        void draw_depth(size_t lod = 0) const noexcept;
 
-        auto& vao() const noexcept {
-            return vao_;
+        // the file the mesh was loaded from
+        auto& name() const noexcept {
+            return name_;
         }
 
-        auto& vbo() const noexcept {
-            return vbo_;
+        auto& lods() const noexcept {
+            return lods_;
+        }
+
+        auto& submeshes() const noexcept {
+            return submeshes_;
+        }
+
+        auto& geometry() const noexcept {
+            return geometry_;
         }
 
         auto parallax_mapping() const {
             return parallax_mapping_;
         }
+
+        auto& bounds() const noexcept {
+            return bounds_;
+        }
+
+        auto& occluder() const noexcept {
+            return occluder_;
+        }
     };
 }
 
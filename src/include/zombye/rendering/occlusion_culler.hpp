@@ -0,0 +1,102 @@
+#ifndef __ZOMBYE_OCCLUSION_CULLER_HPP__
+#define __ZOMBYE_OCCLUSION_CULLER_HPP__
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <zombye/rendering/mesh.hpp>
+
+namespace zombye {
+    class camera_component;
+    class thread_pool;
+}
+
+namespace zombye {
+    // a static mesh that may hide other meshes. occluders without triangles are skipped, and so are simplified
+    // occluders whose error projects to a pixel of the buffer or more, since they could hide visible objects.
+    struct occluder {
+        const occluder_mesh* mesh;
+        glm::mat4 model;
+        bounding_box bounds;
+    };
+
+    struct occlusion_statistics {
+        uint64_t occluders = 0;
+        uint64_t occluder_triangles = 0;
+        uint64_t tested = 0;
+        uint64_t culled = 0;
+    };
+
+    // rasterises the occluders nearest to the camera into a low resolution depth buffer on the cpu and tests
+    // the screen rectangle of bounding boxes against it. the buffer holds window depth in [0, 1] like the
+    // depth attachment of the g-buffer, so the debug view can show it with the same shader.
+    //
+    // occluders are ranked by the screen area of their bounding sphere and only the max_occluders largest
+    // ones are drawn. triangles crossing the near plane are dropped, which only lets more objects pass. the
+    // buffer is split into bands of rows, which the worker threads rasterise independently.
+    class occlusion_culler {
+        struct triangle {
+            glm::vec3 vertices[3];
+            int min_y, max_y;
+        };
+
+        int width_;
+        int height_;
+        size_t max_occluders_;
+        glm::mat4 projection_view_;
+        bool active_;
+
+        std::vector<float> depth_;
+        std::vector<float> importance_;
+        std::vector<size_t> candidates_;
+        std::vector<size_t> triangle_offsets_;
+        std::vector<triangle> triangles_;
+
+        occlusion_statistics frame_statistics_;
+        mutable std::atomic<uint64_t> tested_;
+        mutable std::atomic<uint64_t> culled_;
+
+    public:
+        // width is rounded up to a multiple of four, so rows can be processed four pixels at a time
+        occlusion_culler(int width, int height, size_t max_occluders);
+        ~occlusion_culler() = default;
+
+        occlusion_culler(const occlusion_culler& other) = delete;
+        occlusion_culler(occlusion_culler&& other) = delete;
+        occlusion_culler& operator=(const occlusion_culler& other) = delete;
+        occlusion_culler& operator=(occlusion_culler&& other) = delete;
+
+        // clears the buffer and draws the selected occluders as seen by camera
+        void render(const std::vector<occluder>& occluders, const camera_component& camera, thread_pool& pool);
+        // lets everything pass until the next render
+        void disable() noexcept;
+
+        // false if the bounding box transformed by model is outside the view or behind the occluders. safe to
+        // call from several threads.
+        bool visible(const glm::mat4& model, const bounding_box& bounds) const noexcept;
+
+        // statistics of the last finished frame. tests are counted until the next render.
+        occlusion_statistics statistics() const noexcept;
+
+        auto& depth() const noexcept {
+            return depth_;
+        }
+
+        auto width() const noexcept {
+            return width_;
+        }
+
+        auto height() const noexcept {
+            return height_;
+        }
+
+    private:
+        void setup_triangles(size_t index, const std::vector<occluder>& occluders);
+        void rasterize(const triangle& triangle, int min_y, int max_y) noexcept;
+    };
+}
+
+#endif
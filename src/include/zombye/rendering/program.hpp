@@ -1,13 +1,17 @@
 #ifndef __ZOMBYE_PROGRAM_HPP__
 #define __ZOMBYE_PROGRAM_HPP__
 
+#include <chrono>
 #include <memory>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <GL/glew.h>
 #include <glm/glm.hpp>
 
 namespace zombye {
+    class program_cache;
     class shader;
 }
 
@@ -15,10 +19,20 @@ namespace zombye {
     using shader_ptr = std::shared_ptr<const shader>;
 
     class program {
+        friend class program_cache;
         friend class vertex_layout;
 
         GLuint id_;
         std::vector<shader_ptr> shaders_;
+        bool attached_;
+        // everything set before linking that the program binary depends on, part of the program cache key
+        std::string link_state_;
+        // set while the driver may still be compiling and linking, the cache finishes the program later
+        program_cache* pending_cache_;
+        uint64_t key_;
+        std::chrono::steady_clock::time_point link_start_;
+        double issue_milliseconds_;
+        std::unordered_map<std::string, GLint> uniform_locations_;
     public:
         program() noexcept;
         program(const program& other) = delete;
@@ -27,8 +41,14 @@ namespace zombye {
         program& operator=(const program& other) = delete;
         program& operator=(program&& other) noexcept;
 
+        // shaders are compiled and attached by link, unless the program is found in the cache
         void attach_shader(shader_ptr shader);
-        void link();
+        // has to be called before link
+        void transform_feedback_varyings(const std::vector<std::string>& names, GLenum buffer_mode) noexcept;
+        // without a cache the status is checked right away. with one, compiling and linking are only issued and
+        // the program is checked by program_cache::finish_links, so the driver can work on many programs at once.
+        // the program can be used before that, the driver waits for it then.
+        void link(program_cache* cache = nullptr);
         void use() const noexcept;
 
         void uniform(const std::string& name, float value) noexcept;
@@ -56,9 +76,22 @@ namespace zombye {
         void uniform(const std::string& name, size_t count, bool transpose, const std::vector<glm::mat3>& values) noexcept;
         void uniform(const std::string& name, size_t count, bool transpose, const std::vector<glm::mat4>& values) noexcept;
 
+        // looks the location up once and caches it, so per draw uploads can skip the string lookup
+        GLint uniform_location(const std::string& name) noexcept;
+
+        void uniform(GLint location, float value) noexcept;
+        void uniform(GLint location, int32_t value) noexcept;
+        void uniform(GLint location, bool transpose, const glm::mat4& value) noexcept;
+        void uniform(GLint location, size_t count, bool transpose, const std::vector<glm::mat4>& values) noexcept;
+
         void bind_frag_data_location(const std::string& name, uint32_t color_number) noexcept;
 
+        // the names of the attached shaders
+        std::string name() const;
+
     private:
+        bool link_completed() const noexcept;
+        void finish_link();
         void bind_attribute_location(const std::string& name, uint32_t index) noexcept;
     };
 }
@@ -0,0 +1,74 @@
+#ifndef __ZOMBYE_PROGRAM_CACHE_HPP__
+#define __ZOMBYE_PROGRAM_CACHE_HPP__
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+namespace zombye {
+    class program;
+    class shader;
+}
+
+namespace zombye {
+    using shader_ptr = std::shared_ptr<const shader>;
+
+    struct program_cache_statistics {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+    };
+
+    // saves the binaries of linked programs to directory and loads them on the next start instead of compiling
+    // their shaders. an entry is keyed by a hash of the shader sources, the state set before linking and the
+    // vendor, renderer and version of the driver, so an edited shader or a driver update falls back to
+    // compiling. without ARB_get_program_binary every lookup misses and nothing is saved.
+    //
+    // programs linked with the cache are only checked by finish_links. with KHR_parallel_shader_compile the
+    // driver compiles them on its own threads meanwhile.
+    class program_cache {
+        friend class program;
+
+        std::string directory_;
+        std::string driver_;
+        bool enabled_;
+        bool store_failed_;
+        program_cache_statistics statistics_;
+        std::vector<program*> pending_;
+
+    public:
+        explicit program_cache(const std::string& directory);
+        ~program_cache() = default;
+
+        program_cache(const program_cache& other) = delete;
+        program_cache(program_cache&& other) = delete;
+        program_cache& operator=(const program_cache& other) = delete;
+        program_cache& operator=(program_cache&& other) = delete;
+
+        uint64_t key(const std::vector<shader_ptr>& shaders, const std::string& link_state) const noexcept;
+        // returns false if there is no valid binary for key, program is unlinked then
+        bool load(uint64_t key, GLuint program);
+        void store(uint64_t key, GLuint program);
+        void record_link(bool hit) noexcept;
+
+        // checks every program linked since the last call, each one as soon as the driver completed it
+        void finish_links();
+
+        auto enabled() const noexcept {
+            return enabled_;
+        }
+
+        auto& statistics() const noexcept {
+            return statistics_;
+        }
+
+    private:
+        std::string file_name(uint64_t key) const;
+        void add_pending(program* program);
+        void remove_pending(program* program) noexcept;
+    };
+}
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef __ZOMBYE_RENDER_COMMANDS_HPP__
+#define __ZOMBYE_RENDER_COMMANDS_HPP__
+
+#include <cstddef>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+namespace zombye {
+    struct geometry_page;
+    struct submesh;
+}
+
+namespace zombye {
+    // commands are recorded on worker threads and replayed on the gl thread. a command without a mesh was
+    // culled during recording and is skipped on replay, so every slot can be written without locking.
+    // skinned meshes are drawn from the shared skinned vertex buffer starting at base_vertex. lod is the level
+    // of detail of the mesh to draw. draw is the index of the draw_data of the object.
+    template <typename mesh_type>
+    struct shadow_command {
+        const mesh_type* mesh;
+        int32_t base_vertex;
+        size_t lod;
+        uint32_t draw;
+        bool dynamic;
+    };
+
+    template <typename mesh_type>
+    struct geometry_command {
+        const mesh_type* mesh;
+        int32_t base_vertex;
+        size_t lod;
+        uint32_t draw;
+        // the size of the bounds on screen, which picks the texture levels to stream in
+        float pixels;
+    };
+
+    // the transforms of an object, which the mesh vertex shaders fetch from a buffer texture. the w of the first
+    // column of model_it is 1 for meshes with parallax mapping.
+    struct draw_data {
+        glm::mat4 model;
+        glm::vec4 model_it[3];
+    };
+
+    // the layout glMultiDrawElementsIndirect reads
+    struct draw_elements_indirect_command {
+        uint32_t count;
+        uint32_t instance_count;
+        uint32_t first_index;
+        int32_t base_vertex;
+        uint32_t base_instance;
+    };
+
+    // a draw before batching. textures is the submesh whose texture arrays are bound, nullptr in depth passes.
+    struct batch_entry {
+        const geometry_page* page;
+        const submesh* textures;
+        draw_elements_indirect_command command;
+    };
+
+    // consecutive indirect commands drawing from the same geometry page with the same texture arrays
+    struct draw_batch {
+        const geometry_page* page;
+        const submesh* textures;
+        size_t first_command;
+        size_t command_count;
+    };
+}
+
+#endif
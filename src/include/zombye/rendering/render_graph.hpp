@@ -0,0 +1,127 @@
+#ifndef __ZOMBYE_RENDER_GRAPH_HPP__
+#define __ZOMBYE_RENDER_GRAPH_HPP__
+
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <GL/glew.h>
+
+namespace zombye {
+    class framebuffer;
+    class gpu_timer;
+    class profiler;
+    class texture;
+}
+
+namespace zombye {
+    // a render target the graph allocates. targets with layers are two dimensional arrays.
+    struct render_target_desc {
+        GLenum internal_format;
+        GLsizei width;
+        GLsizei height;
+        GLsizei layers = 0;
+
+        bool operator==(const render_target_desc& other) const noexcept {
+            return internal_format == other.internal_format && width == other.width && height == other.height
+                && layers == other.layers;
+        }
+    };
+
+    using render_resource = size_t;
+
+    // the passes of a frame with the render targets they read and write. the graph is declared anew every
+    // frame in execution order and compiled before it is executed.
+    //
+    // compiling culls every pass that neither has an effect outside the graph, like drawing to the default
+    // framebuffer, nor writes a resource a later pass that is kept reads. transient targets live from the
+    // first to the last kept pass using them, and targets with the same description whose lifetimes do not
+    // overlap share one texture. textures of imported resources are owned by the caller and may carry
+    // content from one frame to the next. textures no compiled graph used for max_unused_frames are freed.
+    class render_graph {
+        static const uint64_t max_unused_frames = 60;
+
+        struct resource {
+            std::string name;
+            render_target_desc desc;
+            std::shared_ptr<texture> imported;
+            size_t target;
+            size_t first_pass;
+            size_t last_pass;
+            // a pass that was not culled uses the resource
+            bool live;
+        };
+
+        struct pass {
+            std::string name;
+            std::vector<render_resource> reads;
+            std::vector<render_resource> writes;
+            bool output;
+            std::function<void()> execute;
+            bool culled;
+        };
+
+        struct physical_target {
+            render_target_desc desc;
+            std::shared_ptr<zombye::texture> texture;
+            // the last pass of the current frame using the target
+            size_t busy_until;
+            bool used;
+            uint64_t last_used;
+        };
+
+        std::vector<resource> resources_;
+        std::vector<pass> passes_;
+        std::vector<physical_target> targets_;
+        std::map<std::vector<std::pair<GLenum, const texture*>>, std::unique_ptr<framebuffer>> framebuffers_;
+        // timers of every pass that was profiled so far, kept across frames since their results arrive later
+        std::unordered_map<std::string, std::unique_ptr<gpu_timer>> timers_;
+        uint64_t frame_;
+        bool compiled_;
+    public:
+        render_graph() noexcept;
+        ~render_graph() noexcept;
+
+        render_graph(const render_graph& other) = delete;
+        render_graph(render_graph&& other) = delete;
+        render_graph& operator=(const render_graph& other) = delete;
+        render_graph& operator=(render_graph&& other) = delete;
+
+        // drops the passes and resources of the last frame, but keeps their textures for reuse
+        void reset();
+
+        render_resource create(const std::string& name, const render_target_desc& desc);
+        render_resource import(const std::string& name, std::shared_ptr<texture> texture);
+
+        // output passes have effects outside of the graph and are never culled
+        void add_pass(const std::string& name, std::vector<render_resource> reads, std::vector<render_resource> writes,
+            bool output, std::function<void()> execute);
+
+        void compile();
+        // runs the passes that were not culled in the order they were added. with a profiler, the cpu and gpu
+        // time of every pass is recorded as "cpu/<pass>" and "gpu/<pass>", the gpu times a few frames late.
+        void execute(profiler* profiler = nullptr);
+
+        // only valid for resources a pass that was not culled uses, while the passes execute
+        texture& target(render_resource resource) const;
+        // a framebuffer with the targets of the resources attached, which is kept as long as its textures are.
+        // color attachments are drawn to in the order they are listed.
+        zombye::framebuffer& framebuffer_of(std::initializer_list<std::pair<GLenum, render_resource>> attachments);
+
+        // the passes, the lifetimes of the resources and the textures they were assigned
+        std::string describe() const;
+        // the bytes of all transient targets without and with sharing textures
+        std::pair<uint64_t, uint64_t> transient_bytes() const;
+
+    private:
+        static uint64_t size(const render_target_desc& desc) noexcept;
+    };
+}
+
+#endif
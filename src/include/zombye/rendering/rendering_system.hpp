@@ -9,35 +9,73 @@
 #include <SDL2/SDL.h>
 
 #include <zombye/rendering/buffer.hpp>
+#include <zombye/rendering/stream_buffer.hpp>
+#include <zombye/rendering/geometry_arena.hpp>
+#include <zombye/rendering/gl_backend.hpp>
+#include <zombye/rendering/gpu_timer.hpp>
+#include <zombye/rendering/light_culler.hpp>
+#include <zombye/rendering/material_table.hpp>
 #include <zombye/rendering/mesh_manager.hpp>
+#include <zombye/rendering/occlusion_culler.hpp>
+#include <zombye/rendering/render_commands.hpp>
+#include <zombye/rendering/render_graph.hpp>
 #include <zombye/rendering/shader.hpp>
 #include <zombye/rendering/shader_manager.hpp>
 #include <zombye/rendering/skeleton_manager.hpp>
 #include <zombye/rendering/skinned_mesh_manager.hpp>
 #include <zombye/rendering/texture.hpp>
+#include <zombye/rendering/texture_array_manager.hpp>
 #include <zombye/rendering/texture_manager.hpp>
 #include <zombye/rendering/vertex_array.hpp>
 #include <zombye/rendering/vertex_layout.hpp>
 
 namespace zombye {
     class game;
+    class entity;
     class animation_component;
     class camera_component;
     class light_component;
     class directional_light_component;
     class framebuffer;
+    class mesh;
     class program;
+    class program_cache;
     class screen_quad;
     class staticmesh_component;
     class shadow_component;
+    class static_batch_component;
+    class static_batcher;
+    class skinned_mesh;
+    class thread_pool;
 }
 
 namespace zombye {
-    struct light_attributes {
-        glm::vec3 position;
-        glm::vec3 color;
-        float radius;
-        float exponent;
+    // moment filtering of the directional shadow map. none samples the unblurred 16 bit moments directly,
+    // vsm blurs 32 bit moments at full resolution, vsm16 and evsm blur 16 bit moments at half resolution.
+    enum class shadow_filter {
+        none,
+        vsm,
+        vsm16,
+        evsm
+    };
+
+    struct shadow_cache_statistics {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t invalidations = 0;
+        // hits and misses in frames in which the cascade followed the camera
+        uint64_t moving_hits = 0;
+        uint64_t moving_misses = 0;
+        // static regions that were moved because the cascade left them
+        uint64_t recenters = 0;
+    };
+
+    // vertex and index memory of all loaded meshes. uncompressed_bytes is what the meshes would take with
+    // interleaved float vertices and 32 bit indices, plus the float position stream of static meshes.
+    struct mesh_memory_statistics {
+        uint64_t meshes = 0;
+        uint64_t uncompressed_bytes = 0;
+        uint64_t gpu_bytes = 0;
     };
 
     class rendering_system {
@@ -47,6 +85,8 @@ namespace zombye {
         friend class light_component;
         friend class staticmesh_component;
         friend class shadow_component;
+        friend class static_batch_component;
+        friend class static_batcher;
 
         game& game_;
         SDL_Window* window_;
@@ -61,12 +101,33 @@ namespace zombye {
         std::vector<staticmesh_component*> staticmesh_components_;
         std::vector<shadow_component*> shadow_components_;
 
+        std::unique_ptr<program_cache> program_cache_;
         std::unique_ptr<program> animation_program_;
         std::unique_ptr<program> staticmesh_program_;
+        std::unique_ptr<program> skinning_program_;
+        vertex_layout skinned_stream_layout_;
+        std::unique_ptr<vertex_buffer> skinned_streams_[4];
+        size_t skinned_vertex_capacity_;
+        // the first vertex of every animation component in the skinned streams, or -1 if it is not drawn this
+        // frame. only drawn components are skinned and packed into the streams.
+        std::vector<int32_t> skinned_base_vertices_;
+        size_t skinned_vertex_count_;
+        std::unique_ptr<texture_stream_buffer> pose_buffer_;
+        std::unique_ptr<texture> pose_texture_;
+        std::vector<glm::mat4> pose_data_;
         vertex_layout skinnedmesh_layout_;
         vertex_layout staticmesh_layout_;
+        vertex_layout packed_mesh_layouts_[4];
+        vertex_layout depth_layout_;
+        vertex_layout half_depth_layout_;
+        vertex_layout mesh_depth_layouts_[2];
+        mesh_memory_statistics mesh_memory_statistics_;
+        std::unique_ptr<zombye::geometry_arena> geometry_arena_;
+        std::unique_ptr<static_batcher> static_batcher_;
         zombye::mesh_manager mesh_manager_;
         zombye::texture_manager texture_manager_;
+        zombye::texture_array_manager texture_array_manager_;
+        std::unique_ptr<zombye::material_table> material_table_;
         zombye::shader_manager shader_manager_;
         zombye::skinned_mesh_manager skinned_mesh_manager_;
         zombye::skeleton_manager skeleton_manager_;
@@ -74,19 +135,57 @@ namespace zombye {
 
         glm::mat4 ortho_projection_;
 
-        std::unique_ptr<framebuffer> g_buffer_;
+        std::unique_ptr<render_graph> render_graph_;
+        // the albedo, normal, specular and depth targets of the current frame
+        render_resource g_buffer_[4];
+        // the internal formats of the g-buffer targets. octahedral normals are stored in two unsigned channels.
+        GLenum g_buffer_formats_[4];
+        bool octahedral_normals_;
+        std::string render_graph_description_;
+        // with dynamic resolution the g-buffer and lighting cover only the lower left viewport_width_ *
+        // viewport_height_ texels of the full size targets, and the lit scene is upscaled to the backbuffer
+        bool dynamic_resolution_;
+        float resolution_scale_;
+        float min_resolution_scale_;
+        float target_gpu_milliseconds_;
+        GLsizei viewport_width_;
+        GLsizei viewport_height_;
+        render_resource scene_color_;
+        std::unique_ptr<gpu_timer> frame_timer_;
         std::unique_ptr<program> screen_quad_program_;
         std::vector<std::unique_ptr<screen_quad>> debug_screen_quads_;
         std::unique_ptr<screen_quad> screen_quad_;
         std::unique_ptr<program> composition_program_;
 
+        static constexpr int max_shadow_cascades = 4;
         int shadow_resolution_;
-        std::unique_ptr<framebuffer> shadow_map_;
-        glm::mat4 shadow_projection_;
+        int shadow_cascades_;
+        float shadow_distance_;
+        shadow_filter shadow_filter_;
+        int shadow_blur_resolution_;
+        bool shadow_casting_;
+        GLenum shadow_moment_format_;
+        std::shared_ptr<texture> shadow_moments_;
+        std::unique_ptr<framebuffer> static_shadow_map_;
+        std::vector<glm::mat4> static_shadow_projections_;
+        // light space region of every static layer: the center and half its size. a region is larger than its
+        // cascade by a guard band and only moves when the cascade leaves it.
+        std::vector<glm::vec4> static_shadow_bounds_;
+        std::vector<glm::mat4> static_shadow_regions_;
+        std::vector<bool> moved_shadow_layers_;
+        int static_shadow_guard_;
+        int static_shadow_resolution_;
+        std::vector<bool> dynamic_shadow_layers_;
+        std::vector<bool> updated_shadow_layers_;
+        bool static_shadows_dirty_;
+        shadow_cache_statistics shadow_cache_statistics_;
+        glm::mat4 shadow_view_;
+        std::vector<glm::mat4> shadow_projections_;
+        std::vector<float> cascade_splits_;
+        std::vector<glm::vec4> cascade_bounds_;
         std::unique_ptr<program> shadow_staticmesh_program_;
-        std::unique_ptr<program> shadow_animation_program_;
 
-        std::unique_ptr<framebuffer> shadow_map_blured_;
+        std::shared_ptr<texture> shadow_filtered_;
         std::unique_ptr<program> shadow_blur_program_;
 
         std::unique_ptr<program> skybox_program_;
@@ -97,11 +196,45 @@ namespace zombye {
         vertex_layout light_volume_layout_;
 
         std::unique_ptr<program> point_light_program_;
-        std::shared_ptr<const mesh> point_light_volume_;
-        std::unique_ptr<vertex_buffer> point_light_instance_data_;
+        std::unique_ptr<light_culler> light_culler_;
+
+        std::unique_ptr<occlusion_culler> occlusion_culler_;
+        std::vector<occluder> occluders_;
+        occlusion_statistics occlusion_statistics_;
+        std::unique_ptr<texture> occlusion_texture_;
+        std::unique_ptr<screen_quad> occlusion_debug_quad_;
 
         std::unique_ptr<program> directional_light_program_;
 
+        std::unique_ptr<thread_pool> worker_pool_;
+        std::vector<shadow_command<mesh>> shadow_staticmesh_commands_;
+        std::vector<shadow_command<skinned_mesh>> shadow_animation_commands_;
+        std::vector<geometry_command<mesh>> staticmesh_commands_;
+        std::vector<geometry_command<skinned_mesh>> animation_commands_;
+        std::vector<light_attributes> point_light_instances_;
+        std::vector<draw_data> draw_data_;
+        std::unique_ptr<texture_stream_buffer> draw_data_buffer_;
+        std::unique_ptr<texture> draw_data_texture_;
+        // the draw data index and material id of every static mesh draw. the first records belong to the
+        // objects and carry no material, so passes drawing whole objects index them with the draw.
+        std::vector<glm::ivec2> draw_records_;
+        std::unique_ptr<texture_stream_buffer> draw_record_buffer_;
+        std::unique_ptr<texture> draw_record_texture_;
+        bool multi_draw_indirect_;
+        std::unique_ptr<indirect_stream_buffer> indirect_buffer_;
+        intptr_t indirect_offset_;
+        std::vector<batch_entry> batch_entries_;
+        std::vector<draw_elements_indirect_command> indirect_commands_;
+        std::vector<draw_batch> geometry_batches_;
+        std::vector<draw_batch> shadow_batches_[max_shadow_cascades][2];
+        float lod_pixel_error_;
+        float shadow_lod_bias_;
+        float lod_hysteresis_;
+
+        gl_statistics frame_statistics_;
+        gl_statistics total_statistics_;
+        uint64_t frame_count_;
+
     public:
         rendering_system(game& game, SDL_Window* window);
         rendering_system(const rendering_system& other) = delete;
@@ -156,21 +289,116 @@ namespace zombye {
             return staticmesh_layout_;
         }
 
+        // layout of meshes with a position stream and a packed_attributes stream, indexed by the
+        // devtools::vertex_format_bits of the mesh
+        auto& packed_mesh_layout(uint32_t vertex_format) noexcept {
+            return packed_mesh_layouts_[vertex_format & 3];
+        }
+
+        // position only layout for depth and shadow passes
+        auto& depth_layout(bool half_positions = false) noexcept {
+            return half_positions ? half_depth_layout_ : depth_layout_;
+        }
+
+        // the packed mesh layouts read the draw id stream of the geometry arena as a third buffer. the depth
+        // layout of static meshes reads it as the second one.
+        auto& mesh_depth_layout(bool half_positions = false) noexcept {
+            return mesh_depth_layouts_[half_positions ? 1 : 0];
+        }
+
+        auto& geometry_arena() noexcept {
+            return *geometry_arena_;
+        }
+
+        // skinned meshes are skinned once per frame into four de-interleaved streams of position, texcoord,
+        // normal and tangent. the depth passes only fetch the position stream.
+        auto& skinned_stream_layout() noexcept {
+            return skinned_stream_layout_;
+        }
+
+        auto skinned_streams() const noexcept {
+            return static_cast<const std::unique_ptr<vertex_buffer>*>(skinned_streams_);
+        }
+
         auto& texture_manager() noexcept {
             return texture_manager_;
         }
 
+        auto& texture_array_manager() noexcept {
+            return texture_array_manager_;
+        }
+
+        auto& material_table() noexcept {
+            return *material_table_;
+        }
+
         auto active_point_lights() const {
             return light_components_.size();
         }
 
+        auto& shadow_cache() const noexcept {
+            return shadow_cache_statistics_;
+        }
+
+        // culling in the camera pass of the last frame. zero when occlusion culling is disabled.
+        occlusion_statistics occlusion() const noexcept {
+            return occlusion_culler_ ? occlusion_culler_->statistics() : occlusion_statistics{};
+        }
+
+        // zero when texture streaming is disabled
+        texture_streaming_statistics texture_streaming() noexcept {
+            auto streamer = texture_manager_.streamer();
+            return streamer ? streamer->statistics() : texture_streaming_statistics{};
+        }
+
+        auto& mesh_memory() const noexcept {
+            return mesh_memory_statistics_;
+        }
+
+        void record_mesh_memory(uint64_t uncompressed_bytes, uint64_t gpu_bytes) noexcept {
+            ++mesh_memory_statistics_.meshes;
+            mesh_memory_statistics_.uncompressed_bytes += uncompressed_bytes;
+            mesh_memory_statistics_.gpu_bytes += gpu_bytes;
+        }
+
+        // called by entity whenever its transform changed
+        void transform_changed(entity& entity);
+
+        // gl work recorded for the last finished frame. only filled in when the null backend is active.
+        const gl_statistics& frame_statistics() const noexcept {
+            return frame_statistics_;
+        }
+
+        // the fraction of the window width and height the scene is rendered at
+        float resolution_scale() const noexcept {
+            return resolution_scale_;
+        }
+
     private:
+        void record_commands(const camera_component* camera, float delta_time);
+        void fit_shadow_cascades(const camera_component& camera, const glm::vec3& light_direction);
+        void invalidate_static_shadows() noexcept;
+        void invalidate_static_batches() noexcept;
+        static bool is_dynamic_caster(entity& entity);
         void render_debug_screen_quads() const;
+        void render_occlusion_buffer();
         void render_screen_quad();
-        void render_shadowmap();
-        void apply_gaussian_blur();
+        void build_draw_batches();
+        // requests the texture levels the draws of the frame need and lets the streamer upload them
+        void stream_textures();
+        void append_batches(std::vector<draw_batch>& batches);
+        void draw_batches(const std::vector<draw_batch>& batches, program& program, bool depth) const;
+        void skin_meshes();
+        void render_shadowmap(render_resource depth, render_resource moments);
+        void filter_shadowmap(render_resource blurred, render_resource filtered);
+        void render_geometry(const glm::mat4& projection_view, const glm::vec3& view_vector);
+        const texture& shadow_texture() const;
         void render_skybox() const;
-        void render_lights() const;
+        // the directional lights overwrite the target, the point lights are blended onto them
+        void render_lights(bool point_lights) const;
+        void render_upscale() const;
+        // picks the resolution scale from the last measured gpu frame time
+        void update_resolution_scale();
         void render_directional_lights(const camera_component& camera) const;
         void render_point_lights(const camera_component& camera) const;
         float calculate_point_light_extend(const light_component& light) const;
@@ -189,6 +417,8 @@ namespace zombye {
         void unregister_component(staticmesh_component* component);
         void register_component(shadow_component* component);
         void unregister_component(shadow_component* component);
+        void register_component(static_batch_component* component);
+        void unregister_component(static_batch_component* component);
     };
 }
 
@@ -6,10 +6,17 @@
 #include <GL/glew.h>
 
 namespace zombye {
+    // the source is compiled when a program links the shader for the first time, so programs loaded from the
+    // program cache never compile their shaders. compilation is only issued there, its status is checked once
+    // the program linking it is finished.
     class shader {
         friend class program;
 
-        GLuint id_;
+        std::string name_;
+        GLenum type_;
+        std::string source_;
+        mutable GLuint id_;
+        mutable bool checked_;
     public:
         shader(const std::string& name, GLenum type, const std::string& source);
         shader(const shader& other) = delete;
@@ -17,6 +24,22 @@ namespace zombye {
         ~shader() noexcept;
         shader& operator=(const shader& other) = delete;
         shader& operator=(shader&& other) noexcept;
+
+        auto& name() const noexcept {
+            return name_;
+        }
+
+        auto type() const noexcept {
+            return type_;
+        }
+
+        auto& source() const noexcept {
+            return source_;
+        }
+
+    private:
+        GLuint compile() const;
+        void check() const;
     };
 }
 
@@ -3,12 +3,15 @@
 
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include <zombye/utils/cached_resource_manager.hpp>
 
 namespace zombye {
     class game;
     class shader;
+    class thread_pool;
 }
 
 namespace zombye {
@@ -18,9 +21,16 @@ namespace zombye {
         friend class cached_resource_manager<const shader, shader_manager>;
 
         game& game_;
+        std::unordered_map<std::string, std::string> sources_;
     public:
         shader_manager(game& game) noexcept;
         ~shader_manager() noexcept = default;
+
+        // reads the sources of names on the worker threads. the next load of each name takes the read source
+        // instead of reading the file again.
+        void preload(const std::vector<std::string>& names, thread_pool& pool);
+        // drops preloaded sources that were never loaded
+        void clear_preloaded() noexcept;
     protected:
         shader_ptr load_new(const std::string& name, GLenum type);
     };
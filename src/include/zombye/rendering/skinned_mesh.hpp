@@ -26,10 +26,17 @@ namespace zombye {
 
     class skinned_mesh {
         std::vector<submesh> submeshes_;
+        std::vector<mesh_lod> lods_;
         vertex_array vao_;
+        vertex_array skinned_vao_;
+        vertex_array skinned_depth_vao_;
         vertex_buffer vbo_;
         index_buffer ibo_;
+        size_t vertex_count_;
+        uint64_t index_count_;
+        GLenum index_type_;
         bool parallax_mapping_;
+        bounding_box bounds_;
     public:
         skinned_mesh(rendering_system& rendering_system, const std::vector<char>& source, const std::string& file_name) noexcept;
         skinned_mesh(const skinned_mesh& other) = delete;
@@ -39,14 +46,38 @@ namespace zombye {
         skinned_mesh& operator=(skinned_mesh&& other) noexcept = default;
 
         void draw() const noexcept;
+        // runs every vertex through the bound skinning program as a point, for capturing with transform feedback
+        void skin() const noexcept;
+        // draws the skinned vertices stored at base_vertex in the shared skinned streams of the renderer. all
+        // levels of detail index the same skinned vertices.
+        void draw_skinned(GLint base_vertex, size_t lod = 0) const noexcept;
+        // like draw_skinned, but only fetches the skinned positions and draws all submeshes at once
+        void draw_skinned_depth(GLint base_vertex, size_t lod = 0) const noexcept;
 
         auto& vao() const noexcept {
             return vao_;
         }
 
+        auto& lods() const noexcept {
+            return lods_;
+        }
+
+        auto& submeshes() const noexcept {
+            return submeshes_;
+        }
+
+        auto vertex_count() const noexcept {
+            return vertex_count_;
+        }
+
         auto parallax_mapping() const {
             return parallax_mapping_;
         }
+
+        // bounds of the bind pose
+        auto& bounds() const noexcept {
+            return bounds_;
+        }
     };
 }
 
@@ -0,0 +1,26 @@
+#ifndef __ZOMBYE_STATIC_BATCH_COMPONENT_HPP__
+#define __ZOMBYE_STATIC_BATCH_COMPONENT_HPP__
+
+#include <zombye/ecs/component.hpp>
+#include <zombye/ecs/reflective.hpp>
+
+namespace zombye {
+	class entity;
+	class game;
+}
+
+namespace zombye {
+	// marks the static mesh of an entity that never moves for static batching. it is merged with the other
+	// marked meshes nearby into one mesh, which is rebuilt whenever a marked entity moves.
+	class static_batch_component : public reflective<static_batch_component, component> {
+		friend class reflective<static_batch_component, component>;
+
+	public:
+		static_batch_component(game& game, entity& owner);
+		~static_batch_component() noexcept;
+
+		static void register_at_script_engine(game& game);
+	};
+}
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef __ZOMBYE_STATIC_BATCHER_HPP__
+#define __ZOMBYE_STATIC_BATCHER_HPP__
+
+#include <memory>
+#include <vector>
+
+#include <zombye/rendering/mesh.hpp>
+
+namespace zombye {
+    class game;
+    class rendering_system;
+    class staticmesh_component;
+}
+
+namespace zombye {
+    // the merged static meshes of one cell of the chunk grid. the vertices are in world space, so the chunk is
+    // drawn with the identity transform and its bounds are the world space bounds of its pieces.
+    struct static_chunk {
+        std::shared_ptr<const zombye::mesh> mesh;
+        lod_state lod;
+    };
+
+    // merges the static meshes of entities with a static_batch_component into one mesh per chunk of the world,
+    // so a dense environment is drawn with a draw per chunk and texture set instead of one per piece. pieces
+    // are assigned to the chunk their bounds center is in, with and without parallax mapping separately.
+    //
+    // level l of a chunk draws every piece with its level l, or its coarsest level if it has fewer. its error
+    // is the largest world space error of these levels.
+    class static_batcher {
+        game& game_;
+        rendering_system& rendering_system_;
+        float chunk_size_;
+        bool dirty_;
+        std::vector<static_chunk> chunks_;
+
+    public:
+        static_batcher(game& game, rendering_system& rendering_system, float chunk_size) noexcept;
+        ~static_batcher() noexcept = default;
+
+        static_batcher(const static_batcher& other) = delete;
+        static_batcher(static_batcher&& other) = delete;
+        static_batcher& operator=(const static_batcher& other) = delete;
+        static_batcher& operator=(static_batcher&& other) = delete;
+
+        // called when a marked piece was added, removed, moved or got another mesh
+        void invalidate() noexcept {
+            dirty_ = true;
+        }
+
+        // rebuilds the chunks if they were invalidated since the last call and flags the merged components
+        void update(const std::vector<staticmesh_component*>& components);
+
+        auto& chunks() noexcept {
+            return chunks_;
+        }
+    };
+}
+
+#endif
@@ -7,6 +7,7 @@
 
 #include <zombye/ecs/component.hpp>
 #include <zombye/ecs/reflective.hpp>
+#include <zombye/rendering/mesh.hpp>
 
 namespace zombye {
     class entity;
@@ -19,6 +20,8 @@ namespace zombye {
         friend class reflective<staticmesh_component, component>;
 
         std::shared_ptr<const zombye::mesh> mesh_;
+        lod_state lod_;
+        bool batched_;
     public:
         staticmesh_component(game& game, entity& owner, const std::string& mesh);
         ~staticmesh_component() noexcept;
@@ -31,6 +34,16 @@ namespace zombye {
 
         void load(const std::string& mesh);
 
+        // updated by the rendering system when commands are recorded
+        auto& lod() noexcept {
+            return lod_;
+        }
+
+        // set by the static batcher while the mesh is drawn as part of a static chunk
+        auto& batched() noexcept {
+            return batched_;
+        }
+
         static void register_at_script_engine(game& game);
     private:
         staticmesh_component(game& game, entity& owner);
@@ -0,0 +1,171 @@
+#ifndef __ZOMBYE_STREAM_BUFFER_HPP__
+#define __ZOMBYE_STREAM_BUFFER_HPP__
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include <GL/glew.h>
+
+#include <zombye/rendering/gl_backend.hpp>
+
+namespace zombye {
+    class texture;
+}
+
+namespace zombye {
+    // a buffer for data that is rewritten every frame. the storage is split into three regions, so the cpu
+    // fills one region while the gpu still reads the ones of the two previous frames. with ARB_buffer_storage
+    // the storage is mapped once for the lifetime of the buffer and a fence per region keeps the cpu from
+    // overwriting data the gpu has not consumed yet. without it every frame orphans the storage and writes
+    // with glBufferSubData, so the driver can hand out fresh memory instead of stalling on the old one.
+    //
+    // texture buffers can only view a part of the storage with ARB_texture_buffer_range. without it they
+    // orphan as well and must be written once per frame, so their data always starts at offset 0.
+    //
+    // a write that does not fit into the region grows the storage, which creates a new buffer object. what
+    // a write returned has to be bound before the next write, and vertex arrays have to be set up again
+    // when generation() changed.
+    template <GLenum target>
+    class stream_buffer {
+        static const size_t region_count = 3;
+        static const size_t default_alignment = target == GL_ARRAY_BUFFER ? 16 : 256;
+
+        GLuint id_;
+        size_t region_size_;
+        size_t region_;
+        size_t head_;
+        bool persistent_;
+        char* mapped_;
+        GLsync fences_[region_count];
+        uint32_t generation_;
+
+    public:
+        explicit stream_buffer(size_t region_size) noexcept
+        : id_{0}, region_size_{align(std::max(region_size, size_t{1}), 256)}, region_{0}, head_{0},
+        persistent_{gl_caps().buffer_storage && (target != GL_TEXTURE_BUFFER || gl_caps().texture_buffer_range)},
+        mapped_{nullptr}, fences_{}, generation_{0} {
+            allocate();
+        }
+
+        ~stream_buffer() noexcept {
+            release();
+        }
+
+        stream_buffer(const stream_buffer& other) = delete;
+        stream_buffer(stream_buffer&& other) = delete;
+        stream_buffer& operator=(const stream_buffer& other) = delete;
+        stream_buffer& operator=(stream_buffer&& other) = delete;
+
+        // moves on to the next region. must be called once per frame before the first write, after the
+        // draw calls reading the previous region have been issued.
+        void next_frame() noexcept {
+            if (persistent_) {
+                fences_[region_] = gl.fence_sync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+                region_ = (region_ + 1) % region_count;
+                wait(region_);
+            } else {
+                gl.bind_buffer(target, id_);
+                gl.buffer_data(target, region_size_, nullptr, GL_STREAM_DRAW);
+            }
+            head_ = 0;
+        }
+
+        // copies size bytes into the current region and returns their offset in the buffer, which is a
+        // multiple of alignment
+        intptr_t write(const void* data, size_t size, size_t alignment = default_alignment) noexcept {
+            auto offset = align(region_base() + head_, alignment);
+            if (offset + size > region_base() + region_size_) {
+                region_size_ = align(std::max(2 * region_size_, size + alignment), 256);
+                release();
+                allocate();
+                offset = align(region_base(), alignment);
+            }
+            if (persistent_) {
+                std::memcpy(mapped_ + offset, data, size);
+            } else {
+                gl.bind_buffer(target, id_);
+                gl.buffer_sub_data(target, offset, size, data);
+            }
+            head_ = offset + size - region_base();
+            return offset;
+        }
+
+        void bind() const noexcept {
+            gl.bind_buffer(target, id_);
+        }
+
+        // binds a part of the buffer to an indexed target like GL_UNIFORM_BUFFER
+        void bind_range(GLenum indexed_target, GLuint index, intptr_t offset, size_t size) const noexcept {
+            gl.bind_buffer_range(indexed_target, index, id_, offset, size);
+        }
+
+        auto generation() const noexcept {
+            return generation_;
+        }
+
+        auto persistent() const noexcept {
+            return persistent_;
+        }
+
+    private:
+        friend class texture;
+
+        static size_t align(size_t value, size_t alignment) noexcept {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+
+        size_t region_base() const noexcept {
+            return persistent_ ? region_ * region_size_ : 0;
+        }
+
+        void allocate() noexcept {
+            gl.gen_buffers(1, &id_);
+            gl.bind_buffer(target, id_);
+            if (persistent_) {
+                auto flags = GLbitfield{GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT};
+                gl.buffer_storage(target, region_count * region_size_, nullptr, flags);
+                mapped_ = static_cast<char*>(gl.map_buffer_range(target, 0, region_count * region_size_, flags));
+            } else {
+                gl.buffer_data(target, region_size_, nullptr, GL_STREAM_DRAW);
+            }
+            region_ = 0;
+            head_ = 0;
+            ++generation_;
+        }
+
+        // draw calls already issued keep the old storage alive, so it can go without waiting for them
+        void release() noexcept {
+            for (auto i = size_t{0}; i < region_count; ++i) {
+                if (fences_[i]) {
+                    gl.delete_sync(fences_[i]);
+                    fences_[i] = nullptr;
+                }
+            }
+            if (mapped_) {
+                gl.bind_buffer(target, id_);
+                gl.unmap_buffer(target);
+                mapped_ = nullptr;
+            }
+            gl.delete_buffers(1, &id_);
+            id_ = 0;
+        }
+
+        void wait(size_t region) noexcept {
+            if (!fences_[region]) {
+                return;
+            }
+            while (gl.client_wait_sync(fences_[region], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED) {
+            }
+            gl.delete_sync(fences_[region]);
+            fences_[region] = nullptr;
+        }
+    };
+
+    using vertex_stream_buffer = stream_buffer<GL_ARRAY_BUFFER>;
+    using texture_stream_buffer = stream_buffer<GL_TEXTURE_BUFFER>;
+    using uniform_stream_buffer = stream_buffer<GL_UNIFORM_BUFFER>;
+    using indirect_stream_buffer = stream_buffer<GL_DRAW_INDIRECT_BUFFER>;
+}
+
+#endif
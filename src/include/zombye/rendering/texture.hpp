@@ -2,7 +2,11 @@
 #define __ZOMBYE_TEXTURE_HPP__
 
 #include <GL/glew.h>
-#include <gli/gli.hpp>
+#include <glm/glm.hpp>
+
+#include <zombye/rendering/buffer.hpp>
+#include <zombye/rendering/stream_buffer.hpp>
+#include <zombye/utils/load_dds.hpp>
 
 namespace zombye {
     class texture {
@@ -11,11 +15,21 @@ namespace zombye {
         GLenum target_;
         size_t width_;
         size_t height_;
+        size_t layers_;
 
     public:
-        texture(const gli::texture2D& texture) noexcept;
+        // uploads the levels from first_level on and samples only those, until finer levels are streamed in
+        // with upload_level and made visible with base_level
+        texture(const dds_image& image, size_t first_level = 0) noexcept;
+        // an array of layers textures of the same format and size. the levels from first_level on are allocated
+        // without data, the finer ones with allocate_level.
+        texture(dds_format format, glm::uvec2 dimensions, size_t levels, size_t layers, size_t first_level) noexcept;
         texture(GLenum target, GLint internal_format, GLsizei width, GLsizei height, GLenum format, GLenum type, const GLvoid* data = nullptr) noexcept;
         texture(GLint internal_format, GLsizei width, GLsizei height, GLenum format, GLenum type, const GLvoid* data = nullptr) noexcept;
+        texture(GLenum target, GLint internal_format, GLsizei width, GLsizei height, GLsizei layers, GLenum format, GLenum type, const GLvoid* data) noexcept;
+        // views the content of the buffer as a one dimensional texture without filtering, read with texelFetch
+        texture(GLenum internal_format, const texture_buffer& buffer) noexcept;
+        texture(GLenum internal_format, const texture_stream_buffer& buffer) noexcept;
         ~texture();
 
         texture(const texture& rhs) = delete;
@@ -26,6 +40,22 @@ namespace zombye {
 
         void bind(uint32_t unit) const noexcept;
 
+        // specifies a single level of size bytes straight from data. zero dimensions without data free the
+        // storage of the level.
+        void upload_level(dds_format format, size_t level, glm::uvec2 dimensions, const void* data,
+            size_t size) noexcept;
+        // fills a level of a single layer of an array
+        void upload_layer(dds_format format, size_t level, size_t layer, glm::uvec2 dimensions, const void* data,
+            size_t size) noexcept;
+        // specifies a level of every layer without data. zero dimensions free the storage of the level.
+        void allocate_level(dds_format format, size_t level, glm::uvec2 dimensions) noexcept;
+        // the finest level that is sampled
+        void base_level(size_t level) noexcept;
+
+        // views size bytes at offset of the buffer, which is what a write of the current frame returned.
+        // without ARB_texture_buffer_range the whole buffer is viewed and offset is always 0.
+        void view(GLenum internal_format, const texture_stream_buffer& buffer, intptr_t offset, size_t size) noexcept;
+
         size_t width() const noexcept {
             return width_;
         }
@@ -34,6 +64,10 @@ namespace zombye {
             return height_;
         }
 
+        size_t layers() const noexcept {
+            return layers_;
+        }
+
         void apply_settings() const noexcept;
 
     private:
@@ -0,0 +1,79 @@
+#ifndef __ZOMBYE_TEXTURE_ARRAY_MANAGER_HPP__
+#define __ZOMBYE_TEXTURE_ARRAY_MANAGER_HPP__
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <zombye/utils/cached_resource_manager.hpp>
+#include <zombye/utils/load_dds.hpp>
+
+namespace zombye {
+    class game;
+    class texture;
+    class texture_manager;
+}
+
+namespace zombye {
+    // a texture array holding textures of the same format, size and level count. names holds the file of
+    // every layer and is empty for free layers.
+    struct texture_array_page {
+        std::shared_ptr<texture> array;
+        std::shared_ptr<std::vector<std::string>> names;
+        dds_format format;
+        glm::uvec2 dimensions;
+        size_t levels;
+    };
+
+    // a texture loaded into a layer of an array, which is freed for the next texture of the same kind once the
+    // last user releases it
+    class texture_layer {
+        std::shared_ptr<texture_array_page> page_;
+        size_t layer_;
+    public:
+        texture_layer(std::shared_ptr<texture_array_page> page, size_t layer) noexcept;
+        ~texture_layer() noexcept;
+
+        texture_layer(const texture_layer& other) = delete;
+        texture_layer(texture_layer&& other) = delete;
+        texture_layer& operator=(const texture_layer& other) = delete;
+        texture_layer& operator=(texture_layer&& other) = delete;
+
+        const texture& array() const noexcept {
+            return *page_->array;
+        }
+
+        size_t layer() const noexcept {
+            return layer_;
+        }
+    };
+
+    using texture_layer_ptr = std::shared_ptr<const texture_layer>;
+
+    // packs the textures of static meshes into arrays, so submeshes with different textures of the same kind
+    // are drawn without binding in between. arrays of streamed textures are streamed as a whole, all of their
+    // layers at the level the finest draw of any of them requested.
+    class texture_array_manager : public cached_resource_manager<const texture_layer, texture_array_manager> {
+        friend class cached_resource_manager<const texture_layer, texture_array_manager>;
+
+        game& game_;
+        zombye::texture_manager& texture_manager_;
+        size_t layers_per_array_;
+        std::vector<std::weak_ptr<texture_array_page>> pages_;
+    public:
+        texture_array_manager(game& game, zombye::texture_manager& texture_manager) noexcept;
+        ~texture_array_manager() noexcept = default;
+
+        // the number of layers of arrays created from now on
+        void layers_per_array(size_t layers) noexcept;
+
+        // the number of live arrays
+        size_t array_count() noexcept;
+    protected:
+        texture_layer_ptr load_new(const std::string& name);
+    };
+}
+
+#endif
@@ -3,6 +3,7 @@
 
 #include <memory>
 
+#include <zombye/rendering/texture_streamer.hpp>
 #include <zombye/utils/cached_resource_manager.hpp>
 
 namespace zombye {
@@ -17,9 +18,25 @@ namespace zombye {
         friend class cached_resource_manager<const texture, texture_manager>;
 
         game& game_;
+        std::unique_ptr<texture_streamer> streamer_;
+        size_t streaming_size_;
     public:
         texture_manager(game& game) noexcept;
         ~texture_manager() noexcept = default;
+
+        // textures loaded from now on only upload their levels of at most streaming_size texels per side. the
+        // finer levels are streamed in by the returned streamer.
+        texture_streamer& enable_streaming(uint64_t budget_bytes, uint64_t upload_bytes_per_frame,
+            size_t streaming_size);
+
+        // null while streaming is disabled
+        texture_streamer* streamer() noexcept {
+            return streamer_.get();
+        }
+
+        // the coarsest level a streamed texture of image is created with, 0 while streaming is disabled or when
+        // the image has no finer levels than streaming_size texels per side
+        size_t coarse_level(const dds_image& image) const noexcept;
     protected:
         texture_ptr load_new(const std::string& name);
     };
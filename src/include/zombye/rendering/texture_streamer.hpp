@@ -0,0 +1,162 @@
+#ifndef __ZOMBYE_TEXTURE_STREAMER_HPP__
+#define __ZOMBYE_TEXTURE_STREAMER_HPP__
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <zombye/utils/load_dds.hpp>
+
+namespace zombye {
+    class asset;
+    class asset_manager;
+    class texture;
+}
+
+namespace zombye {
+    struct texture_streaming_statistics {
+        uint64_t textures = 0;
+        uint64_t resident_bytes = 0;
+        uint64_t budget_bytes = 0;
+        // levels that are being read or wait for their upload
+        uint64_t pending_uploads = 0;
+        uint64_t uploaded_levels = 0;
+        uint64_t evicted_levels = 0;
+    };
+
+    // streamed textures are created with only their coarse levels, which are never evicted. draws request the
+    // level they need on screen. a loader thread reads the dds file again, and update() uploads its finer levels
+    // straight from the file content on the rendering thread. levels are always resident from the finest one down
+    // to the coarsest, so the texture stays complete by moving its base level.
+    //
+    // the resident levels of all streamed textures share budget_bytes. when a request does not fit, the finest
+    // levels of the textures that were used least recently are evicted, but never those a draw of the current
+    // frame needs. at most upload_bytes_per_frame are uploaded per frame, but always at least one level.
+    //
+    // texture arrays are streamed like a single texture, every level covering all of their layers.
+    class texture_streamer {
+        struct level {
+            glm::uvec2 dimensions;
+            size_t size;
+        };
+
+        // the sizes of array levels cover all layers
+        struct entry {
+            std::weak_ptr<zombye::texture> texture;
+            // the file of every layer, empty for unused layers of arrays
+            std::shared_ptr<const std::vector<std::string>> names;
+            uint64_t generation;
+            dds_format format;
+            std::vector<level> levels;
+            bool array;
+            // levels from coarse_level on stay resident
+            size_t coarse_level;
+            // the finest level on the gpu
+            size_t resident_level;
+            // the finest level a draw needed in the frame last_used
+            size_t requested_level;
+            uint64_t last_used;
+            bool loading;
+            // layers were added while loading, whose levels the pending read lacks
+            bool stale;
+        };
+
+        // a level of every layer, pointing into the files of the result it belongs to
+        struct level_data {
+            size_t level;
+            std::vector<dds_level> layers;
+        };
+
+        // reads the levels in [first_level, last_level) of the files of every layer
+        struct load_request {
+            const texture* key;
+            uint64_t generation;
+            std::vector<std::string> names;
+            size_t first_level;
+            size_t last_level;
+            uint64_t bytes;
+        };
+
+        // the read levels from coarse to fine. bytes and level_count are what is still pending of the request.
+        struct load_result {
+            const texture* key;
+            uint64_t generation;
+            std::vector<std::shared_ptr<asset>> files;
+            std::deque<level_data> levels;
+            uint64_t bytes;
+            size_t level_count;
+        };
+
+        asset_manager& asset_manager_;
+        uint64_t budget_bytes_;
+        uint64_t upload_bytes_per_frame_;
+        size_t max_pending_loads_;
+
+        std::unordered_map<const texture*, entry> entries_;
+        uint64_t generation_;
+        uint64_t frame_;
+        uint64_t resident_bytes_;
+        uint64_t pending_levels_;
+        uint64_t pending_bytes_;
+        size_t pending_loads_;
+        std::deque<load_result> ready_;
+        texture_streaming_statistics statistics_;
+
+        std::mutex mutex_;
+        std::condition_variable condition_;
+        std::deque<load_request> requests_;
+        std::vector<load_result> results_;
+        bool stop_;
+        std::thread loader_;
+
+    public:
+        texture_streamer(asset_manager& asset_manager, uint64_t budget_bytes, uint64_t upload_bytes_per_frame);
+        ~texture_streamer();
+
+        texture_streamer(const texture_streamer& other) = delete;
+        texture_streamer(texture_streamer&& other) = delete;
+        texture_streamer& operator=(const texture_streamer& other) = delete;
+        texture_streamer& operator=(texture_streamer&& other) = delete;
+
+        // starts streaming a texture created from image with its levels from coarse_level on
+        void add(const std::shared_ptr<texture>& texture, const std::string& name, const dds_image& image,
+            size_t coarse_level);
+        // starts streaming an array, whose layers are read from names. levels holds the levels of one layer.
+        void add_array(const std::shared_ptr<texture>& texture, std::shared_ptr<const std::vector<std::string>> names,
+            dds_format format, const std::vector<dds_level>& levels, size_t coarse_level);
+        // an unused layer of a streamed array got a file
+        void layers_changed(const texture* texture) noexcept;
+
+        // the finest level of the texture on the gpu, 0 for textures that are not streamed
+        size_t resident_level(const texture* texture) const noexcept;
+
+        // a draw covers pixels pixels on screen with the texture. textures that are not streamed are ignored.
+        void request(const texture* texture, float pixels) noexcept;
+
+        // uploads read levels, evicts levels to stay in the budget and queues the reads of requested levels.
+        // called once per frame on the rendering thread after all requests.
+        void update();
+
+        texture_streaming_statistics statistics() const noexcept;
+
+    private:
+        // evicts levels until at most target bytes are resident. levels of textures used in the current frame
+        // are only evicted when they are finer than requested.
+        bool evict(uint64_t target);
+        void finish(load_result& result);
+        void insert(const std::shared_ptr<texture>& texture, entry entry);
+        void upload(entry& entry, texture& texture, const level_data& data);
+        void load();
+        static uint64_t resident_size(const entry& entry) noexcept;
+    };
+}
+
+#endif
@@ -21,10 +21,11 @@ namespace zombye {
         void bind() const noexcept;
         void bind_index_buffer(const index_buffer& buffer);
     private:
-        void bind_vertex_attribute(const vertex_buffer& buffer, uint32_t index, int32_t size, GLenum type,
-        bool normalized, size_t stride, intptr_t offset) const noexcept;
-        void bind_vertex_attributei(const vertex_buffer& buffer, uint32_t index, int32_t size, GLenum type,
-        size_t stride, intptr_t offset) const noexcept;
+        // the attributes read from the buffer bound to GL_ARRAY_BUFFER
+        void bind_vertex_attribute(uint32_t index, int32_t size, GLenum type, bool normalized, size_t stride,
+        intptr_t offset) const noexcept;
+        void bind_vertex_attributei(uint32_t index, int32_t size, GLenum type, size_t stride,
+        intptr_t offset) const noexcept;
     };
 }
 
@@ -8,6 +8,7 @@
 #include <GL/glew.h>
 
 #include <zombye/rendering/buffer.hpp>
+#include <zombye/rendering/stream_buffer.hpp>
 
 namespace zombye {
     class program;
@@ -45,6 +46,8 @@ namespace zombye {
         void setup_layout(const vertex_array& vertex_array, const std::unique_ptr<vertex_buffer>* buffers) noexcept;
         void setup_layout(const vertex_array& vertex_array, const vertex_buffer* buffers) noexcept;
         void setup_layout(const vertex_array& vertex_array, const vertex_buffer** buffers) noexcept;
+        // every attribute reads from the stream buffer, the offsets are relative to its start
+        void setup_layout(const vertex_array& vertex_array, const vertex_stream_buffer& buffer) noexcept;
         void setup_program(program& program, const std::string& fragcolor_name) noexcept;
     };
 }
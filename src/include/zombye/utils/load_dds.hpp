@@ -1,84 +1,251 @@
 #ifndef __ZOMBYE_LOAD_DDS_HPP__
 #define __ZOMBYE_LOAD_DDS_HPP__
 
-#include <sstream>
-
-#include <gli/gli.hpp>
-
-namespace gli {
-    inline storage load_dds(const std::vector<char>& content) {
-        std::stringstream FileIn(std::string(content.data(), content.size()));
-        assert(!FileIn.fail());
-
-        if(FileIn.fail())
-            return storage();
-
-        detail::ddsHeader HeaderDesc;
-        detail::ddsHeader10 HeaderDesc10;
-        char Magic[4];
-
-        //* Read magic number and check if valid .dds file
-        FileIn.read((char*)&Magic, sizeof(Magic));
-
-        assert(strncmp(Magic, "DDS ", 4) == 0);
-
-        // Get the surface descriptor
-        FileIn.read((char*)&HeaderDesc, sizeof(HeaderDesc));
-        if(HeaderDesc.format.flags & detail::DDPF_FOURCC && HeaderDesc.format.fourCC == detail::D3DFMT_DX10)
-            FileIn.read((char*)&HeaderDesc10, sizeof(HeaderDesc10));
-
-        gli::format Format(gli::FORMAT_NULL);
-        if(HeaderDesc.format.fourCC == detail::D3DFMT_DX10)
-            Format = detail::format_dds2gli_cast(HeaderDesc10.Format);
-        else if(HeaderDesc.format.flags & detail::DDPF_FOURCC)
-            Format = detail::format_fourcc2gli_cast(HeaderDesc.format.flags, HeaderDesc.format.fourCC);
-        else if(HeaderDesc.format.flags & detail::DDPF_RGB)
-        {
-            switch(HeaderDesc.format.bpp)
-            {
-            case 8:
-                Format = R8_UNORM;
-                break;
-            case 16:
-                Format = RG8_UNORM;
-                break;
-            case 24:
-                Format = RGB8_UNORM;
-                break;
-            case 32:
-                Format = RGBA8_UNORM;
-                break;
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace zombye {
+    enum class dds_format {
+        bc1_rgb,
+        bc1_rgba,
+        bc2,
+        bc3,
+        bc4,
+        bc5,
+        bc7,
+        rgba8,
+        bgra8,
+        rgb8,
+        bgr8
+    };
+
+    // a level of a dds file, which points into the content of the file
+    struct dds_level {
+        glm::uvec2 dimensions;
+        const char* data;
+        size_t size;
+    };
+
+    struct dds_image {
+        dds_format format;
+        std::vector<dds_level> levels;
+
+        bool compressed() const noexcept {
+            return format <= dds_format::bc7;
+        }
+
+        glm::uvec2 dimensions() const noexcept {
+            return levels.front().dimensions;
+        }
+    };
+
+    namespace detail {
+        const uint32_t dds_magic = 0x20534444;
+        const uint32_t dds_mipmap_count = 0x20000;
+        const uint32_t dds_alpha_pixels = 0x1;
+        const uint32_t dds_fourcc = 0x4;
+        const uint32_t dds_rgb = 0x40;
+        const uint32_t dds_cubemap = 0x200;
+        const uint32_t dds_volume = 0x200000;
+        const uint32_t dxgi_texture2d = 3;
+        // the largest width or height accepted. it is at least the maximum texture size of common gl drivers and
+        // keeps level counts and level sizes of untrusted headers from overflowing.
+        const uint32_t dds_max_dimension = 16384;
+
+        struct dds_pixel_format {
+            uint32_t size;
+            uint32_t flags;
+            uint32_t fourcc;
+            uint32_t bit_count;
+            uint32_t masks[4];
+        };
+
+        struct dds_header {
+            uint32_t size;
+            uint32_t flags;
+            uint32_t height;
+            uint32_t width;
+            uint32_t pitch;
+            uint32_t depth;
+            uint32_t mipmap_count;
+            uint32_t reserved[11];
+            dds_pixel_format format;
+            uint32_t caps[4];
+            uint32_t reserved2;
+        };
+
+        struct dds_header10 {
+            uint32_t format;
+            uint32_t dimension;
+            uint32_t flags;
+            uint32_t array_size;
+            uint32_t flags2;
+        };
+
+        constexpr uint32_t fourcc(char a, char b, char c, char d) {
+            return static_cast<uint32_t>(a) | static_cast<uint32_t>(b) << 8 | static_cast<uint32_t>(c) << 16
+                | static_cast<uint32_t>(d) << 24;
+        }
+
+        inline dds_format dds_fourcc_format(const dds_pixel_format& format, const std::string& file_name) {
+            switch (format.fourcc) {
+                case fourcc('D', 'X', 'T', '1'):
+                    return format.flags & dds_alpha_pixels ? dds_format::bc1_rgba : dds_format::bc1_rgb;
+                case fourcc('D', 'X', 'T', '2'):
+                case fourcc('D', 'X', 'T', '3'):
+                    return dds_format::bc2;
+                case fourcc('D', 'X', 'T', '4'):
+                case fourcc('D', 'X', 'T', '5'):
+                    return dds_format::bc3;
+                case fourcc('A', 'T', 'I', '1'):
+                case fourcc('B', 'C', '4', 'U'):
+                    return dds_format::bc4;
+                case fourcc('A', 'T', 'I', '2'):
+                case fourcc('B', 'C', '5', 'U'):
+                    return dds_format::bc5;
+                default:
+                    throw std::runtime_error(file_name + " has the unsupported dds four cc "
+                        + std::string(reinterpret_cast<const char*>(&format.fourcc), 4));
             }
         }
-        else
-            assert(0);
 
-        std::streamoff Curr = FileIn.tellg();
-        FileIn.seekg(0, std::ios_base::end);
-        std::streamoff End = FileIn.tellg();
-        FileIn.seekg(Curr, std::ios_base::beg);
+        inline dds_format dds_dxgi_format(uint32_t format, const std::string& file_name) {
+            switch (format) {
+                case 28: // R8G8B8A8_UNORM
+                case 29: // R8G8B8A8_UNORM_SRGB
+                    return dds_format::rgba8;
+                case 71: // BC1_UNORM
+                case 72: // BC1_UNORM_SRGB
+                    return dds_format::bc1_rgba;
+                case 74: // BC2_UNORM
+                case 75: // BC2_UNORM_SRGB
+                    return dds_format::bc2;
+                case 77: // BC3_UNORM
+                case 78: // BC3_UNORM_SRGB
+                    return dds_format::bc3;
+                case 80: // BC4_UNORM
+                    return dds_format::bc4;
+                case 83: // BC5_UNORM
+                    return dds_format::bc5;
+                case 87: // B8G8R8A8_UNORM
+                case 91: // B8G8R8A8_UNORM_SRGB
+                    return dds_format::bgra8;
+                case 98: // BC7_UNORM
+                case 99: // BC7_UNORM_SRGB
+                    return dds_format::bc7;
+                default:
+                    throw std::runtime_error(file_name + " has the unsupported dxgi format " + std::to_string(format));
+            }
+        }
 
-        storage::size_type const MipMapCount = (HeaderDesc.flags & detail::DDSD_MIPMAPCOUNT) ?
-            HeaderDesc.mipMapLevels : 1;
+        inline dds_format dds_rgb_format(const dds_pixel_format& format, const std::string& file_name) {
+            auto blue_first = format.masks[0] == 0xff0000 && format.masks[2] == 0xff;
+            auto red_first = format.masks[0] == 0xff && format.masks[2] == 0xff0000;
+            if (format.masks[1] == 0xff00 && (blue_first || red_first)) {
+                if (format.bit_count == 32) {
+                    return blue_first ? dds_format::bgra8 : dds_format::rgba8;
+                }
+                if (format.bit_count == 24) {
+                    return blue_first ? dds_format::bgr8 : dds_format::rgb8;
+                }
+            }
+            throw std::runtime_error(file_name + " has an unsupported " + std::to_string(format.bit_count)
+                + " bit rgb layout");
+        }
 
-        storage::size_type FaceCount(1);
-        if(HeaderDesc.cubemapFlags & detail::DDSCAPS2_CUBEMAP)
-            FaceCount = int(glm::bitCount(HeaderDesc.cubemapFlags & detail::DDSCAPS2_CUBEMAP_ALLFACES));
+        inline size_t dds_level_size(dds_format format, glm::uvec2 dimensions) noexcept {
+            auto blocks = static_cast<size_t>((dimensions.x + 3) / 4) * ((dimensions.y + 3) / 4);
+            auto pixels = static_cast<size_t>(dimensions.x) * dimensions.y;
+            switch (format) {
+                case dds_format::bc1_rgb:
+                case dds_format::bc1_rgba:
+                case dds_format::bc4:
+                    return 8 * blocks;
+                case dds_format::bc2:
+                case dds_format::bc3:
+                case dds_format::bc5:
+                case dds_format::bc7:
+                    return 16 * blocks;
+                case dds_format::rgba8:
+                case dds_format::bgra8:
+                    return 4 * pixels;
+                default:
+                    return 3 * pixels;
+            }
+        }
+    }
 
-        storage::size_type DepthCount = 1;
-        if(HeaderDesc.cubemapFlags & detail::DDSCAPS2_VOLUME)
-                DepthCount = HeaderDesc.depth;
+    // parses a dds file holding a single two dimensional texture without copying it. the levels point into
+    // data, which has to outlive the image. files with cube maps, volumes, arrays or formats the renderer can
+    // not sample are rejected.
+    inline dds_image read_dds(const char* data, size_t size, const std::string& file_name) {
+        using namespace detail;
+        auto header_size = sizeof(uint32_t) + sizeof(dds_header);
+        auto magic = uint32_t{0};
+        if (size >= sizeof(magic)) {
+            std::memcpy(&magic, data, sizeof(magic));
+        }
+        if (size < header_size || magic != dds_magic) {
+            throw std::runtime_error(file_name + " is not a dds file");
+        }
+        auto header = dds_header{};
+        std::memcpy(&header, data + sizeof(magic), sizeof(header));
+        if (header.size != sizeof(dds_header) || header.format.size != sizeof(dds_pixel_format)) {
+            throw std::runtime_error(file_name + " has an invalid dds header");
+        }
+        if ((header.caps[1] & (dds_cubemap | dds_volume)) || header.width == 0 || header.height == 0) {
+            throw std::runtime_error(file_name + " is not a two dimensional texture");
+        }
+        if (header.width > dds_max_dimension || header.height > dds_max_dimension) {
+            throw std::runtime_error(file_name + " is larger than " + std::to_string(dds_max_dimension) + " texels");
+        }
 
-        storage Storage(
-            HeaderDesc10.arraySize,
-            FaceCount,
-            MipMapCount,
-            Format,
-            storage::dimensions_type(HeaderDesc.width, HeaderDesc.height, DepthCount));
+        auto image = dds_image{};
+        if ((header.format.flags & dds_fourcc) && header.format.fourcc == fourcc('D', 'X', '1', '0')) {
+            auto header10 = dds_header10{};
+            if (size < header_size + sizeof(header10)) {
+                throw std::runtime_error(file_name + " has a truncated dx10 header");
+            }
+            std::memcpy(&header10, data + header_size, sizeof(header10));
+            header_size += sizeof(header10);
+            if (header10.dimension != dxgi_texture2d || header10.array_size > 1) {
+                throw std::runtime_error(file_name + " is not a two dimensional texture");
+            }
+            image.format = dds_dxgi_format(header10.format, file_name);
+        } else if (header.format.flags & dds_fourcc) {
+            image.format = dds_fourcc_format(header.format, file_name);
+        } else if (header.format.flags & dds_rgb) {
+            image.format = dds_rgb_format(header.format, file_name);
+        } else {
+            throw std::runtime_error(file_name + " has an unsupported pixel format");
+        }
 
-        FileIn.read((char*)Storage.data(), std::size_t(End - Curr));
+        auto max_levels = size_t{1};
+        while ((std::max(header.width, header.height) >> max_levels) > 0) {
+            ++max_levels;
+        }
+        auto level_count = size_t{1};
+        if (header.flags & dds_mipmap_count) {
+            level_count = std::min(std::max(static_cast<size_t>(header.mipmap_count), size_t{1}), max_levels);
+        }
 
-        return Storage;
+        auto offset = header_size;
+        for (auto level = size_t{0}; level < level_count; ++level) {
+            auto dimensions = glm::uvec2{std::max(header.width >> level, 1u), std::max(header.height >> level, 1u)};
+            auto level_size = dds_level_size(image.format, dimensions);
+            if (level_size > size - offset) {
+                throw std::runtime_error(file_name + " is truncated in level " + std::to_string(level));
+            }
+            image.levels.emplace_back(dds_level{dimensions, data + offset, level_size});
+            offset += level_size;
+        }
+        return image;
     }
 }
 
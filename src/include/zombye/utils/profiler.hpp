@@ -0,0 +1,65 @@
+#ifndef __ZOMBYE_PROFILER_HPP__
+#define __ZOMBYE_PROFILER_HPP__
+
+#include <chrono>
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace zombye {
+    struct profile_timing {
+        float last = 0.f;
+        float average = 0.f;
+        float maximum = 0.f;
+        // measurements in the history
+        size_t samples = 0;
+    };
+
+    // collects named cpu and gpu timings in milliseconds. every name keeps a rolling history of its last
+    // history_length measurements. with a log threshold larger than zero, every measurement above it is
+    // logged as soon as it is recorded.
+    class profiler {
+        struct history {
+            std::vector<float> samples;
+            size_t next = 0;
+            size_t count = 0;
+        };
+
+        std::map<std::string, history> histories_;
+        size_t history_length_;
+        float log_threshold_;
+    public:
+        profiler(size_t history_length, float log_threshold) noexcept;
+        ~profiler() noexcept = default;
+
+        profiler(const profiler& other) = delete;
+        profiler(profiler&& other) = delete;
+        profiler& operator=(const profiler& other) = delete;
+        profiler& operator=(profiler&& other) = delete;
+
+        void record(const std::string& name, float milliseconds);
+
+        profile_timing timing(const std::string& name) const noexcept;
+
+        // one line per name with the last, average and maximum measurement of its history
+        std::string report() const;
+    };
+
+    // records the cpu time from its construction to its destruction
+    class cpu_timer {
+        profiler& profiler_;
+        std::string name_;
+        std::chrono::steady_clock::time_point start_;
+    public:
+        cpu_timer(profiler& profiler, std::string name) noexcept;
+        ~cpu_timer() noexcept;
+
+        cpu_timer(const cpu_timer& other) = delete;
+        cpu_timer(cpu_timer&& other) = delete;
+        cpu_timer& operator=(const cpu_timer& other) = delete;
+        cpu_timer& operator=(cpu_timer&& other) = delete;
+    };
+}
+
+#endif
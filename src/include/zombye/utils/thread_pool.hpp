@@ -0,0 +1,48 @@
+#ifndef __ZOMBYE_THREAD_POOL_HPP__
+#define __ZOMBYE_THREAD_POOL_HPP__
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace zombye {
+    // persistent worker threads for data parallel work inside a frame. parallel_for splits a range into
+    // chunks, lets the calling thread work on them as well and returns once every chunk is done.
+    class thread_pool {
+        std::vector<std::thread> workers_;
+        std::mutex mutex_;
+        std::condition_variable work_available_;
+        std::condition_variable work_done_;
+
+        std::function<void(size_t, size_t)> job_;
+        size_t job_size_;
+        size_t chunk_size_;
+        size_t next_chunk_;
+        size_t pending_chunks_;
+        bool running_;
+    public:
+        // a worker_count of 0 uses one worker less than the available hardware threads
+        thread_pool(size_t worker_count = 0);
+        thread_pool(const thread_pool& other) = delete;
+        thread_pool(thread_pool&& other) = delete;
+        ~thread_pool() noexcept;
+        thread_pool& operator=(const thread_pool& other) = delete;
+        thread_pool& operator=(thread_pool&& other) = delete;
+
+        // calls function(begin, end) for consecutive sub ranges of [0, count) of at most grain elements
+        void parallel_for(size_t count, size_t grain, const std::function<void(size_t, size_t)>& function);
+
+        auto worker_count() const noexcept {
+            return workers_.size();
+        }
+
+    private:
+        void work();
+        bool run_chunk(std::unique_lock<std::mutex>& lock);
+    };
+}
+
+#endif
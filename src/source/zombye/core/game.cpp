@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include <zombye/audio/audio_system.hpp>
 #include <zombye/assets/asset.hpp>
 #include <zombye/assets/asset_loader.hpp>
@@ -18,6 +20,7 @@
 #include <zombye/physics/character_physics_component.hpp>
 #include <zombye/physics/physics_component.hpp>
 #include <zombye/physics/physics_system.hpp>
+#include <zombye/rendering/gl_backend.hpp>
 #include <zombye/physics/shapes/box_shape.hpp>
 #include <zombye/physics/shapes/triangle_mesh_shape.hpp>
 #include <zombye/rendering/animation_component.hpp>
@@ -25,6 +28,7 @@
 #include <zombye/rendering/camera_component.hpp>
 #include <zombye/rendering/directional_light_component.hpp>
 #include <zombye/rendering/no_occluder_component.hpp>
+#include <zombye/rendering/static_batch_component.hpp>
 #include <zombye/rendering/rendering_system.hpp>
 #include <zombye/rendering/light_component.hpp>
 #include <zombye/rendering/shadow_component.hpp>
@@ -35,6 +39,7 @@
 #include <zombye/utils/state_machine.hpp>
 #include <zombye/utils/logger.hpp>
 #include <zombye/utils/os.h>
+#include <zombye/utils/profiler.hpp>
 
 zombye::game::game(std::string title) : title_(title), running_(false), window_(nullptr, SDL_DestroyWindow) {
 #ifdef ZOMBYE_DEBUG
@@ -49,6 +54,10 @@ zombye::game::game(std::string title) : title_(title), running_(false), window_(
     width_ = config_system_->get("main", "width").asInt();
     height_ = config_system_->get("main", "height").asInt();
     fullscreen_ = config_system_->get("main", "fullscreen").asBool();
+    profiler_ = std::make_unique<zombye::profiler>(
+        std::max(config_system_->get("main", "profile_history_frames").asInt(), 1),
+        config_system_->get("main", "profile_log_threshold_ms").asFloat());
+    zombye::select_gl_backend(zombye::gl_backend_from_string(config_system_->get("main", "gl_backend").asString()));
 
     if (SDL_Init(SDL_INIT_EVERYTHING) != 0) {
         auto sdl_error = std::string{SDL_GetError()};
@@ -66,7 +75,10 @@ zombye::game::game(std::string title) : title_(title), running_(false), window_(
     SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
     SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 24);
 
-    auto mask = SDL_WINDOW_OPENGL | SDL_WINDOW_SHOWN | (fullscreen_ ? SDL_WINDOW_FULLSCREEN_DESKTOP : 0);
+    auto mask = SDL_WINDOW_SHOWN | (fullscreen_ ? SDL_WINDOW_FULLSCREEN_DESKTOP : 0);
+    if (zombye::active_gl_backend() == zombye::gl_backend_type::native) {
+        mask |= SDL_WINDOW_OPENGL;
+    }
 
     window_ = make_window(title_.c_str(), SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, width_,
         height_, mask);
@@ -90,6 +102,10 @@ zombye::game::game(std::string title) : title_(title), running_(false), window_(
 }
 
 zombye::game::~game() {
+    auto report = profiler_->report();
+    if (!report.empty()) {
+        log("frame timings:\n" + report);
+    }
     log("quit game");
 
     SDL_Quit();
@@ -133,13 +149,25 @@ void zombye::game::run() {
 
         input_system_->update_continuous();
 
-        physics_system_->update(delta_time);
-        gameplay_system_->update(delta_time);
-        animation_system_->update(delta_time);
+        {
+            cpu_timer timer{*profiler_, "cpu/physics"};
+            physics_system_->update(delta_time);
+        }
+        {
+            cpu_timer timer{*profiler_, "cpu/gameplay"};
+            gameplay_system_->update(delta_time);
+        }
+        {
+            cpu_timer timer{*profiler_, "cpu/animation"};
+            animation_system_->update(delta_time);
+        }
 
-        rendering_system_->begin_scene();
-        rendering_system_->update(delta_time);
-        physics_system_->debug_draw();
+        {
+            cpu_timer timer{*profiler_, "cpu/rendering"};
+            rendering_system_->begin_scene();
+            rendering_system_->update(delta_time);
+            physics_system_->debug_draw();
+        }
         rendering_system_->end_scene();
 
         entity_manager_->clear();
@@ -161,6 +189,7 @@ void zombye::game::register_components() {
     rtti_manager::register_type(animation_component::type_rtti());
     rtti_manager::register_type(light_component::type_rtti());
     rtti_manager::register_type(staticmesh_component::type_rtti());
+    rtti_manager::register_type(static_batch_component::type_rtti());
 
     animation_component::register_at_script_engine(*this);
     camera_component::register_at_script_engine(*this);
@@ -175,6 +204,7 @@ void zombye::game::register_components() {
     staticmesh_component::register_at_script_engine(*this);
     triangle_mesh_shape::register_at_script_engine(*this);
     no_occluder_component::register_at_script_engine(*this);
+    static_batch_component::register_at_script_engine(*this);
 }
 
 int zombye::game::width() const {
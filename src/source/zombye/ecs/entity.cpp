@@ -3,6 +3,7 @@
 
 #include <zombye/core/game.hpp>
 #include <zombye/ecs/entity.hpp>
+#include <zombye/rendering/rendering_system.hpp>
 
 namespace zombye {
     unsigned long entity::next_id_ = 0;
@@ -10,6 +11,32 @@ namespace zombye {
     entity::entity(game& game, glm::vec3 position, glm::quat rotation, glm::vec3 scalation) noexcept
     : game_(game), id_(++next_id_), position_(position), rotation_(rotation), scalation_(scalation) { }
 
+    // the setters only notify the rendering system about real changes, because physics writes back the
+    // transform of every body each frame, even when it is at rest.
+    void entity::position(const glm::vec3& position) noexcept {
+        if (position_ == position) {
+            return;
+        }
+        position_ = position;
+        game_.rendering_system().transform_changed(*this);
+    }
+
+    void entity::rotation(const glm::quat& rotation) noexcept {
+        if (rotation_ == rotation) {
+            return;
+        }
+        rotation_ = rotation;
+        game_.rendering_system().transform_changed(*this);
+    }
+
+    void entity::scalation(const glm::vec3& scalation) noexcept {
+        if (scalation_ == scalation) {
+            return;
+        }
+        scalation_ = scalation;
+        game_.rendering_system().transform_changed(*this);
+    }
+
     glm::mat4 entity::transform() const {
         auto norm = glm::normalize(rotation_);
         auto transform = glm::toMat4(norm);
@@ -1,12 +1,13 @@
 #include <zombye/core/game.hpp>
 #include <zombye/physics/debug_renderer.hpp>
 #include <zombye/rendering/camera_component.hpp>
+#include <zombye/rendering/gl_backend.hpp>
 #include <zombye/rendering/rendering_system.hpp>
 #include <zombye/utils/logger.hpp>
 
 namespace zombye {
     debug_renderer::debug_renderer(game& game)
-    : game_{game}, rs_{game_.rendering_system()}, vbo_{0, GL_DYNAMIC_DRAW} {
+    : game_{game}, rs_{game_.rendering_system()}, vbo_{4096 * sizeof(debug_vertex)} {
         debug_vertex_layout_.emplace_back("position", 3, GL_FLOAT, GL_FALSE, sizeof(debug_vertex), 0);
         debug_vertex_layout_.emplace_back("color", 3, GL_FLOAT, GL_FALSE, sizeof(debug_vertex), sizeof(glm::vec3));
 
@@ -22,7 +23,8 @@ namespace zombye {
             log(LOG_FATAL, "could not load shader from file physics_debug.fs");
         }
 
-        debug_vertex_layout_.setup_layout(vao_, &vbo_);
+        debug_vertex_layout_.setup_layout(vao_, vbo_);
+        vbo_generation_ = vbo_.generation();
 
         debug_program_.attach_shader(vs);
         debug_program_.attach_shader(fs);
@@ -53,17 +55,26 @@ namespace zombye {
             projection_view = camera->projection_view();
         }
 
-        vbo_.data(line_buffer_.size() * sizeof(debug_vertex), line_buffer_.data());
-        vao_.bind();
+        vbo_.next_frame();
         debug_program_.use();
         debug_program_.uniform("vp", GL_FALSE, projection_view);
-        glDrawArrays(GL_LINES, 0, line_buffer_.size());
+        draw_buffer(GL_LINES, line_buffer_);
         line_buffer_.clear();
+        draw_buffer(GL_POINTS, point_buffer_);
+        point_buffer_.clear();
+    }
 
-        vbo_.data(point_buffer_.size() * sizeof(debug_vertex), point_buffer_.data());
+    void debug_renderer::draw_buffer(GLenum mode, const std::vector<debug_vertex>& vertices) {
+        if (vertices.empty()) {
+            return;
+        }
+        // aligned to whole vertices, so the data can be drawn from its first vertex on
+        auto offset = vbo_.write(vertices.data(), vertices.size() * sizeof(debug_vertex), sizeof(debug_vertex));
+        if (vbo_generation_ != vbo_.generation()) {
+            debug_vertex_layout_.setup_layout(vao_, vbo_);
+            vbo_generation_ = vbo_.generation();
+        }
         vao_.bind();
-        debug_program_.uniform("vp", GL_FALSE, projection_view);
-        glDrawArrays(GL_POINTS, 0, point_buffer_.size());
-        point_buffer_.clear();
+        gl.draw_arrays(mode, offset / sizeof(debug_vertex), vertices.size());
     }
 }
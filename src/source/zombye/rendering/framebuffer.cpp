@@ -1,13 +1,14 @@
 #include <zombye/rendering/framebuffer.hpp>
+#include <zombye/rendering/gl_backend.hpp>
 #include <zombye/rendering/texture.hpp>
 
 namespace zombye {
 	framebuffer::framebuffer() noexcept {
-		glGenFramebuffers(1, &id_);
+		gl.gen_framebuffers(1, &id_);
 	}
 
 	framebuffer::~framebuffer() {
-		glDeleteFramebuffers(1, &id_);
+		gl.delete_framebuffers(1, &id_);
 	}
 
 	framebuffer::framebuffer(framebuffer&& rhs) noexcept
@@ -23,7 +24,26 @@ namespace zombye {
 	}
 
 	void framebuffer::bind() const noexcept {
-		glBindFramebuffer(GL_FRAMEBUFFER, id_);
+		gl.bind_framebuffer(GL_FRAMEBUFFER, id_);
+	}
+
+	void framebuffer::bind_read() const noexcept {
+		gl.bind_framebuffer(GL_READ_FRAMEBUFFER, id_);
+	}
+
+	void framebuffer::attach_texture(GLenum attachment, std::shared_ptr<texture> texture) {
+		bind();
+		if (texture->target_ == GL_TEXTURE_2D_ARRAY) {
+			gl.framebuffer_texture_layer(GL_FRAMEBUFFER, attachment, texture->id_, 0, 0);
+		} else {
+			gl.framebuffer_texture_2d(GL_FRAMEBUFFER, attachment, texture->target_, texture->id_, 0);
+		}
+		attachments_[attachment] = std::move(texture);
+		bind_default();
+	}
+
+	void framebuffer::select_layer(GLenum attachment, GLint layer, GLenum target) const {
+		gl.framebuffer_texture_layer(target, attachment, attachments_.at(attachment)->id_, 0, layer);
 	}
 
 	texture& framebuffer::attachment(GLenum attachment) const {
@@ -31,6 +51,6 @@ namespace zombye {
 	}
 
 	void framebuffer::bind_default() noexcept {
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		gl.bind_framebuffer(GL_FRAMEBUFFER, 0);
 	}
 }
@@ -0,0 +1,214 @@
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+
+#include <glm/glm.hpp>
+
+#include <mesh_converter/mesh_converter.hpp>
+#include <zombye/rendering/gl_backend.hpp>
+#include <zombye/rendering/geometry_arena.hpp>
+#include <zombye/rendering/rendering_system.hpp>
+
+namespace zombye {
+    range_allocator::range_allocator(uint64_t capacity)
+    : capacity_{capacity}, used_{0} {
+        if (capacity_ > 0) {
+            free_blocks_.emplace(0, capacity_);
+        }
+    }
+
+    bool range_allocator::allocate(uint64_t size, uint64_t& offset) {
+        for (auto block = free_blocks_.begin(); block != free_blocks_.end(); ++block) {
+            if (block->second < size) {
+                continue;
+            }
+            offset = block->first;
+            auto remaining = block->second - size;
+            free_blocks_.erase(block);
+            if (remaining > 0) {
+                free_blocks_.emplace(offset + size, remaining);
+            }
+            used_ += size;
+            return true;
+        }
+        return false;
+    }
+
+    void range_allocator::free(uint64_t offset, uint64_t size) {
+        if (size == 0) {
+            return;
+        }
+        used_ -= size;
+        auto next = free_blocks_.lower_bound(offset);
+        if (next != free_blocks_.end() && offset + size == next->first) {
+            size += next->second;
+            next = free_blocks_.erase(next);
+        }
+        if (next != free_blocks_.begin()) {
+            auto previous = std::prev(next);
+            if (previous->first + previous->second == offset) {
+                previous->second += size;
+                return;
+            }
+        }
+        free_blocks_.emplace_hint(next, offset, size);
+    }
+
+    uint64_t range_allocator::largest_free_block() const noexcept {
+        auto largest = uint64_t{0};
+        for (auto& block : free_blocks_) {
+            largest = std::max(largest, block.second);
+        }
+        return largest;
+    }
+
+    geometry_page::geometry_page(uint32_t vertex_format, GLenum index_type, uint64_t vertex_capacity,
+    uint64_t index_capacity)
+    : vertex_format{vertex_format}, index_type{index_type},
+    position_size{(vertex_format & devtools::half_positions) ? 4 * sizeof(uint16_t) : sizeof(glm::vec3)},
+    index_size{index_type == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t)}, vao{}, depth_vao{},
+    positions{vertex_capacity * position_size, GL_STATIC_DRAW},
+    attributes{vertex_capacity * sizeof(devtools::packed_attributes), GL_STATIC_DRAW},
+    indices{index_capacity * index_size, GL_STATIC_DRAW},
+    vertex_allocator{vertex_capacity}, index_allocator{index_capacity} {}
+
+    geometry_arena::geometry_arena(rendering_system& rendering_system)
+    : rendering_system_(rendering_system), draw_ids_{0, GL_STATIC_DRAW}, draw_capacity_{0}, allocations_{0} {
+        reserve_draws(1024);
+    }
+
+    geometry_allocation geometry_arena::allocate(uint32_t vertex_format, GLenum index_type, uint64_t vertex_count,
+    const void* positions, const void* attributes, uint64_t index_count, const void* indices) {
+        auto vertex_offset = uint64_t{0};
+        auto index_offset = uint64_t{0};
+        geometry_page* page = nullptr;
+        for (auto& candidate : pages_) {
+            if (candidate->vertex_format != vertex_format || candidate->index_type != index_type) {
+                continue;
+            }
+            if (!candidate->vertex_allocator.allocate(vertex_count, vertex_offset)) {
+                continue;
+            }
+            if (!candidate->index_allocator.allocate(index_count, index_offset)) {
+                candidate->vertex_allocator.free(vertex_offset, vertex_count);
+                continue;
+            }
+            page = candidate.get();
+            break;
+        }
+
+        if (!page) {
+            // indices are relative to the base vertex, so 16 bit indices address a page of any size
+            pages_.emplace_back(std::make_unique<geometry_page>(vertex_format, index_type,
+                std::max(vertex_count, default_page_vertices), std::max(index_count, default_page_indices)));
+            page = pages_.back().get();
+            setup_page(*page);
+            page->vertex_allocator.allocate(vertex_count, vertex_offset);
+            page->index_allocator.allocate(index_count, index_offset);
+#ifdef ZOMBYE_DEBUG
+            check_index_buffers();
+#endif
+        }
+
+        page->positions.subdata(vertex_offset * page->position_size, vertex_count * page->position_size, positions);
+        page->attributes.subdata(vertex_offset * sizeof(devtools::packed_attributes),
+            vertex_count * sizeof(devtools::packed_attributes), attributes);
+        // binding the element buffer changes the bound vertex array, which has to be the one of the page
+        page->vao.bind();
+        page->indices.subdata(index_offset * page->index_size, index_count * page->index_size, indices);
+        // index buffers created later must not replace the one of the page
+        gl.bind_vertex_array(0);
+        ++allocations_;
+
+        auto allocation = geometry_allocation{};
+        allocation.page = page;
+        allocation.base_vertex = static_cast<int32_t>(vertex_offset);
+        allocation.vertex_count = static_cast<uint32_t>(vertex_count);
+        allocation.first_index = static_cast<uint32_t>(index_offset);
+        allocation.index_count = static_cast<uint32_t>(index_count);
+        return allocation;
+    }
+
+    void geometry_arena::free(const geometry_allocation& allocation) noexcept {
+        if (!allocation.page) {
+            return;
+        }
+        allocation.page->vertex_allocator.free(allocation.base_vertex, allocation.vertex_count);
+        allocation.page->index_allocator.free(allocation.first_index, allocation.index_count);
+        --allocations_;
+    }
+
+    void geometry_arena::reserve_draws(size_t draw_count) {
+        if (draw_count <= draw_capacity_) {
+            return;
+        }
+        while (draw_capacity_ < draw_count) {
+            draw_capacity_ = std::max(draw_capacity_ * 2, size_t{1024});
+        }
+        auto draw_ids = std::vector<float>(draw_capacity_);
+        for (auto i = size_t{0}; i < draw_capacity_; ++i) {
+            draw_ids[i] = static_cast<float>(i);
+        }
+        draw_ids_.data(draw_ids.size() * sizeof(float), draw_ids.data());
+        for (auto& page : pages_) {
+            setup_page(*page);
+        }
+    }
+
+    geometry_arena_statistics geometry_arena::statistics() const noexcept {
+        auto statistics = geometry_arena_statistics{};
+        statistics.pages = pages_.size();
+        statistics.allocations = allocations_;
+        auto free_bytes = uint64_t{0};
+        auto largest_free_bytes = uint64_t{0};
+        for (auto& page : pages_) {
+            auto vertex_size = page->position_size + sizeof(devtools::packed_attributes);
+            auto& vertices = page->vertex_allocator;
+            auto& indices = page->index_allocator;
+            statistics.capacity_bytes += vertices.capacity() * vertex_size + indices.capacity() * page->index_size;
+            statistics.used_bytes += vertices.used() * vertex_size + indices.used() * page->index_size;
+            statistics.free_blocks += vertices.free_blocks() + indices.free_blocks();
+            free_bytes += (vertices.capacity() - vertices.used()) * vertex_size
+                + (indices.capacity() - indices.used()) * page->index_size;
+            largest_free_bytes += vertices.largest_free_block() * vertex_size
+                + indices.largest_free_block() * page->index_size;
+        }
+        if (statistics.capacity_bytes > 0) {
+            statistics.occupancy = static_cast<float>(statistics.used_bytes) / statistics.capacity_bytes;
+        }
+        if (free_bytes > 0) {
+            statistics.fragmentation = 1.f - static_cast<float>(largest_free_bytes) / free_bytes;
+        }
+        return statistics;
+    }
+
+    void geometry_arena::check_index_buffers() const {
+        // the null backend does not track bindings
+        if (active_gl_backend() != gl_backend_type::native) {
+            return;
+        }
+        for (auto& page : pages_) {
+            for (auto vao : {&page->vao, &page->depth_vao}) {
+                auto bound = GLint{0};
+                vao->bind();
+                gl.get_integerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &bound);
+                if (static_cast<GLuint>(bound) != page->indices.id()) {
+                    throw std::logic_error("a geometry page draws from the index buffer of another page");
+                }
+            }
+        }
+        gl.bind_vertex_array(0);
+    }
+
+    void geometry_arena::setup_page(geometry_page& page) {
+        const vertex_buffer* buffers[] = {&page.positions, &page.attributes, &draw_ids_};
+        page.vao.bind_index_buffer(page.indices);
+        rendering_system_.packed_mesh_layout(page.vertex_format).setup_layout(page.vao, buffers);
+
+        const vertex_buffer* depth_buffers[] = {&page.positions, &draw_ids_};
+        page.depth_vao.bind_index_buffer(page.indices);
+        rendering_system_.mesh_depth_layout((page.vertex_format & devtools::half_positions) != 0)
+            .setup_layout(page.depth_vao, depth_buffers);
+        gl.bind_vertex_array(0);
+    }
+}
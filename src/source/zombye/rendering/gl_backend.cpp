@@ -0,0 +1,506 @@
+#include <SDL2/SDL.h>
+
+#include <zombye/rendering/gl_backend.hpp>
+#include <zombye/utils/logger.hpp>
+
+namespace zombye {
+    namespace {
+        gl_statistics statistics;
+        gl_capabilities capabilities;
+        gl_backend_type backend = gl_backend_type::native;
+        GLuint next_name = 0;
+
+        // glMaxShaderCompilerThreadsKHR or glMaxShaderCompilerThreadsARB, resolved by query_gl_capabilities
+        using max_shader_compiler_threads_function = void (GLAPIENTRY*)(GLuint count);
+        max_shader_compiler_threads_function max_shader_compiler_threads = nullptr;
+
+        // the native table wraps every entry point in a lambda, because glew resolves most of them only
+        // after glewInit and the calling convention of the real functions differs between platforms.
+        gl_dispatch native_dispatch() noexcept {
+            gl_dispatch d;
+            d.active_texture = [](GLenum texture) { glActiveTexture(texture); };
+            d.attach_shader = [](GLuint program, GLuint shader) { glAttachShader(program, shader); };
+            d.begin_transform_feedback = [](GLenum primitive_mode) { glBeginTransformFeedback(primitive_mode); };
+            d.bind_attrib_location = [](GLuint program, GLuint index, const GLchar* name) {
+                glBindAttribLocation(program, index, name);
+            };
+            d.bind_buffer = [](GLenum target, GLuint buffer) { glBindBuffer(target, buffer); };
+            d.bind_buffer_range = [](GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size) {
+                glBindBufferRange(target, index, buffer, offset, size);
+            };
+            d.bind_frag_data_location = [](GLuint program, GLuint color_number, const GLchar* name) {
+                glBindFragDataLocation(program, color_number, name);
+            };
+            d.bind_framebuffer = [](GLenum target, GLuint framebuffer) { glBindFramebuffer(target, framebuffer); };
+            d.bind_texture = [](GLenum target, GLuint texture) { glBindTexture(target, texture); };
+            d.bind_vertex_array = [](GLuint array) { glBindVertexArray(array); };
+            d.blend_equation = [](GLenum mode) { glBlendEquation(mode); };
+            d.blit_framebuffer = [](GLint src_x0, GLint src_y0, GLint src_x1, GLint src_y1, GLint dst_x0,
+            GLint dst_y0, GLint dst_x1, GLint dst_y1, GLbitfield mask, GLenum filter) {
+                glBlitFramebuffer(src_x0, src_y0, src_x1, src_y1, dst_x0, dst_y0, dst_x1, dst_y1, mask, filter);
+            };
+            d.blend_func = [](GLenum sfactor, GLenum dfactor) { glBlendFunc(sfactor, dfactor); };
+            d.buffer_data = [](GLenum target, GLsizeiptr size, const GLvoid* data, GLenum usage) {
+                glBufferData(target, size, data, usage);
+            };
+            d.buffer_storage = [](GLenum target, GLsizeiptr size, const GLvoid* data, GLbitfield flags) {
+                glBufferStorage(target, size, data, flags);
+            };
+            d.buffer_sub_data = [](GLenum target, GLintptr offset, GLsizeiptr size, const GLvoid* data) {
+                glBufferSubData(target, offset, size, data);
+            };
+            d.clear = [](GLbitfield mask) { glClear(mask); };
+            d.client_wait_sync = [](GLsync sync, GLbitfield flags, GLuint64 timeout) {
+                return glClientWaitSync(sync, flags, timeout);
+            };
+            d.clear_color = [](GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha) {
+                glClearColor(red, green, blue, alpha);
+            };
+            d.compile_shader = [](GLuint shader) { glCompileShader(shader); };
+            d.compressed_tex_image_2d = [](GLenum target, GLint level, GLenum internal_format, GLsizei width,
+            GLsizei height, GLint border, GLsizei image_size, const GLvoid* data) {
+                glCompressedTexImage2D(target, level, internal_format, width, height, border, image_size, data);
+            };
+            d.compressed_tex_image_3d = [](GLenum target, GLint level, GLenum internal_format, GLsizei width,
+            GLsizei height, GLsizei depth, GLint border, GLsizei image_size, const GLvoid* data) {
+                glCompressedTexImage3D(target, level, internal_format, width, height, depth, border, image_size, data);
+            };
+            d.compressed_tex_sub_image_3d = [](GLenum target, GLint level, GLint x_offset, GLint y_offset,
+            GLint z_offset, GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLsizei image_size,
+            const GLvoid* data) {
+                glCompressedTexSubImage3D(target, level, x_offset, y_offset, z_offset, width, height, depth, format,
+                    image_size, data);
+            };
+            d.create_program = []() { return glCreateProgram(); };
+            d.create_shader = [](GLenum type) { return glCreateShader(type); };
+            d.cull_face = [](GLenum mode) { glCullFace(mode); };
+            d.delete_buffers = [](GLsizei n, const GLuint* buffers) { glDeleteBuffers(n, buffers); };
+            d.delete_framebuffers = [](GLsizei n, const GLuint* framebuffers) { glDeleteFramebuffers(n, framebuffers); };
+            d.delete_program = [](GLuint program) { glDeleteProgram(program); };
+            d.delete_queries = [](GLsizei n, const GLuint* ids) { glDeleteQueries(n, ids); };
+            d.delete_shader = [](GLuint shader) { glDeleteShader(shader); };
+            d.delete_sync = [](GLsync sync) { glDeleteSync(sync); };
+            d.delete_textures = [](GLsizei n, const GLuint* textures) { glDeleteTextures(n, textures); };
+            d.delete_vertex_arrays = [](GLsizei n, const GLuint* arrays) { glDeleteVertexArrays(n, arrays); };
+            d.detach_shader = [](GLuint program, GLuint shader) { glDetachShader(program, shader); };
+            d.disable = [](GLenum cap) { glDisable(cap); };
+            d.draw_arrays = [](GLenum mode, GLint first, GLsizei count) { glDrawArrays(mode, first, count); };
+            d.draw_buffers = [](GLsizei n, const GLenum* bufs) { glDrawBuffers(n, bufs); };
+            d.draw_elements = [](GLenum mode, GLsizei count, GLenum type, const GLvoid* indices) {
+                glDrawElements(mode, count, type, indices);
+            };
+            d.draw_elements_base_vertex = [](GLenum mode, GLsizei count, GLenum type, const GLvoid* indices,
+            GLint base_vertex) {
+                glDrawElementsBaseVertex(mode, count, type, const_cast<GLvoid*>(indices), base_vertex);
+            };
+            d.draw_elements_instanced = [](GLenum mode, GLsizei count, GLenum type, const GLvoid* indices,
+            GLsizei instance_count) {
+                glDrawElementsInstanced(mode, count, type, indices, instance_count);
+            };
+            d.enable = [](GLenum cap) { glEnable(cap); };
+            d.enable_vertex_attrib_array = [](GLuint index) { glEnableVertexAttribArray(index); };
+            d.end_transform_feedback = []() { glEndTransformFeedback(); };
+            d.fence_sync = [](GLenum condition, GLbitfield flags) { return glFenceSync(condition, flags); };
+            d.framebuffer_texture_2d = [](GLenum target, GLenum attachment, GLenum textarget, GLuint texture,
+            GLint level) {
+                glFramebufferTexture2D(target, attachment, textarget, texture, level);
+            };
+            d.framebuffer_texture_layer = [](GLenum target, GLenum attachment, GLuint texture, GLint level,
+            GLint layer) {
+                glFramebufferTextureLayer(target, attachment, texture, level, layer);
+            };
+            d.front_face = [](GLenum mode) { glFrontFace(mode); };
+            d.gen_buffers = [](GLsizei n, GLuint* buffers) { glGenBuffers(n, buffers); };
+            d.gen_framebuffers = [](GLsizei n, GLuint* framebuffers) { glGenFramebuffers(n, framebuffers); };
+            d.gen_queries = [](GLsizei n, GLuint* ids) { glGenQueries(n, ids); };
+            d.gen_textures = [](GLsizei n, GLuint* textures) { glGenTextures(n, textures); };
+            d.gen_vertex_arrays = [](GLsizei n, GLuint* arrays) { glGenVertexArrays(n, arrays); };
+            d.generate_mipmap = [](GLenum target) { glGenerateMipmap(target); };
+            d.get_floatv = [](GLenum pname, GLfloat* params) { glGetFloatv(pname, params); };
+            d.get_integerv = [](GLenum pname, GLint* params) { glGetIntegerv(pname, params); };
+            d.get_program_info_log = [](GLuint program, GLsizei buf_size, GLsizei* length, GLchar* info_log) {
+                glGetProgramInfoLog(program, buf_size, length, info_log);
+            };
+            d.get_program_binary = [](GLuint program, GLsizei buf_size, GLsizei* length, GLenum* binary_format,
+            GLvoid* binary) {
+                glGetProgramBinary(program, buf_size, length, binary_format, binary);
+            };
+            d.get_programiv = [](GLuint program, GLenum pname, GLint* params) { glGetProgramiv(program, pname, params); };
+            d.get_query_objectiv = [](GLuint id, GLenum pname, GLint* params) { glGetQueryObjectiv(id, pname, params); };
+            d.get_query_objectui64v = [](GLuint id, GLenum pname, GLuint64* params) {
+                glGetQueryObjectui64v(id, pname, params);
+            };
+            d.get_shader_info_log = [](GLuint shader, GLsizei buf_size, GLsizei* length, GLchar* info_log) {
+                glGetShaderInfoLog(shader, buf_size, length, info_log);
+            };
+            d.get_shaderiv = [](GLuint shader, GLenum pname, GLint* params) { glGetShaderiv(shader, pname, params); };
+            d.get_string = [](GLenum name) { return glGetString(name); };
+            d.get_uniform_location = [](GLuint program, const GLchar* name) { return glGetUniformLocation(program, name); };
+            d.link_program = [](GLuint program) { glLinkProgram(program); };
+            d.map_buffer_range = [](GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access) {
+                return glMapBufferRange(target, offset, length, access);
+            };
+            d.max_shader_compiler_threads = [](GLuint count) {
+                if (max_shader_compiler_threads) {
+                    max_shader_compiler_threads(count);
+                }
+            };
+            d.multi_draw_elements_indirect = [](GLenum mode, GLenum type, const GLvoid* indirect, GLsizei draw_count,
+            GLsizei stride) {
+                glMultiDrawElementsIndirect(mode, type, indirect, draw_count, stride);
+            };
+            d.pixel_storei = [](GLenum pname, GLint param) { glPixelStorei(pname, param); };
+            d.program_binary = [](GLuint program, GLenum binary_format, const GLvoid* binary, GLsizei length) {
+                glProgramBinary(program, binary_format, binary, length);
+            };
+            d.program_parameteri = [](GLuint program, GLenum pname, GLint value) {
+                glProgramParameteri(program, pname, value);
+            };
+            d.query_counter = [](GLuint id, GLenum target) { glQueryCounter(id, target); };
+            d.shader_source = [](GLuint shader, GLsizei count, const GLchar* const* string, const GLint* length) {
+                glShaderSource(shader, count, string, length);
+            };
+            d.tex_buffer = [](GLenum target, GLenum internal_format, GLuint buffer) {
+                glTexBuffer(target, internal_format, buffer);
+            };
+            d.tex_buffer_range = [](GLenum target, GLenum internal_format, GLuint buffer, GLintptr offset,
+            GLsizeiptr size) {
+                glTexBufferRange(target, internal_format, buffer, offset, size);
+            };
+            d.tex_image_2d = [](GLenum target, GLint level, GLint internal_format, GLsizei width, GLsizei height,
+            GLint border, GLenum format, GLenum type, const GLvoid* data) {
+                glTexImage2D(target, level, internal_format, width, height, border, format, type, data);
+            };
+            d.tex_image_3d = [](GLenum target, GLint level, GLint internal_format, GLsizei width, GLsizei height,
+            GLsizei depth, GLint border, GLenum format, GLenum type, const GLvoid* data) {
+                glTexImage3D(target, level, internal_format, width, height, depth, border, format, type, data);
+            };
+            d.tex_parameteri = [](GLenum target, GLenum pname, GLint param) { glTexParameteri(target, pname, param); };
+            d.tex_sub_image_3d = [](GLenum target, GLint level, GLint x_offset, GLint y_offset, GLint z_offset,
+            GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, const GLvoid* data) {
+                glTexSubImage3D(target, level, x_offset, y_offset, z_offset, width, height, depth, format, type, data);
+            };
+            d.transform_feedback_varyings = [](GLuint program, GLsizei count, const GLchar* const* varyings,
+            GLenum buffer_mode) {
+                glTransformFeedbackVaryings(program, count, varyings, buffer_mode);
+            };
+            d.uniform_1f = [](GLint location, GLfloat v0) { glUniform1f(location, v0); };
+            d.uniform_1i = [](GLint location, GLint v0) { glUniform1i(location, v0); };
+            d.uniform_1ui = [](GLint location, GLuint v0) { glUniform1ui(location, v0); };
+            d.uniform_1fv = [](GLint location, GLsizei count, const GLfloat* value) { glUniform1fv(location, count, value); };
+            d.uniform_2fv = [](GLint location, GLsizei count, const GLfloat* value) { glUniform2fv(location, count, value); };
+            d.uniform_3fv = [](GLint location, GLsizei count, const GLfloat* value) { glUniform3fv(location, count, value); };
+            d.uniform_4fv = [](GLint location, GLsizei count, const GLfloat* value) { glUniform4fv(location, count, value); };
+            d.uniform_1iv = [](GLint location, GLsizei count, const GLint* value) { glUniform1iv(location, count, value); };
+            d.uniform_2iv = [](GLint location, GLsizei count, const GLint* value) { glUniform2iv(location, count, value); };
+            d.uniform_3iv = [](GLint location, GLsizei count, const GLint* value) { glUniform3iv(location, count, value); };
+            d.uniform_4iv = [](GLint location, GLsizei count, const GLint* value) { glUniform4iv(location, count, value); };
+            d.uniform_1uiv = [](GLint location, GLsizei count, const GLuint* value) { glUniform1uiv(location, count, value); };
+            d.uniform_matrix_2fv = [](GLint location, GLsizei count, GLboolean transpose, const GLfloat* value) {
+                glUniformMatrix2fv(location, count, transpose, value);
+            };
+            d.uniform_matrix_3fv = [](GLint location, GLsizei count, GLboolean transpose, const GLfloat* value) {
+                glUniformMatrix3fv(location, count, transpose, value);
+            };
+            d.uniform_matrix_4fv = [](GLint location, GLsizei count, GLboolean transpose, const GLfloat* value) {
+                glUniformMatrix4fv(location, count, transpose, value);
+            };
+            d.unmap_buffer = [](GLenum target) { return glUnmapBuffer(target); };
+            d.use_program = [](GLuint program) { glUseProgram(program); };
+            d.vertex_attrib_divisor = [](GLuint index, GLuint divisor) { glVertexAttribDivisor(index, divisor); };
+            d.vertex_attrib_i_pointer = [](GLuint index, GLint size, GLenum type, GLsizei stride, const GLvoid* pointer) {
+                glVertexAttribIPointer(index, size, type, stride, pointer);
+            };
+            d.vertex_attrib_pointer = [](GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride,
+            const GLvoid* pointer) {
+                glVertexAttribPointer(index, size, type, normalized, stride, pointer);
+            };
+            d.viewport = [](GLint x, GLint y, GLsizei width, GLsizei height) { glViewport(x, y, width, height); };
+            return d;
+        }
+
+        void record_call() noexcept {
+            ++statistics.calls;
+        }
+
+        void record_state_change() noexcept {
+            ++statistics.calls;
+            ++statistics.state_changes;
+        }
+
+        void record_draw_call() noexcept {
+            ++statistics.calls;
+            ++statistics.draw_calls;
+        }
+
+        void record_uniform_upload() noexcept {
+            ++statistics.calls;
+            ++statistics.uniform_uploads;
+        }
+
+        void record_upload(size_t bytes) noexcept {
+            ++statistics.calls;
+            statistics.bytes_uploaded += bytes;
+        }
+
+        void generate_names(GLsizei n, GLuint* names) noexcept {
+            record_call();
+            for (auto i = 0; i < n; ++i) {
+                names[i] = ++next_name;
+            }
+        }
+
+        size_t pixel_size(GLenum format, GLenum type) noexcept {
+            auto components = size_t{4};
+            switch (format) {
+                case GL_RED:
+                case GL_DEPTH_COMPONENT:
+                    components = 1;
+                    break;
+                case GL_RG:
+                    components = 2;
+                    break;
+                case GL_RGB:
+                case GL_BGR:
+                    components = 3;
+                    break;
+            }
+            switch (type) {
+                case GL_BYTE:
+                case GL_UNSIGNED_BYTE:
+                    return components;
+                case GL_SHORT:
+                case GL_UNSIGNED_SHORT:
+                case GL_HALF_FLOAT:
+                    return components * 2;
+                default:
+                    return components * 4;
+            }
+        }
+
+        // the null backend never touches a driver. it hands out names, reports every object as successfully
+        // compiled and linked and counts what a real backend would have been asked to do.
+        gl_dispatch null_dispatch() noexcept {
+            gl_dispatch d;
+            d.active_texture = [](GLenum) { record_state_change(); };
+            d.attach_shader = [](GLuint, GLuint) { record_call(); };
+            d.begin_transform_feedback = [](GLenum) { record_state_change(); };
+            d.bind_attrib_location = [](GLuint, GLuint, const GLchar*) { record_call(); };
+            d.bind_buffer = [](GLenum, GLuint) { record_state_change(); };
+            d.bind_buffer_range = [](GLenum, GLuint, GLuint, GLintptr, GLsizeiptr) { record_state_change(); };
+            d.bind_frag_data_location = [](GLuint, GLuint, const GLchar*) { record_call(); };
+            d.bind_framebuffer = [](GLenum, GLuint) { record_state_change(); };
+            d.bind_texture = [](GLenum, GLuint) { record_state_change(); };
+            d.bind_vertex_array = [](GLuint) { record_state_change(); };
+            d.blend_equation = [](GLenum) { record_state_change(); };
+            d.blit_framebuffer = [](GLint, GLint, GLint, GLint, GLint, GLint, GLint, GLint, GLbitfield, GLenum) {
+                record_draw_call();
+            };
+            d.blend_func = [](GLenum, GLenum) { record_state_change(); };
+            d.buffer_data = [](GLenum, GLsizeiptr size, const GLvoid* data, GLenum) {
+                record_upload(data ? size : 0);
+            };
+            d.buffer_storage = [](GLenum, GLsizeiptr size, const GLvoid* data, GLbitfield) {
+                record_upload(data ? size : 0);
+            };
+            d.buffer_sub_data = [](GLenum, GLintptr, GLsizeiptr size, const GLvoid*) { record_upload(size); };
+            d.clear = [](GLbitfield) { record_call(); };
+            d.client_wait_sync = [](GLsync, GLbitfield, GLuint64) { record_call(); return GLenum{GL_ALREADY_SIGNALED}; };
+            d.clear_color = [](GLfloat, GLfloat, GLfloat, GLfloat) { record_state_change(); };
+            d.compile_shader = [](GLuint) { record_call(); };
+            d.compressed_tex_image_2d = [](GLenum, GLint, GLenum, GLsizei, GLsizei, GLint, GLsizei image_size,
+            const GLvoid* data) {
+                record_upload(data ? image_size : 0);
+            };
+            d.compressed_tex_image_3d = [](GLenum, GLint, GLenum, GLsizei, GLsizei, GLsizei, GLint,
+            GLsizei image_size, const GLvoid* data) {
+                record_upload(data ? image_size : 0);
+            };
+            d.compressed_tex_sub_image_3d = [](GLenum, GLint, GLint, GLint, GLint, GLsizei, GLsizei, GLsizei,
+            GLenum, GLsizei image_size, const GLvoid*) {
+                record_upload(image_size);
+            };
+            d.create_program = []() { record_call(); return ++next_name; };
+            d.create_shader = [](GLenum) { record_call(); return ++next_name; };
+            d.cull_face = [](GLenum) { record_state_change(); };
+            d.delete_buffers = [](GLsizei, const GLuint*) { record_call(); };
+            d.delete_framebuffers = [](GLsizei, const GLuint*) { record_call(); };
+            d.delete_program = [](GLuint) { record_call(); };
+            d.delete_queries = [](GLsizei, const GLuint*) { record_call(); };
+            d.delete_shader = [](GLuint) { record_call(); };
+            d.delete_sync = [](GLsync) { record_call(); };
+            d.delete_textures = [](GLsizei, const GLuint*) { record_call(); };
+            d.delete_vertex_arrays = [](GLsizei, const GLuint*) { record_call(); };
+            d.detach_shader = [](GLuint, GLuint) { record_call(); };
+            d.disable = [](GLenum) { record_state_change(); };
+            d.draw_arrays = [](GLenum, GLint, GLsizei) { record_draw_call(); };
+            d.draw_buffers = [](GLsizei, const GLenum*) { record_state_change(); };
+            d.draw_elements = [](GLenum, GLsizei, GLenum, const GLvoid*) { record_draw_call(); };
+            d.draw_elements_base_vertex = [](GLenum, GLsizei, GLenum, const GLvoid*, GLint) { record_draw_call(); };
+            d.draw_elements_instanced = [](GLenum, GLsizei, GLenum, const GLvoid*, GLsizei) { record_draw_call(); };
+            d.enable = [](GLenum) { record_state_change(); };
+            d.enable_vertex_attrib_array = [](GLuint) { record_call(); };
+            d.end_transform_feedback = []() { record_state_change(); };
+            d.fence_sync = [](GLenum, GLbitfield) { record_call(); return GLsync{nullptr}; };
+            d.framebuffer_texture_2d = [](GLenum, GLenum, GLenum, GLuint, GLint) { record_call(); };
+            d.framebuffer_texture_layer = [](GLenum, GLenum, GLuint, GLint, GLint) { record_call(); };
+            d.front_face = [](GLenum) { record_state_change(); };
+            d.gen_buffers = generate_names;
+            d.gen_framebuffers = generate_names;
+            d.gen_queries = generate_names;
+            d.gen_textures = generate_names;
+            d.gen_vertex_arrays = generate_names;
+            d.generate_mipmap = [](GLenum) { record_call(); };
+            d.get_floatv = [](GLenum, GLfloat* params) { record_call(); *params = 0.f; };
+            d.get_integerv = [](GLenum, GLint* params) { record_call(); *params = 0; };
+            d.get_program_info_log = [](GLuint, GLsizei buf_size, GLsizei* length, GLchar* info_log) {
+                record_call();
+                if (length) {
+                    *length = 0;
+                }
+                if (buf_size > 0) {
+                    info_log[0] = '\0';
+                }
+            };
+            d.get_program_binary = [](GLuint, GLsizei, GLsizei* length, GLenum* binary_format, GLvoid*) {
+                record_call();
+                if (length) {
+                    *length = 0;
+                }
+                *binary_format = 0;
+            };
+            d.get_programiv = [](GLuint, GLenum pname, GLint* params) {
+                record_call();
+                *params = pname == GL_LINK_STATUS ? GL_TRUE : 0;
+            };
+            d.get_query_objectiv = [](GLuint, GLenum pname, GLint* params) {
+                record_call();
+                *params = pname == GL_QUERY_RESULT_AVAILABLE ? GL_TRUE : 0;
+            };
+            d.get_query_objectui64v = [](GLuint, GLenum, GLuint64* params) { record_call(); *params = 0; };
+            d.get_shader_info_log = [](GLuint, GLsizei buf_size, GLsizei* length, GLchar* info_log) {
+                record_call();
+                if (length) {
+                    *length = 0;
+                }
+                if (buf_size > 0) {
+                    info_log[0] = '\0';
+                }
+            };
+            d.get_shaderiv = [](GLuint, GLenum pname, GLint* params) {
+                record_call();
+                *params = pname == GL_COMPILE_STATUS ? GL_TRUE : 0;
+            };
+            d.get_string = [](GLenum) {
+                record_call();
+                return reinterpret_cast<const GLubyte*>("null backend");
+            };
+            d.get_uniform_location = [](GLuint, const GLchar*) { record_call(); return GLint{0}; };
+            d.link_program = [](GLuint) { record_call(); };
+            d.map_buffer_range = [](GLenum, GLintptr, GLsizeiptr, GLbitfield) {
+                record_call();
+                return static_cast<void*>(nullptr);
+            };
+            d.max_shader_compiler_threads = [](GLuint) { record_call(); };
+            d.multi_draw_elements_indirect = [](GLenum, GLenum, const GLvoid*, GLsizei, GLsizei) { record_draw_call(); };
+            d.pixel_storei = [](GLenum, GLint) { record_state_change(); };
+            d.program_binary = [](GLuint, GLenum, const GLvoid*, GLsizei length) { record_upload(length); };
+            d.program_parameteri = [](GLuint, GLenum, GLint) { record_call(); };
+            d.query_counter = [](GLuint, GLenum) { record_call(); };
+            d.shader_source = [](GLuint, GLsizei, const GLchar* const*, const GLint*) { record_call(); };
+            d.tex_buffer = [](GLenum, GLenum, GLuint) { record_state_change(); };
+            d.tex_buffer_range = [](GLenum, GLenum, GLuint, GLintptr, GLsizeiptr) { record_state_change(); };
+            d.tex_image_2d = [](GLenum, GLint, GLint, GLsizei width, GLsizei height, GLint, GLenum format,
+            GLenum type, const GLvoid* data) {
+                record_upload(data ? width * height * pixel_size(format, type) : 0);
+            };
+            d.tex_image_3d = [](GLenum, GLint, GLint, GLsizei width, GLsizei height, GLsizei depth, GLint,
+            GLenum format, GLenum type, const GLvoid* data) {
+                record_upload(data ? width * height * depth * pixel_size(format, type) : 0);
+            };
+            d.tex_parameteri = [](GLenum, GLenum, GLint) { record_call(); };
+            d.tex_sub_image_3d = [](GLenum, GLint, GLint, GLint, GLint, GLsizei width, GLsizei height,
+            GLsizei depth, GLenum format, GLenum type, const GLvoid*) {
+                record_upload(width * height * depth * pixel_size(format, type));
+            };
+            d.transform_feedback_varyings = [](GLuint, GLsizei, const GLchar* const*, GLenum) { record_call(); };
+            d.uniform_1f = [](GLint, GLfloat) { record_uniform_upload(); };
+            d.uniform_1i = [](GLint, GLint) { record_uniform_upload(); };
+            d.uniform_1ui = [](GLint, GLuint) { record_uniform_upload(); };
+            d.uniform_1fv = [](GLint, GLsizei, const GLfloat*) { record_uniform_upload(); };
+            d.uniform_2fv = [](GLint, GLsizei, const GLfloat*) { record_uniform_upload(); };
+            d.uniform_3fv = [](GLint, GLsizei, const GLfloat*) { record_uniform_upload(); };
+            d.uniform_4fv = [](GLint, GLsizei, const GLfloat*) { record_uniform_upload(); };
+            d.uniform_1iv = [](GLint, GLsizei, const GLint*) { record_uniform_upload(); };
+            d.uniform_2iv = [](GLint, GLsizei, const GLint*) { record_uniform_upload(); };
+            d.uniform_3iv = [](GLint, GLsizei, const GLint*) { record_uniform_upload(); };
+            d.uniform_4iv = [](GLint, GLsizei, const GLint*) { record_uniform_upload(); };
+            d.uniform_1uiv = [](GLint, GLsizei, const GLuint*) { record_uniform_upload(); };
+            d.uniform_matrix_2fv = [](GLint, GLsizei, GLboolean, const GLfloat*) { record_uniform_upload(); };
+            d.uniform_matrix_3fv = [](GLint, GLsizei, GLboolean, const GLfloat*) { record_uniform_upload(); };
+            d.uniform_matrix_4fv = [](GLint, GLsizei, GLboolean, const GLfloat*) { record_uniform_upload(); };
+            d.unmap_buffer = [](GLenum) { record_call(); return GLboolean{GL_TRUE}; };
+            d.use_program = [](GLuint) { record_state_change(); };
+            d.vertex_attrib_divisor = [](GLuint, GLuint) { record_call(); };
+            d.vertex_attrib_i_pointer = [](GLuint, GLint, GLenum, GLsizei, const GLvoid*) { record_call(); };
+            d.vertex_attrib_pointer = [](GLuint, GLint, GLenum, GLboolean, GLsizei, const GLvoid*) { record_call(); };
+            d.viewport = [](GLint, GLint, GLsizei, GLsizei) { record_state_change(); };
+            return d;
+        }
+    }
+
+    gl_dispatch gl = native_dispatch();
+
+    void select_gl_backend(gl_backend_type type) noexcept {
+        backend = type;
+        gl = type == gl_backend_type::null ? null_dispatch() : native_dispatch();
+        reset_gl_stats();
+    }
+
+    gl_backend_type active_gl_backend() noexcept {
+        return backend;
+    }
+
+    gl_backend_type gl_backend_from_string(const std::string& name) {
+        if (name == "null") {
+            return gl_backend_type::null;
+        }
+        if (!name.empty() && name != "native") {
+            log(LOG_WARNING, "unknown gl backend " + name + ", falling back to native");
+        }
+        return gl_backend_type::native;
+    }
+
+    void query_gl_capabilities() noexcept {
+        capabilities = gl_capabilities{};
+        if (backend == gl_backend_type::native) {
+            capabilities.buffer_storage = GLEW_ARB_buffer_storage && (GLEW_VERSION_3_2 || GLEW_ARB_sync);
+            capabilities.texture_buffer_range = GLEW_ARB_texture_buffer_range;
+            capabilities.multi_draw_indirect = GLEW_ARB_multi_draw_indirect && GLEW_ARB_base_instance;
+            capabilities.program_binary = GLEW_ARB_get_program_binary;
+            capabilities.timer_query = GLEW_VERSION_3_3 || GLEW_ARB_timer_query;
+
+            max_shader_compiler_threads = nullptr;
+            if (SDL_GL_ExtensionSupported("GL_KHR_parallel_shader_compile")) {
+                max_shader_compiler_threads = reinterpret_cast<max_shader_compiler_threads_function>(
+                    SDL_GL_GetProcAddress("glMaxShaderCompilerThreadsKHR"));
+            } else if (SDL_GL_ExtensionSupported("GL_ARB_parallel_shader_compile")) {
+                max_shader_compiler_threads = reinterpret_cast<max_shader_compiler_threads_function>(
+                    SDL_GL_GetProcAddress("glMaxShaderCompilerThreadsARB"));
+            }
+            capabilities.parallel_shader_compile = max_shader_compiler_threads != nullptr;
+        }
+    }
+
+    const gl_capabilities& gl_caps() noexcept {
+        return capabilities;
+    }
+
+    const gl_statistics& gl_stats() noexcept {
+        return statistics;
+    }
+
+    void reset_gl_stats() noexcept {
+        statistics = gl_statistics{};
+    }
+}
@@ -0,0 +1,66 @@
+#include <zombye/rendering/gl_backend.hpp>
+#include <zombye/rendering/gpu_timer.hpp>
+
+namespace zombye {
+    gpu_timer::gpu_timer(size_t latency) noexcept
+    : current_{0}, active_{false}, milliseconds_{0.f} {
+        if (!gl_caps().timer_query) {
+            return;
+        }
+        samples_.resize(latency > 0 ? latency : 1);
+        for (auto& sample : samples_) {
+            gl.gen_queries(1, &sample.begin);
+            gl.gen_queries(1, &sample.end);
+            sample.pending = false;
+        }
+    }
+
+    gpu_timer::~gpu_timer() noexcept {
+        for (auto& sample : samples_) {
+            gl.delete_queries(1, &sample.begin);
+            gl.delete_queries(1, &sample.end);
+        }
+    }
+
+    void gpu_timer::begin() noexcept {
+        active_ = !samples_.empty() && !samples_[current_].pending;
+        if (active_) {
+            gl.query_counter(samples_[current_].begin, GL_TIMESTAMP);
+        }
+    }
+
+    void gpu_timer::end() noexcept {
+        if (!active_) {
+            return;
+        }
+        auto& sample = samples_[current_];
+        gl.query_counter(sample.end, GL_TIMESTAMP);
+        sample.pending = true;
+        current_ = (current_ + 1) % samples_.size();
+        active_ = false;
+    }
+
+    bool gpu_timer::poll() noexcept {
+        // the oldest measurement follows the current one in the ring and finishes first
+        auto updated = false;
+        for (auto i = size_t{0}; i < samples_.size(); ++i) {
+            auto& sample = samples_[(current_ + i) % samples_.size()];
+            if (!sample.pending) {
+                continue;
+            }
+            auto available = GLint{0};
+            gl.get_query_objectiv(sample.end, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available) {
+                break;
+            }
+            auto begin = GLuint64{0};
+            auto end = GLuint64{0};
+            gl.get_query_objectui64v(sample.begin, GL_QUERY_RESULT, &begin);
+            gl.get_query_objectui64v(sample.end, GL_QUERY_RESULT, &end);
+            milliseconds_ = end > begin ? (end - begin) / 1000000.f : 0.f;
+            sample.pending = false;
+            updated = true;
+        }
+        return updated;
+    }
+}
@@ -0,0 +1,229 @@
+#include <algorithm>
+#include <cmath>
+
+#include <zombye/rendering/camera_component.hpp>
+#include <zombye/rendering/light_culler.hpp>
+#include <zombye/rendering/program.hpp>
+#include <zombye/utils/thread_pool.hpp>
+
+namespace zombye {
+    light_culler::light_culler(int tiles_x, int tiles_y, int slices, size_t max_lights, float fade_time)
+    : tiles_x_{tiles_x}, tiles_y_{tiles_y}, slices_{slices}, near_plane_{0.1f}, far_plane_{1000.f},
+    max_lights_{max_lights}, fade_time_{fade_time}, frame_{0}, uploaded_frame_{~uint64_t{0}},
+    light_buffer_{max_lights * sizeof(glm::vec4) * 2},
+    cluster_buffer_{static_cast<size_t>(tiles_x * tiles_y * slices) * sizeof(uint32_t) * 2},
+    index_buffer_{max_lights * sizeof(uint32_t) * 8}, visible_lights_{0} {
+        light_texture_ = std::make_unique<texture>(GL_RGBA32F, light_buffer_);
+        cluster_texture_ = std::make_unique<texture>(GL_RG32UI, cluster_buffer_);
+        index_texture_ = std::make_unique<texture>(GL_R32UI, index_buffer_);
+        cluster_data_.resize(tiles_x_ * tiles_y_ * slices_ * 2);
+    }
+
+    void light_culler::cull(const std::vector<light_attributes>& lights, const camera_component& camera,
+    float delta_time, thread_pool& pool) {
+        const static auto grain = size_t{64};
+
+        auto& projection = camera.projection();
+        near_plane_ = projection[3][2] / (projection[2][2] - 1.f);
+        far_plane_ = projection[3][2] / (projection[2][2] + 1.f);
+        auto tan_half_x = 1.f / projection[0][0];
+        auto tan_half_y = 1.f / projection[1][1];
+        auto view = camera.view();
+
+        // the sphere of a light is enclosed by a view space box. x / depth and y / depth are monotonic over
+        // the box, so its corners give a conservative tile range.
+        ranges_.resize(lights.size());
+        pool.parallel_for(lights.size(), grain, [&](size_t begin, size_t end) {
+            for (auto i = begin; i < end; ++i) {
+                auto& light = lights[i];
+                auto& range = ranges_[i];
+                range.min_x = 1;
+                range.max_x = 0;
+
+                auto center = glm::vec3{view * glm::vec4{light.position, 1.f}};
+                auto radius = light.extent;
+                auto min_depth = -center.z - radius;
+                auto max_depth = -center.z + radius;
+                if (!(radius > 0.f) || max_depth < near_plane_ || min_depth > far_plane_) {
+                    continue;
+                }
+                min_depth = std::max(min_depth, near_plane_);
+                max_depth = std::min(max_depth, far_plane_);
+
+                auto min_ndc = glm::vec2{1.f};
+                auto max_ndc = glm::vec2{-1.f};
+                for (auto c = 0; c < 8; ++c) {
+                    auto x = center.x + ((c & 1) ? radius : -radius);
+                    auto y = center.y + ((c & 2) ? radius : -radius);
+                    auto depth = (c & 4) ? max_depth : min_depth;
+                    auto ndc = glm::vec2{x / (depth * tan_half_x), y / (depth * tan_half_y)};
+                    min_ndc = glm::min(min_ndc, ndc);
+                    max_ndc = glm::max(max_ndc, ndc);
+                }
+                if (min_ndc.x > 1.f || min_ndc.y > 1.f || max_ndc.x < -1.f || max_ndc.y < -1.f) {
+                    continue;
+                }
+
+                auto to_tile = [](float ndc, int tiles) {
+                    auto tile = static_cast<int>(std::floor((ndc * 0.5f + 0.5f) * tiles));
+                    return glm::clamp(tile, 0, tiles - 1);
+                };
+                range.min_x = to_tile(min_ndc.x, tiles_x_);
+                range.max_x = to_tile(max_ndc.x, tiles_x_);
+                range.min_y = to_tile(min_ndc.y, tiles_y_);
+                range.max_y = to_tile(max_ndc.y, tiles_y_);
+                range.min_z = slice(min_depth);
+                range.max_z = slice(max_depth);
+
+                // the projected sphere area relative to the screen, which is 1 once the camera is inside
+                auto distance = glm::length(center);
+                auto coverage = 1.f;
+                if (distance > radius) {
+                    auto projected = radius / (std::sqrt(distance * distance - radius * radius) * tan_half_y);
+                    coverage = std::min(projected * projected, 1.f);
+                }
+                range.importance = coverage * std::max(light.color.r, std::max(light.color.g, light.color.b));
+            }
+        });
+
+        candidates_.clear();
+        for (auto i = size_t{0}; i < lights.size(); ++i) {
+            if (ranges_[i].min_x <= ranges_[i].max_x) {
+                candidates_.emplace_back(i);
+            }
+        }
+        auto budget = std::min(candidates_.size(), max_lights_);
+        std::nth_element(candidates_.begin(), candidates_.begin() + budget, candidates_.end(),
+            [this](size_t lhs, size_t rhs) {
+                return ranges_[lhs].importance > ranges_[rhs].importance;
+            });
+
+        // the first budget candidates fade in, the others fade out and are dropped once invisible. lights
+        // not seen this frame lose their fade state.
+        ++frame_;
+        auto step = fade_time_ > 0.f ? delta_time / fade_time_ : 1.f;
+        fade_values_.assign(lights.size(), 0.f);
+        for (auto c = size_t{0}; c < candidates_.size(); ++c) {
+            auto i = candidates_[c];
+            auto selected = c < budget;
+            auto entry = fades_.find(lights[i].source);
+            if (entry == fades_.end()) {
+                // lights that are new in view do not fade in while the budget is not exceeded
+                auto initial = selected && candidates_.size() <= max_lights_ ? 1.f : 0.f;
+                entry = fades_.emplace(lights[i].source, light_fade{initial, frame_}).first;
+            }
+            auto& fade = entry->second;
+            fade.value = glm::clamp(fade.value + (selected ? step : -step), 0.f, 1.f);
+            fade.frame = frame_;
+            fade_values_[i] = fade.value;
+            if (fade.value <= 0.f) {
+                ranges_[i].min_x = 1;
+                ranges_[i].max_x = 0;
+            }
+        }
+        for (auto entry = fades_.begin(); entry != fades_.end();) {
+            if (entry->second.frame != frame_) {
+                entry = fades_.erase(entry);
+            } else {
+                ++entry;
+            }
+        }
+
+        // every light in view gets a compact index. the clusters are filled in two passes, the first counts
+        // the lights per cluster, the second writes the indices behind the prefix sum of the counts.
+        light_data_.clear();
+        std::fill(cluster_data_.begin(), cluster_data_.end(), 0);
+        auto cluster = [this](int x, int y, int z) {
+            return (z * tiles_y_ + y) * tiles_x_ + x;
+        };
+
+        for (auto i = size_t{0}; i < lights.size(); ++i) {
+            auto& range = ranges_[i];
+            if (range.min_x > range.max_x) {
+                continue;
+            }
+            auto& light = lights[i];
+            light_data_.emplace_back(light.position, light.radius);
+            light_data_.emplace_back(light.color * fade_values_[i], light.exponent);
+            for (auto z = range.min_z; z <= range.max_z; ++z) {
+                for (auto y = range.min_y; y <= range.max_y; ++y) {
+                    for (auto x = range.min_x; x <= range.max_x; ++x) {
+                        ++cluster_data_[cluster(x, y, z) * 2 + 1];
+                    }
+                }
+            }
+        }
+        visible_lights_ = light_data_.size() / 2;
+
+        auto offset = uint32_t{0};
+        for (auto c = size_t{0}; c < cluster_data_.size(); c += 2) {
+            cluster_data_[c] = offset;
+            offset += cluster_data_[c + 1];
+            cluster_data_[c + 1] = 0;
+        }
+
+        light_indices_.resize(offset);
+        auto index = uint32_t{0};
+        for (auto i = size_t{0}; i < lights.size(); ++i) {
+            auto& range = ranges_[i];
+            if (range.min_x > range.max_x) {
+                continue;
+            }
+            for (auto z = range.min_z; z <= range.max_z; ++z) {
+                for (auto y = range.min_y; y <= range.max_y; ++y) {
+                    for (auto x = range.min_x; x <= range.max_x; ++x) {
+                        auto c = cluster(x, y, z) * 2;
+                        light_indices_[cluster_data_[c] + cluster_data_[c + 1]++] = index;
+                    }
+                }
+            }
+            ++index;
+        }
+    }
+
+    void light_culler::upload() {
+        // buffer textures must not be empty, so an unused element is uploaded when there is nothing to shade
+        const static glm::vec4 empty_light[2] = {glm::vec4{0.f}, glm::vec4{0.f}};
+        const static uint32_t empty_index = 0;
+
+        if (uploaded_frame_ == frame_) {
+            return;
+        }
+        uploaded_frame_ = frame_;
+
+        light_buffer_.next_frame();
+        cluster_buffer_.next_frame();
+        index_buffer_.next_frame();
+
+        auto light_data = light_data_.empty() ? static_cast<const void*>(empty_light) : light_data_.data();
+        auto light_size = light_data_.empty() ? sizeof(empty_light) : light_data_.size() * sizeof(glm::vec4);
+        auto offset = light_buffer_.write(light_data, light_size);
+        light_texture_->view(GL_RGBA32F, light_buffer_, offset, light_size);
+
+        auto cluster_size = cluster_data_.size() * sizeof(uint32_t);
+        offset = cluster_buffer_.write(cluster_data_.data(), cluster_size);
+        cluster_texture_->view(GL_RG32UI, cluster_buffer_, offset, cluster_size);
+
+        auto index_data = light_indices_.empty() ? static_cast<const void*>(&empty_index) : light_indices_.data();
+        auto index_size = light_indices_.empty() ? sizeof(empty_index) : light_indices_.size() * sizeof(uint32_t);
+        offset = index_buffer_.write(index_data, index_size);
+        index_texture_->view(GL_R32UI, index_buffer_, offset, index_size);
+    }
+
+    void light_culler::bind(uint32_t light_unit, uint32_t cluster_unit, uint32_t index_unit) const noexcept {
+        light_texture_->bind(light_unit);
+        cluster_texture_->bind(cluster_unit);
+        index_texture_->bind(index_unit);
+    }
+
+    void light_culler::setup_program(program& program) const {
+        program.uniform("cluster_dimensions", glm::ivec3{tiles_x_, tiles_y_, slices_});
+        program.uniform("cluster_near_plane", near_plane_);
+        program.uniform("cluster_depth_scale", slices_ / std::log(far_plane_ / near_plane_));
+    }
+
+    int light_culler::slice(float depth) const noexcept {
+        auto s = static_cast<int>(std::log(depth / near_plane_) / std::log(far_plane_ / near_plane_) * slices_);
+        return glm::clamp(s, 0, slices_ - 1);
+    }
+}
@@ -0,0 +1,32 @@
+#include <zombye/rendering/material_table.hpp>
+#include <zombye/rendering/texture.hpp>
+#include <zombye/rendering/texture_array_manager.hpp>
+
+namespace zombye {
+    material_table::material_table()
+    : materials_(1, glm::ivec4{0}), dirty_{true} {
+        buffer_ = std::make_unique<texture_buffer>(sizeof(glm::ivec4), materials_.data(), GL_STATIC_DRAW);
+        texture_ = std::make_unique<zombye::texture>(GL_RGBA32I, *buffer_);
+    }
+
+    material_table::~material_table() noexcept = default;
+
+    uint32_t material_table::id(const texture_layer& diffuse, const texture_layer& material,
+    const texture_layer& normal) {
+        auto entry = ids_.emplace(key{diffuse.layer(), material.layer(), normal.layer()},
+            static_cast<uint32_t>(materials_.size()));
+        if (entry.second) {
+            materials_.emplace_back(glm::ivec4{diffuse.layer(), material.layer(), normal.layer(), 0});
+            dirty_ = true;
+        }
+        return entry.first->second;
+    }
+
+    void material_table::bind(uint32_t unit) {
+        if (dirty_) {
+            buffer_->data(materials_.size() * sizeof(glm::ivec4), materials_.data());
+            dirty_ = false;
+        }
+        texture_->bind(unit);
+    }
+}
@@ -1,86 +1,297 @@
+#include <algorithm>
+#include <unordered_map>
+
 #include <mesh_converter/mesh_converter.hpp>
+#include <zombye/rendering/gl_backend.hpp>
 #include <zombye/rendering/mesh.hpp>
 #include <zombye/rendering/rendering_system.hpp>
 #include <zombye/rendering/texture.hpp>
+#include <zombye/rendering/texture_array_manager.hpp>
 
 namespace zombye {
-    mesh::mesh(rendering_system& rendering_system, const std::vector<char>& source, const std::string& file_name) noexcept
-    : vbo_{0, GL_STATIC_DRAW}, ibo_{0, GL_STATIC_DRAW}, parallax_mapping_{false} {
-        auto data_ptr = source.data();
+    GLenum index_type(uint32_t index_size, uint64_t vertex_count) noexcept {
+        return index_size == sizeof(uint16_t) || vertex_count < 65536 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    }
 
-        auto head = *reinterpret_cast<const header*>(data_ptr);
-        if (head.magic != 0x31424D5A) {
-            throw std::runtime_error(file_name + " is not an zombye mesh file");
+    const void* convert_indices(const char* data, uint64_t index_count, uint32_t index_size, GLenum type,
+    std::vector<uint16_t>& storage) {
+        if (type == GL_UNSIGNED_INT || index_size == sizeof(uint16_t)) {
+            return data;
         }
+        auto indices = reinterpret_cast<const uint32_t*>(data);
+        storage.assign(indices, indices + index_count);
+        return storage.data();
+    }
 
-        parallax_mapping_ = head.parallax_mapping;
+    GLenum upload_indices(index_buffer& ibo, const char* data, uint64_t index_count, uint32_t index_size,
+    uint64_t vertex_count) {
+        auto type = index_type(index_size, vertex_count);
+        auto storage = std::vector<uint16_t>{};
+        auto indices = convert_indices(data, index_count, index_size, type, storage);
+        ibo.data(index_count * (type == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t)), indices);
+        return type;
+    }
 
-        auto vertex_size = head.vertex_count * sizeof(vertex);
-        auto index_size = head.index_count * sizeof(uint32_t);
-        auto size = sizeof(header)
-            + vertex_size
-            + index_size
-            + head.submesh_count * sizeof(devtools::submesh);
+    std::vector<mesh_lod> read_lods(const char* data, uint64_t lod_count, const std::vector<submesh>& submeshes,
+    const std::string& file_name) {
+        std::vector<mesh_lod> lods;
+        if (lod_count == 0) {
+            lods.emplace_back(mesh_lod{0, submeshes.size(), 0, 0, 0.f});
+        }
+        auto entries = reinterpret_cast<const devtools::lod*>(data);
+        for (auto i = uint64_t{0}; i < lod_count; ++i) {
+            auto& entry = entries[i];
+            if (entry.submesh_count == 0 || entry.first_submesh + entry.submesh_count > submeshes.size()) {
+                throw std::runtime_error(file_name + " has an invalid level of detail " + std::to_string(i));
+            }
+            lods.emplace_back(mesh_lod{entry.first_submesh, entry.submesh_count, 0, 0, entry.error});
+        }
+        for (auto& lod : lods) {
+            if (lod.submesh_count == 0) {
+                continue;
+            }
+            auto& first = submeshes[lod.first_submesh];
+            auto& last = submeshes[lod.first_submesh + lod.submesh_count - 1];
+            lod.first_index = first.offset;
+            lod.index_count = last.offset + last.index_count - first.offset;
+        }
+        return lods;
+    }
 
-        if (size != source.size()) {
-            throw std::runtime_error(file_name + " has not the apropriate size. expected size: "
-                + std::to_string(source.size()) + " calculated size: " + std::to_string(size));
+    size_t select_lod(const std::vector<mesh_lod>& lods, size_t current, float pixels_per_unit, float max_pixel_error,
+    float hysteresis) noexcept {
+        auto fine = size_t{0};
+        auto coarse = size_t{0};
+        for (auto i = size_t{1}; i < lods.size(); ++i) {
+            auto error = lods[i].error * pixels_per_unit;
+            if (error <= max_pixel_error) {
+                fine = i;
+            }
+            if (error <= max_pixel_error * (1.f - hysteresis)) {
+                coarse = i;
+            }
         }
-        data_ptr += sizeof(header);
+        current = std::min(current, lods.size() - 1);
+        if (current > fine) {
+            return fine;
+        }
+        if (current < coarse) {
+            return coarse;
+        }
+        return current;
+    }
 
-        vbo_.data(vertex_size, data_ptr);
-        data_ptr += vertex_size;
+    mesh_data read_mesh(const std::vector<char>& source, const std::string& file_name) {
+        auto data = mesh_data{};
+        auto data_ptr = source.data();
 
-        ibo_.data(index_size, data_ptr);
-        data_ptr += index_size;
+        auto magic = *reinterpret_cast<const uint32_t*>(data_ptr);
+        auto index_count = uint64_t{0};
+        auto submesh_count = uint64_t{0};
+        auto lod_count = uint64_t{0};
+        auto index_size = uint32_t{0};
 
-        for (auto i = 0; i < head.submesh_count; ++i) {
-            submesh s;
+        if (magic == 0x32424D5A) {
+            auto head = *reinterpret_cast<const devtools::packed_header*>(data_ptr);
+            if (head.version != 2 && head.version != 3) {
+                throw std::runtime_error(file_name + " has the unsupported mesh version " + std::to_string(head.version));
+            }
+            if (head.index_size != sizeof(uint16_t) && head.index_size != sizeof(uint32_t)) {
+                throw std::runtime_error(file_name + " has an invalid index size " + std::to_string(head.index_size));
+            }
 
-            s.index_count = *reinterpret_cast<const uint64_t*>(data_ptr);
-            data_ptr += sizeof(uint64_t);
-            s.offset = *reinterpret_cast<const uint64_t*>(data_ptr);
-            data_ptr += sizeof(uint64_t);
+            data.parallax_mapping = head.parallax_mapping;
+            data.vertex_format = head.vertex_format;
+            data.vertex_count = head.vertex_count;
+            index_count = head.index_count;
+            submesh_count = head.submesh_count;
+            index_size = head.index_size;
+            lod_count = head.version >= 3 ? head.lod_count : 0;
 
-            auto texture_id = *reinterpret_cast<const uint64_t*>(data_ptr);
-            auto texture_name = std::to_string(texture_id) + ".dds";
-            s.diffuse = rendering_system.texture_manager().load("texture/" + texture_name);
-            if (!s.diffuse) {
-                throw std::runtime_error("could not load texure " + texture_name);
+            auto half_positions = (data.vertex_format & devtools::half_positions) != 0;
+            auto position_size = data.vertex_count * (half_positions ? 4 * sizeof(uint16_t) : sizeof(glm::vec3));
+            auto attribute_size = data.vertex_count * sizeof(devtools::packed_attributes);
+            auto size = sizeof(devtools::packed_header)
+                + position_size
+                + attribute_size
+                + index_count * index_size
+                + submesh_count * sizeof(devtools::submesh)
+                + lod_count * sizeof(devtools::lod);
+
+            if (size != source.size()) {
+                throw std::runtime_error(file_name + " has not the apropriate size. expected size: "
+                    + std::to_string(source.size()) + " calculated size: " + std::to_string(size));
             }
-            data_ptr += sizeof(uint64_t);
+            data_ptr += sizeof(devtools::packed_header);
 
-            texture_id = *reinterpret_cast<const unsigned long*>(data_ptr);
-            texture_name = std::to_string(texture_id) + ".dds";
-            s.normal = rendering_system.texture_manager().load("texture/" + texture_name);
-            if (!s.normal) {
-                throw std::runtime_error("could not load texure " + texture_name);
+            data.positions.assign(data_ptr, data_ptr + position_size);
+            data_ptr += position_size;
+            auto attributes = reinterpret_cast<const devtools::packed_attributes*>(data_ptr);
+            data.attributes.assign(attributes, attributes + data.vertex_count);
+            data_ptr += attribute_size;
+
+            data.bounds = bounding_box{glm::vec3{0.f}, glm::vec3{0.f}};
+            if (data.vertex_count > 0) {
+                data.bounds = bounding_box{data.position(0), data.position(0)};
             }
-            data_ptr += sizeof(uint64_t);
+            for (auto i = uint64_t{0}; i < data.vertex_count; ++i) {
+                data.bounds.min = glm::min(data.bounds.min, data.position(i));
+                data.bounds.max = glm::max(data.bounds.max, data.position(i));
+            }
+        } else if (magic == 0x31424D5A) {
+            auto head = *reinterpret_cast<const header*>(data_ptr);
 
-            texture_id = *reinterpret_cast<const unsigned long*>(data_ptr);
-            texture_name = std::to_string(texture_id) + ".dds";
-            s.material = rendering_system.texture_manager().load("texture/" + texture_name);
-            if (!s.material) {
-                throw std::runtime_error("could not load texure " + texture_name);
+            data.parallax_mapping = head.parallax_mapping;
+            data.vertex_count = head.vertex_count;
+            index_count = head.index_count;
+            submesh_count = head.submesh_count;
+            index_size = sizeof(uint32_t);
+
+            auto vertex_size = data.vertex_count * sizeof(vertex);
+            auto position_size = data.vertex_count * sizeof(glm::vec3);
+            auto size = sizeof(header)
+                + vertex_size
+                + index_count * index_size
+                + submesh_count * sizeof(devtools::submesh);
+
+            // later version 1 files carry a de-interleaved position stream behind the submeshes
+            if (size + position_size == source.size()) {
+                size += position_size;
+            }
+
+            if (size != source.size()) {
+                throw std::runtime_error(file_name + " has not the apropriate size. expected size: "
+                    + std::to_string(source.size()) + " calculated size: " + std::to_string(size));
+            }
+            data_ptr += sizeof(header);
+
+            auto vertices = reinterpret_cast<const vertex*>(data_ptr);
+            data.bounds = bounding_box{glm::vec3{0.f}, glm::vec3{0.f}};
+            if (data.vertex_count > 0) {
+                data.bounds = bounding_box{vertices[0].position, vertices[0].position};
+            }
+            auto unorm_texcoords = true;
+            for (auto i = uint64_t{0}; i < data.vertex_count; ++i) {
+                data.bounds.min = glm::min(data.bounds.min, vertices[i].position);
+                data.bounds.max = glm::max(data.bounds.max, vertices[i].position);
+                unorm_texcoords = unorm_texcoords && devtools::fits_unorm(vertices[i].texcoord);
+            }
+            if (unorm_texcoords) {
+                data.vertex_format |= devtools::unorm_texcoords;
             }
-            data_ptr += sizeof(uint64_t);
 
+            data.positions.resize(position_size);
+            data.attributes.resize(data.vertex_count);
+            auto positions = reinterpret_cast<glm::vec3*>(data.positions.data());
+            for (auto i = uint64_t{0}; i < data.vertex_count; ++i) {
+                positions[i] = vertices[i].position;
+                data.attributes[i] = devtools::pack_attributes(vertices[i].texcoord, vertices[i].normal,
+                    vertices[i].tangent, unorm_texcoords);
+            }
+            data_ptr += vertex_size;
+        } else {
+            throw std::runtime_error(file_name + " is not an zombye mesh file");
+        }
+
+        data.indices.resize(index_count);
+        if (index_size == sizeof(uint16_t)) {
+            auto indices = reinterpret_cast<const uint16_t*>(data_ptr);
+            std::copy(indices, indices + index_count, data.indices.begin());
+        } else {
+            auto indices = reinterpret_cast<const uint32_t*>(data_ptr);
+            std::copy(indices, indices + index_count, data.indices.begin());
+        }
+        data_ptr += index_count * index_size;
+
+        auto submeshes = reinterpret_cast<const devtools::submesh*>(data_ptr);
+        data.submeshes.assign(submeshes, submeshes + submesh_count);
+        data_ptr += submesh_count * sizeof(devtools::submesh);
+
+        auto lods = reinterpret_cast<const devtools::lod*>(data_ptr);
+        data.lods.assign(lods, lods + lod_count);
+        return data;
+    }
+
+    mesh::mesh(rendering_system& rendering_system, const std::vector<char>& source, const std::string& file_name) noexcept
+    : mesh{rendering_system, read_mesh(source, file_name), file_name} {}
+
+    mesh::mesh(rendering_system& rendering_system, const mesh_data& data, const std::string& name)
+    : arena_(rendering_system.geometry_arena()), name_{name}, index_count_{data.indices.size()},
+    index_type_{index_type(sizeof(uint32_t), data.vertex_count)}, parallax_mapping_{data.parallax_mapping},
+    bounds_(data.bounds) {
+        auto index_storage = std::vector<uint16_t>{};
+        auto indices = convert_indices(reinterpret_cast<const char*>(data.indices.data()), index_count_,
+            sizeof(uint32_t), index_type_, index_storage);
+        geometry_ = arena_.allocate(data.vertex_format, index_type_, data.vertex_count, data.positions.data(),
+            data.attributes.data(), index_count_, indices);
+        auto gpu_size = data.positions.size() + data.attributes.size() * sizeof(devtools::packed_attributes)
+            + index_count_ * (index_type_ == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t));
+
+        auto load_texture = [&rendering_system](uint64_t texture_id) {
+            auto texture_name = std::to_string(texture_id) + ".dds";
+            auto texture = rendering_system.texture_array_manager().load("texture/" + texture_name);
+            if (!texture) {
+                throw std::runtime_error("could not load texure " + texture_name);
+            }
+            return texture;
+        };
+        for (auto& entry : data.submeshes) {
+            submesh s;
+            s.index_count = entry.index_count;
+            s.offset = entry.offset;
+            s.diffuse_layer = load_texture(entry.diffuse);
+            s.normal_layer = load_texture(entry.normal);
+            s.material_layer = load_texture(entry.material);
+            s.material_id = rendering_system.material_table().id(*s.diffuse_layer, *s.material_layer,
+                *s.normal_layer);
             submeshes_.emplace_back(s);
         }
+        lods_ = read_lods(reinterpret_cast<const char*>(data.lods.data()), data.lods.size(), submeshes_, name);
 
-        vao_.bind_index_buffer(ibo_);
-        rendering_system.staticmesh_layout().setup_layout(vao_, &vbo_);
+        // the occluder is the finest level under the triangle limit, so it sticks out of the real surface as
+        // little as possible. only the vertices that level references are kept.
+        auto level = std::find_if(lods_.begin(), lods_.end(), [](const mesh_lod& lod) {
+            return lod.index_count <= 3 * occluder_mesh::max_occluder_triangles;
+        });
+        if (level != lods_.end()) {
+            auto remap = std::unordered_map<uint32_t, uint32_t>{};
+            occluder_.error = level->error;
+            for (auto i = level->first_index; i < level->first_index + level->index_count; ++i) {
+                auto vertex = data.indices[i];
+                auto entry = remap.emplace(vertex, static_cast<uint32_t>(occluder_.positions.size()));
+                if (entry.second) {
+                    occluder_.positions.emplace_back(data.position(vertex));
+                }
+                occluder_.indices.emplace_back(entry.first->second);
+            }
+        }
+        rendering_system.record_mesh_memory(data.vertex_count * (sizeof(vertex) + sizeof(glm::vec3))
+            + lods_[0].index_count * sizeof(uint32_t), gpu_size);
     }
 
-    void mesh::draw() const noexcept {
-        vao_.bind();
-        for (auto& sub : submeshes_) {
-            sub.diffuse->bind(0);
-            sub.material->bind(1);
-            sub.normal->bind(2);
-            glDrawElements(GL_TRIANGLES, sub.index_count, GL_UNSIGNED_INT,
-                reinterpret_cast<void*>(sub.offset * sizeof(unsigned int)));
+    mesh::~mesh() noexcept {
+        arena_.free(geometry_);
+    }
+
+    void mesh::draw(size_t lod) const noexcept {
+        auto index_size = index_type_ == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+        auto& level = lods_[lod];
+        geometry_.page->vao.bind();
+        for (auto i = level.first_submesh; i < level.first_submesh + level.submesh_count; ++i) {
+            auto& sub = submeshes_[i];
+            sub.diffuse_layer->array().bind(0);
+            sub.material_layer->array().bind(1);
+            sub.normal_layer->array().bind(2);
+            gl.draw_elements_base_vertex(GL_TRIANGLES, sub.index_count, index_type_,
+                reinterpret_cast<void*>((geometry_.first_index + sub.offset) * index_size), geometry_.base_vertex);
         }
     }
+
+    void mesh::draw_depth(size_t lod) const noexcept {
+        auto index_size = index_type_ == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+        auto& level = lods_[lod];
+        geometry_.page->depth_vao.bind();
+        gl.draw_elements_base_vertex(GL_TRIANGLES, level.index_count, index_type_,
+            reinterpret_cast<void*>((geometry_.first_index + level.first_index) * index_size), geometry_.base_vertex);
+    }
 }
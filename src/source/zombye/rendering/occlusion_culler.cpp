@@ -0,0 +1,319 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define ZOMBYE_OCCLUSION_SSE
+#endif
+
+#include <zombye/rendering/camera_component.hpp>
+#include <zombye/rendering/occlusion_culler.hpp>
+#include <zombye/utils/thread_pool.hpp>
+
+namespace zombye {
+    namespace {
+        // clip space w below which a vertex counts as behind the camera
+        const float near_w = 1e-4f;
+
+        // rows rasterised by one task
+        const int band_height = 8;
+    }
+
+    occlusion_culler::occlusion_culler(int width, int height, size_t max_occluders)
+    : width_{(std::max(width, 4) + 3) & ~3}, height_{std::max(height, 1)}, max_occluders_{max_occluders},
+    projection_view_{1.f}, active_{false}, tested_{0}, culled_{0} {
+        depth_.assign(width_ * height_, 1.f);
+    }
+
+    void occlusion_culler::render(const std::vector<occluder>& occluders, const camera_component& camera,
+    thread_pool& pool) {
+        const static auto grain = size_t{64};
+
+        projection_view_ = camera.projection_view();
+        active_ = true;
+        tested_ = 0;
+        culled_ = 0;
+        std::fill(depth_.begin(), depth_.end(), 1.f);
+
+        // the squared ratio of bounding sphere radius and distance approximates the covered screen area
+        auto camera_position = camera.owner().position();
+        auto pixels_per_unit = camera.projection()[1][1] * 0.5f * height_;
+        importance_.resize(occluders.size());
+        pool.parallel_for(occluders.size(), grain, [this, &occluders, camera_position, pixels_per_unit](size_t begin,
+        size_t end) {
+            for (auto i = begin; i < end; ++i) {
+                auto& occluder = occluders[i];
+                importance_[i] = 0.f;
+                if (!occluder.mesh || occluder.mesh->indices.empty()) {
+                    continue;
+                }
+                auto& model = occluder.model;
+                auto scale = std::max(glm::length(glm::vec3{model[0]}),
+                    std::max(glm::length(glm::vec3{model[1]}), glm::length(glm::vec3{model[2]})));
+                auto radius = glm::length(occluder.bounds.extent()) * scale;
+                auto center = glm::vec3{model * glm::vec4{occluder.bounds.center(), 1.f}};
+                auto clip = projection_view_ * glm::vec4{center, 1.f};
+                if (clip.w + radius <= 0.f) {
+                    continue;
+                }
+                // the error is projected at the point of the bounding sphere nearest to the camera
+                if (occluder.mesh->error > 0.f) {
+                    auto nearest = glm::length(center - camera_position) - radius;
+                    if (nearest <= 0.f || occluder.mesh->error * scale * pixels_per_unit / nearest >= 1.f) {
+                        continue;
+                    }
+                }
+                auto distance = std::max(glm::length(center - camera_position), radius);
+                importance_[i] = (radius * radius) / (distance * distance);
+            }
+        });
+
+        candidates_.clear();
+        for (auto i = size_t{0}; i < occluders.size(); ++i) {
+            if (importance_[i] > 0.f) {
+                candidates_.emplace_back(i);
+            }
+        }
+        auto budget = std::min(candidates_.size(), max_occluders_);
+        std::nth_element(candidates_.begin(), candidates_.begin() + budget, candidates_.end(),
+            [this](size_t lhs, size_t rhs) {
+                return importance_[lhs] > importance_[rhs];
+            });
+        candidates_.resize(budget);
+
+        triangle_offsets_.resize(budget + 1);
+        triangle_offsets_[0] = 0;
+        for (auto i = size_t{0}; i < budget; ++i) {
+            triangle_offsets_[i + 1] = triangle_offsets_[i] + occluders[candidates_[i]].mesh->indices.size() / 3;
+        }
+        triangles_.resize(triangle_offsets_.back());
+        pool.parallel_for(budget, 1, [this, &occluders](size_t begin, size_t end) {
+            for (auto i = begin; i < end; ++i) {
+                setup_triangles(i, occluders);
+            }
+        });
+
+        // every band walks all triangles, but only rasterises the rows it owns, so no two threads write the
+        // same pixel
+        auto bands = static_cast<size_t>((height_ + band_height - 1) / band_height);
+        pool.parallel_for(bands, 1, [this](size_t begin, size_t end) {
+            for (auto band = begin; band < end; ++band) {
+                auto band_min = static_cast<int>(band) * band_height;
+                auto band_max = std::min(band_min + band_height, height_) - 1;
+                for (auto& triangle : triangles_) {
+                    if (triangle.min_y > band_max || triangle.max_y < band_min) {
+                        continue;
+                    }
+                    rasterize(triangle, std::max(triangle.min_y, band_min), std::min(triangle.max_y, band_max));
+                }
+            }
+        });
+
+        frame_statistics_.occluders = budget;
+        frame_statistics_.occluder_triangles = triangles_.size();
+    }
+
+    void occlusion_culler::disable() noexcept {
+        active_ = false;
+        frame_statistics_ = occlusion_statistics{};
+        tested_ = 0;
+        culled_ = 0;
+    }
+
+    bool occlusion_culler::visible(const glm::mat4& model, const bounding_box& bounds) const noexcept {
+        if (!active_) {
+            return true;
+        }
+        ++tested_;
+
+        auto transform = projection_view_ * model;
+        auto min_screen = glm::vec2{std::numeric_limits<float>::max()};
+        auto max_screen = glm::vec2{-std::numeric_limits<float>::max()};
+        auto min_depth = std::numeric_limits<float>::max();
+        for (auto c = 0; c < 8; ++c) {
+            auto corner = glm::vec3{(c & 1) ? bounds.max.x : bounds.min.x, (c & 2) ? bounds.max.y : bounds.min.y,
+                (c & 4) ? bounds.max.z : bounds.min.z};
+            auto clip = transform * glm::vec4{corner, 1.f};
+            // boxes reaching behind the camera are kept, their projection is unbounded
+            if (clip.w <= near_w) {
+                return true;
+            }
+            auto ndc = glm::vec3{clip} / clip.w;
+            min_screen = glm::min(min_screen, glm::vec2{ndc});
+            max_screen = glm::max(max_screen, glm::vec2{ndc});
+            min_depth = std::min(min_depth, ndc.z * 0.5f + 0.5f);
+        }
+        if (min_screen.x > 1.f || min_screen.y > 1.f || max_screen.x < -1.f || max_screen.y < -1.f
+        || min_depth > 1.f) {
+            ++culled_;
+            return false;
+        }
+
+        // the rectangle is grown by a pixel, since occluders only cover the pixels whose centers they contain
+        auto min_x = glm::clamp(static_cast<int>(std::floor((min_screen.x * 0.5f + 0.5f) * width_)) - 1, 0, width_ - 1);
+        auto max_x = glm::clamp(static_cast<int>(std::floor((max_screen.x * 0.5f + 0.5f) * width_)) + 1, 0, width_ - 1);
+        auto min_y = glm::clamp(static_cast<int>(std::floor((min_screen.y * 0.5f + 0.5f) * height_)) - 1, 0, height_ - 1);
+        auto max_y = glm::clamp(static_cast<int>(std::floor((max_screen.y * 0.5f + 0.5f) * height_)) + 1, 0, height_ - 1);
+
+#ifdef ZOMBYE_OCCLUSION_SSE
+        auto depth = _mm_set1_ps(min_depth);
+        auto first = _mm_set1_epi32(min_x);
+        auto last = _mm_set1_epi32(max_x);
+        auto lanes = _mm_setr_epi32(0, 1, 2, 3);
+        for (auto y = min_y; y <= max_y; ++y) {
+            auto row = depth_.data() + y * width_;
+            for (auto x = min_x & ~3; x <= max_x; x += 4) {
+                auto lane_x = _mm_add_epi32(_mm_set1_epi32(x), lanes);
+                auto inside = _mm_andnot_si128(_mm_or_si128(_mm_cmplt_epi32(lane_x, first), _mm_cmpgt_epi32(lane_x, last)),
+                    _mm_set1_epi32(-1));
+                auto farther = _mm_cmpge_ps(_mm_loadu_ps(row + x), depth);
+                if (_mm_movemask_ps(_mm_and_ps(farther, _mm_castsi128_ps(inside)))) {
+                    return true;
+                }
+            }
+        }
+#else
+        for (auto y = min_y; y <= max_y; ++y) {
+            auto row = depth_.data() + y * width_;
+            for (auto x = min_x; x <= max_x; ++x) {
+                if (row[x] >= min_depth) {
+                    return true;
+                }
+            }
+        }
+#endif
+        ++culled_;
+        return false;
+    }
+
+    occlusion_statistics occlusion_culler::statistics() const noexcept {
+        auto statistics = frame_statistics_;
+        statistics.tested = tested_;
+        statistics.culled = culled_;
+        return statistics;
+    }
+
+    void occlusion_culler::setup_triangles(size_t index, const std::vector<occluder>& occluders) {
+        auto& source = occluders[candidates_[index]];
+        auto& positions = source.mesh->positions;
+        auto& indices = source.mesh->indices;
+        auto transform = projection_view_ * source.model;
+        // mirroring transforms turn front faces clockwise
+        auto front = glm::determinant(glm::mat3{source.model}) < 0.f ? -1.f : 1.f;
+
+        auto screen = std::vector<glm::vec3>(positions.size());
+        auto clipped = std::vector<bool>(positions.size());
+        for (auto i = size_t{0}; i < positions.size(); ++i) {
+            auto clip = transform * glm::vec4{positions[i], 1.f};
+            clipped[i] = clip.w <= near_w;
+            if (clipped[i]) {
+                continue;
+            }
+            auto ndc = glm::vec3{clip} / clip.w;
+            screen[i] = glm::vec3{(ndc.x * 0.5f + 0.5f) * width_, (ndc.y * 0.5f + 0.5f) * height_, ndc.z * 0.5f + 0.5f};
+        }
+
+        auto out = triangles_.data() + triangle_offsets_[index];
+        for (auto i = size_t{0}; i < indices.size() / 3; ++i, ++out) {
+            out->min_y = 1;
+            out->max_y = 0;
+            auto a = indices[3 * i];
+            auto b = indices[3 * i + 1];
+            auto c = indices[3 * i + 2];
+            if (clipped[a] || clipped[b] || clipped[c]) {
+                continue;
+            }
+            auto& v0 = screen[a];
+            auto& v1 = screen[b];
+            auto& v2 = screen[c];
+            auto area = (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
+            if (area * front <= 0.f) {
+                continue;
+            }
+            out->vertices[0] = v0;
+            // the rasteriser expects counter clockwise triangles
+            out->vertices[1] = front > 0.f ? v1 : v2;
+            out->vertices[2] = front > 0.f ? v2 : v1;
+            auto min_y = std::min(v0.y, std::min(v1.y, v2.y));
+            auto max_y = std::max(v0.y, std::max(v1.y, v2.y));
+            out->min_y = std::max(static_cast<int>(std::floor(min_y - 0.5f)), 0);
+            out->max_y = std::min(static_cast<int>(std::ceil(max_y - 0.5f)), height_ - 1);
+        }
+    }
+
+    void occlusion_culler::rasterize(const triangle& triangle, int min_y, int max_y) noexcept {
+        auto& v0 = triangle.vertices[0];
+        auto& v1 = triangle.vertices[1];
+        auto& v2 = triangle.vertices[2];
+
+        // edge functions are positive inside the counter clockwise triangle and evaluated at pixel centers
+        float edge_x[3] = {v1.y - v2.y, v2.y - v0.y, v0.y - v1.y};
+        float edge_y[3] = {v2.x - v1.x, v0.x - v2.x, v1.x - v0.x};
+        float edge_c[3] = {v1.x * v2.y - v2.x * v1.y, v2.x * v0.y - v0.x * v2.y, v0.x * v1.y - v1.x * v0.y};
+        auto area = edge_c[0] + edge_c[1] + edge_c[2];
+        if (!(area > 0.f)) {
+            return;
+        }
+        // window depth is affine in screen space
+        auto inverse_area = 1.f / area;
+        auto depth_x = (edge_x[1] * (v1.z - v0.z) + edge_x[2] * (v2.z - v0.z)) * inverse_area;
+        auto depth_y = (edge_y[1] * (v1.z - v0.z) + edge_y[2] * (v2.z - v0.z)) * inverse_area;
+        auto depth_c = v0.z - depth_x * v0.x - depth_y * v0.y;
+
+        auto min_x = std::max(static_cast<int>(std::floor(std::min(v0.x, std::min(v1.x, v2.x)) - 0.5f)), 0);
+        auto max_x = std::min(static_cast<int>(std::ceil(std::max(v0.x, std::max(v1.x, v2.x)) - 0.5f)), width_ - 1);
+        if (min_x > max_x) {
+            return;
+        }
+        min_x &= ~3;
+
+#ifdef ZOMBYE_OCCLUSION_SSE
+        auto offsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+        __m128 step_x[3];
+        for (auto e = 0; e < 3; ++e) {
+            step_x[e] = _mm_set1_ps(4.f * edge_x[e]);
+        }
+        auto depth_step = _mm_set1_ps(4.f * depth_x);
+        auto zero = _mm_setzero_ps();
+        for (auto y = min_y; y <= max_y; ++y) {
+            auto center_y = y + 0.5f;
+            auto x = _mm_add_ps(_mm_set1_ps(static_cast<float>(min_x)), offsets);
+            __m128 edges[3];
+            for (auto e = 0; e < 3; ++e) {
+                edges[e] = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(edge_x[e])), _mm_set1_ps(edge_y[e] * center_y + edge_c[e]));
+            }
+            auto depth = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(depth_x)), _mm_set1_ps(depth_y * center_y + depth_c));
+            auto row = depth_.data() + y * width_;
+            for (auto px = min_x; px <= max_x; px += 4) {
+                auto inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(edges[0], zero), _mm_cmpge_ps(edges[1], zero)),
+                    _mm_cmpge_ps(edges[2], zero));
+                if (_mm_movemask_ps(inside)) {
+                    auto stored = _mm_loadu_ps(row + px);
+                    auto nearer = _mm_min_ps(stored, depth);
+                    _mm_storeu_ps(row + px, _mm_or_ps(_mm_and_ps(inside, nearer), _mm_andnot_ps(inside, stored)));
+                }
+                for (auto e = 0; e < 3; ++e) {
+                    edges[e] = _mm_add_ps(edges[e], step_x[e]);
+                }
+                depth = _mm_add_ps(depth, depth_step);
+            }
+        }
+#else
+        for (auto y = min_y; y <= max_y; ++y) {
+            auto center_y = y + 0.5f;
+            auto row = depth_.data() + y * width_;
+            for (auto px = min_x; px <= max_x; ++px) {
+                auto center_x = px + 0.5f;
+                auto inside = true;
+                for (auto e = 0; e < 3; ++e) {
+                    inside = inside && edge_x[e] * center_x + edge_y[e] * center_y + edge_c[e] >= 0.f;
+                }
+                if (inside) {
+                    row[px] = std::min(row[px], depth_x * center_x + depth_y * center_y + depth_c);
+                }
+            }
+        }
+#endif
+    }
+}
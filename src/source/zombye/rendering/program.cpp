@@ -1,176 +1,313 @@
+#include <chrono>
 #include <vector>
 
 #include <glm/gtc/type_ptr.hpp>
 
+#include <zombye/rendering/gl_backend.hpp>
 #include <zombye/rendering/program.hpp>
+#include <zombye/rendering/program_cache.hpp>
 #include <zombye/rendering/shader.hpp>
 #include <zombye/utils/logger.hpp>
 
 
 namespace zombye {
-    program::program() noexcept {
-        id_ = glCreateProgram();
+    namespace {
+        double milliseconds_since(std::chrono::steady_clock::time_point start) noexcept {
+            return std::chrono::duration<double, std::milli>{std::chrono::steady_clock::now() - start}.count();
+        }
+    }
+
+    program::program() noexcept
+    : attached_{false}, pending_cache_{nullptr}, key_{0}, issue_milliseconds_{0.0} {
+        id_ = gl.create_program();
     }
 
     program::program(program&& other) noexcept
-    : id_{other.id_}, shaders_{other.shaders_} {
+    : id_{other.id_}, shaders_{other.shaders_}, attached_{other.attached_}, link_state_{std::move(other.link_state_)},
+    pending_cache_{nullptr}, key_{other.key_}, link_start_{other.link_start_},
+    issue_milliseconds_{other.issue_milliseconds_}, uniform_locations_{std::move(other.uniform_locations_)} {
+        // the cache only knows the address of a pending program
+        if (other.pending_cache_) {
+            other.pending_cache_->remove_pending(&other);
+            pending_cache_ = other.pending_cache_;
+            pending_cache_->add_pending(this);
+            other.pending_cache_ = nullptr;
+        }
         other.id_ = 0;
+        other.attached_ = false;
     }
 
     program::~program() noexcept {
-        for (auto& shader : shaders_) {
-            glDetachShader(id_, shader->id_);
+        if (pending_cache_) {
+            pending_cache_->remove_pending(this);
+        }
+        if (attached_) {
+            for (auto& shader : shaders_) {
+                gl.detach_shader(id_, shader->id_);
+            }
         }
-        glDeleteProgram(id_);
+        gl.delete_program(id_);
     }
 
     program& program::operator=(program&& other) noexcept {
+        if (pending_cache_) {
+            pending_cache_->remove_pending(this);
+            pending_cache_ = nullptr;
+        }
         id_ = other.id_;
         shaders_ = other.shaders_;
+        attached_ = other.attached_;
+        link_state_ = std::move(other.link_state_);
+        key_ = other.key_;
+        link_start_ = other.link_start_;
+        issue_milliseconds_ = other.issue_milliseconds_;
+        uniform_locations_ = std::move(other.uniform_locations_);
+        if (other.pending_cache_) {
+            other.pending_cache_->remove_pending(&other);
+            pending_cache_ = other.pending_cache_;
+            pending_cache_->add_pending(this);
+            other.pending_cache_ = nullptr;
+        }
         other.id_ = 0;
+        other.attached_ = false;
 
         return *this;
     }
 
     void program::attach_shader(shader_ptr shader) {
         shaders_.emplace_back(shader);
-        glAttachShader(id_, shader->id_);
     }
 
     void program::bind_attribute_location(const std::string& name, uint32_t index) noexcept {
-        glBindAttribLocation(id_, index, name.c_str());
+        gl.bind_attrib_location(id_, index, name.c_str());
+        link_state_ += "attribute " + name + " " + std::to_string(index) + "\n";
     }
 
     void program::bind_frag_data_location(const std::string& name, uint32_t color_number) noexcept {
-        glBindFragDataLocation(id_, color_number, name.c_str());
+        gl.bind_frag_data_location(id_, color_number, name.c_str());
+        link_state_ += "fragment " + name + " " + std::to_string(color_number) + "\n";
+    }
+
+    void program::transform_feedback_varyings(const std::vector<std::string>& names, GLenum buffer_mode) noexcept {
+        auto varyings = std::vector<const GLchar*>{};
+        for (auto& name : names) {
+            varyings.emplace_back(name.c_str());
+            link_state_ += "varying " + name + " " + std::to_string(buffer_mode) + "\n";
+        }
+        gl.transform_feedback_varyings(id_, varyings.size(), varyings.data(), buffer_mode);
+    }
+
+    void program::link(program_cache* cache) {
+        link_start_ = std::chrono::steady_clock::now();
+        uniform_locations_.clear();
+
+        if (cache) {
+            key_ = cache->key(shaders_, link_state_);
+            if (cache->load(key_, id_)) {
+                cache->record_link(true);
+                log("program " + name() + " loaded from the program cache in "
+                    + std::to_string(milliseconds_since(link_start_)) + " ms");
+                return;
+            }
+            gl.program_parameteri(id_, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        }
+
+        if (!attached_) {
+            for (auto& shader : shaders_) {
+                gl.attach_shader(id_, shader->compile());
+            }
+            attached_ = true;
+        }
+        gl.link_program(id_);
+        issue_milliseconds_ = milliseconds_since(link_start_);
+
+        if (cache) {
+            pending_cache_ = cache;
+            cache->add_pending(this);
+            return;
+        }
+        finish_link();
+    }
+
+    bool program::link_completed() const noexcept {
+        if (!gl_caps().parallel_shader_compile) {
+            return true;
+        }
+        auto completed = 0;
+        gl.get_programiv(id_, GL_COMPLETION_STATUS_KHR, &completed);
+        return completed != 0;
     }
 
-    void program::link() {
-        glLinkProgram(id_);
+    void program::finish_link() {
+        for (auto& shader : shaders_) {
+            shader->check();
+        }
 
         auto length = 0;
-        glGetProgramiv(id_, GL_INFO_LOG_LENGTH, &length);
+        gl.get_programiv(id_, GL_INFO_LOG_LENGTH, &length);
         if (length > 1) {
             auto log_buffer = std::vector<char>(length);
-            glGetProgramInfoLog(id_, length, nullptr, log_buffer.data());
-            log("link log of program " + std::to_string(id_) + ": ");
+            gl.get_program_info_log(id_, length, nullptr, log_buffer.data());
+            log("link log of program " + name() + ": ");
             log(std::string{log_buffer.begin(), log_buffer.end()});
         }
 
         auto status = 0;
-        glGetProgramiv(id_, GL_LINK_STATUS, &status);
+        gl.get_programiv(id_, GL_LINK_STATUS, &status);
         if (!status) {
             for (auto& shader : shaders_) {
-                glDetachShader(id_, shader->id_);
+                gl.detach_shader(id_, shader->id_);
             }
-            glDeleteProgram(id_);
-            log(LOG_FATAL, "an error occured during linking of program " + std::to_string(id_));
+            gl.delete_program(id_);
+            log(LOG_FATAL, "an error occured during linking of program " + name());
+        }
+
+        if (pending_cache_) {
+            pending_cache_->store(key_, id_);
+            pending_cache_->record_link(false);
+            pending_cache_ = nullptr;
+        }
+        log("program " + name() + " issued in " + std::to_string(issue_milliseconds_) + " ms, compiled and linked after "
+            + std::to_string(milliseconds_since(link_start_)) + " ms");
+    }
+
+    std::string program::name() const {
+        auto name = std::string{};
+        for (auto& shader : shaders_) {
+            name += (name.empty() ? "" : ", ") + shader->name();
         }
+        return name;
     }
 
     void program::use() const noexcept {
-        glUseProgram(id_);
+        gl.use_program(id_);
+    }
+
+    GLint program::uniform_location(const std::string& name) noexcept {
+        auto it = uniform_locations_.find(name);
+        if (it != uniform_locations_.end()) {
+            return it->second;
+        }
+        auto location = gl.get_uniform_location(id_, name.c_str());
+        uniform_locations_.insert(std::make_pair(name, location));
+        return location;
+    }
+
+    void program::uniform(GLint location, float value) noexcept {
+        gl.uniform_1f(location, value);
+    }
+
+    void program::uniform(GLint location, int32_t value) noexcept {
+        gl.uniform_1i(location, value);
+    }
+
+    void program::uniform(GLint location, bool transpose, const glm::mat4& value) noexcept {
+        gl.uniform_matrix_4fv(location, 1, transpose, glm::value_ptr(value));
+    }
+
+    void program::uniform(GLint location, size_t count, bool transpose, const std::vector<glm::mat4>& values) noexcept {
+        gl.uniform_matrix_4fv(location, count, transpose, reinterpret_cast<const float*>(values.data()));
     }
 
     void program::uniform(const std::string& name, float value) noexcept {
-        glUniform1f(glGetUniformLocation(id_, name.c_str()), value);
+        gl.uniform_1f(uniform_location(name), value);
     }
 
     void program::uniform(const std::string& name, int32_t value) noexcept {
-        glUniform1i(glGetUniformLocation(id_, name.c_str()), value);
+        gl.uniform_1i(uniform_location(name), value);
     }
 
     void program::uniform(const std::string& name, uint32_t value) noexcept {
-        glUniform1ui(glGetUniformLocation(id_, name.c_str()), value);
+        gl.uniform_1ui(uniform_location(name), value);
     }
 
     void program::uniform(const std::string& name, const glm::vec2& value) noexcept {
-        glUniform2fv(glGetUniformLocation(id_, name.c_str()), 1, glm::value_ptr(value));
+        gl.uniform_2fv(uniform_location(name), 1, glm::value_ptr(value));
     }
 
     void program::uniform(const std::string& name, const glm::vec3& value) noexcept {
-        glUniform3fv(glGetUniformLocation(id_, name.c_str()), 1, glm::value_ptr(value));
+        gl.uniform_3fv(uniform_location(name), 1, glm::value_ptr(value));
     }
 
     void program::uniform(const std::string& name, const glm::vec4& value) noexcept {
-        glUniform4fv(glGetUniformLocation(id_, name.c_str()), 1, glm::value_ptr(value));
+        gl.uniform_4fv(uniform_location(name), 1, glm::value_ptr(value));
     }
 
     void program::uniform(const std::string& name, const glm::ivec2& value) noexcept {
-        glUniform2iv(glGetUniformLocation(id_, name.c_str()), 1, glm::value_ptr(value));
+        gl.uniform_2iv(uniform_location(name), 1, glm::value_ptr(value));
     }
 
     void program::uniform(const std::string& name, const glm::ivec3& value) noexcept {
-        glUniform3iv(glGetUniformLocation(id_, name.c_str()), 1, glm::value_ptr(value));
+        gl.uniform_3iv(uniform_location(name), 1, glm::value_ptr(value));
     }
 
     void program::uniform(const std::string& name, const glm::ivec4& value) noexcept {
-        glUniform4iv(glGetUniformLocation(id_, name.c_str()), 1, glm::value_ptr(value));
+        gl.uniform_4iv(uniform_location(name), 1, glm::value_ptr(value));
     }
 
     void program::uniform(const std::string& name, bool transpose, const glm::mat2& value) noexcept {
-        glUniformMatrix2fv(glGetUniformLocation(id_, name.c_str()), 1, transpose, glm::value_ptr(value));
+        gl.uniform_matrix_2fv(uniform_location(name), 1, transpose, glm::value_ptr(value));
     }
 
     void program::uniform(const std::string& name, bool transpose, const glm::mat3& value) noexcept {
-        glUniformMatrix3fv(glGetUniformLocation(id_, name.c_str()), 1, transpose, glm::value_ptr(value));
+        gl.uniform_matrix_3fv(uniform_location(name), 1, transpose, glm::value_ptr(value));
     }
 
     void program::uniform(const std::string& name, bool transpose, const glm::mat4& value) noexcept {
-        glUniformMatrix4fv(glGetUniformLocation(id_, name.c_str()), 1, transpose, glm::value_ptr(value));
+        gl.uniform_matrix_4fv(uniform_location(name), 1, transpose, glm::value_ptr(value));
     }
 
     void program::uniform(const std::string& name, size_t count, const std::vector<float>& values) noexcept {
-        glUniform1fv(glGetUniformLocation(id_, name.c_str()), count, reinterpret_cast<const float*>(values.data()));
+        gl.uniform_1fv(uniform_location(name), count, reinterpret_cast<const float*>(values.data()));
     }
 
     void program::uniform(const std::string& name, size_t count, const std::vector<int32_t>& values) noexcept {
-        glUniform1iv(glGetUniformLocation(id_, name.c_str()), count, reinterpret_cast<const int32_t*>(values.data()));
+        gl.uniform_1iv(uniform_location(name), count, reinterpret_cast<const int32_t*>(values.data()));
     }
 
     void program::uniform(const std::string& name, size_t count, const std::vector<uint32_t>& values) noexcept {
-        glUniform1uiv(glGetUniformLocation(id_, name.c_str()), count, reinterpret_cast<const uint32_t*>(values.data()));
+        gl.uniform_1uiv(uniform_location(name), count, reinterpret_cast<const uint32_t*>(values.data()));
     }
 
     void program::uniform(const std::string& name, size_t count, const std::vector<glm::vec2>& values) noexcept {
-        glUniform2fv(glGetUniformLocation(id_, name.c_str()), count,reinterpret_cast<const float*>(values.data()));
+        gl.uniform_2fv(uniform_location(name), count,reinterpret_cast<const float*>(values.data()));
     }
 
     void program::uniform(const std::string& name, size_t count, const std::vector<glm::vec3>& values) noexcept {
-        glUniform3fv(glGetUniformLocation(id_, name.c_str()), count, reinterpret_cast<const float*>(values.data()));
+        gl.uniform_3fv(uniform_location(name), count, reinterpret_cast<const float*>(values.data()));
     }
 
     void program::uniform(const std::string& name, size_t count, const std::vector<glm::vec4>& values) noexcept {
-        glUniform4fv(glGetUniformLocation(id_, name.c_str()), count, reinterpret_cast<const float*>(values.data()));
+        gl.uniform_4fv(uniform_location(name), count, reinterpret_cast<const float*>(values.data()));
     }
 
     void program::uniform(const std::string& name, size_t count, const std::vector<glm::ivec2>& values) noexcept {
-        glUniform2iv(glGetUniformLocation(id_, name.c_str()), count, reinterpret_cast<const int32_t*>(values.data()));
+        gl.uniform_2iv(uniform_location(name), count, reinterpret_cast<const int32_t*>(values.data()));
     }
 
     void program::uniform(const std::string& name, size_t count, const std::vector<glm::ivec3>& values) noexcept {
-        glUniform3iv(glGetUniformLocation(id_, name.c_str()), count, reinterpret_cast<const int32_t*>(values.data()));
+        gl.uniform_3iv(uniform_location(name), count, reinterpret_cast<const int32_t*>(values.data()));
     }
 
     void program::uniform(const std::string& name, size_t count, const std::vector<glm::ivec4>& values) noexcept {
-        glUniform4iv(glGetUniformLocation(id_, name.c_str()), count, reinterpret_cast<const int32_t*>(values.data()));
+        gl.uniform_4iv(uniform_location(name), count, reinterpret_cast<const int32_t*>(values.data()));
     }
 
     void program::uniform(const std::string& name, size_t count, bool transpose,
     const std::vector<glm::mat2>& values) noexcept {
-        glUniformMatrix2fv(glGetUniformLocation(id_, name.c_str()), count, transpose,
+        gl.uniform_matrix_2fv(uniform_location(name), count, transpose,
             reinterpret_cast<const float*>(values.data()));
     }
 
     void program::uniform(const std::string& name, size_t count, bool transpose,
     const std::vector<glm::mat3>& values) noexcept {
-        glUniformMatrix3fv(glGetUniformLocation(id_, name.c_str()), count, transpose,
+        gl.uniform_matrix_3fv(uniform_location(name), count, transpose,
             reinterpret_cast<const float*>(values.data()));
     }
 
     void program::uniform(const std::string& name, size_t count, bool transpose,
     const std::vector<glm::mat4>& values) noexcept {
-        glUniformMatrix4fv(glGetUniformLocation(id_, name.c_str()), count, transpose,
+        gl.uniform_matrix_4fv(uniform_location(name), count, transpose,
             reinterpret_cast<const float*>(values.data()));
     }
 }
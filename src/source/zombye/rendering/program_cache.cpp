@@ -0,0 +1,165 @@
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+
+#include <zombye/rendering/gl_backend.hpp>
+#include <zombye/rendering/program.hpp>
+#include <zombye/rendering/program_cache.hpp>
+#include <zombye/rendering/shader.hpp>
+#include <zombye/utils/logger.hpp>
+
+namespace zombye {
+    namespace {
+        const uint32_t program_cache_magic = 0x4752505a;
+
+        struct program_binary_header {
+            uint32_t magic;
+            uint64_t key;
+            uint32_t format;
+            uint32_t length;
+        };
+
+        // fnv-1a, the hash only has to tell different sources apart
+        uint64_t hash(uint64_t seed, const void* data, size_t size) noexcept {
+            auto bytes = reinterpret_cast<const unsigned char*>(data);
+            for (auto i = size_t{0}; i < size; ++i) {
+                seed ^= bytes[i];
+                seed *= 1099511628211ull;
+            }
+            return seed;
+        }
+
+        uint64_t hash(uint64_t seed, const std::string& value) noexcept {
+            // the size separates consecutive strings
+            auto size = static_cast<uint64_t>(value.size());
+            seed = hash(seed, &size, sizeof(size));
+            return hash(seed, value.data(), value.size());
+        }
+
+        std::string driver_string(GLenum name) {
+            auto value = gl.get_string(name);
+            return value ? std::string{reinterpret_cast<const char*>(value)} : std::string{};
+        }
+    }
+
+    program_cache::program_cache(const std::string& directory)
+    : directory_{directory}, enabled_{gl_caps().program_binary}, store_failed_{false} {
+        driver_ = driver_string(GL_VENDOR) + "\n" + driver_string(GL_RENDERER) + "\n" + driver_string(GL_VERSION);
+        if (!enabled_) {
+            log("program binaries are not supported, every program is compiled");
+        }
+        if (gl_caps().parallel_shader_compile) {
+            gl.max_shader_compiler_threads(0xffffffff);
+            log("compiling shaders on driver threads");
+        }
+    }
+
+    uint64_t program_cache::key(const std::vector<shader_ptr>& shaders, const std::string& link_state) const noexcept {
+        auto seed = hash(14695981039346656037ull, driver_);
+        for (auto& shader : shaders) {
+            auto type = static_cast<uint32_t>(shader->type());
+            seed = hash(seed, &type, sizeof(type));
+            seed = hash(seed, shader->source());
+        }
+        return hash(seed, link_state);
+    }
+
+    bool program_cache::load(uint64_t key, GLuint program) {
+        if (!enabled_) {
+            return false;
+        }
+        auto file = std::ifstream{file_name(key), std::ios::binary};
+        if (!file) {
+            return false;
+        }
+        auto header = program_binary_header{};
+        file.read(reinterpret_cast<char*>(&header), sizeof(header));
+        if (!file || header.magic != program_cache_magic || header.key != key || header.length == 0) {
+            return false;
+        }
+        auto binary = std::vector<char>(header.length);
+        file.read(binary.data(), binary.size());
+        if (!file) {
+            return false;
+        }
+
+        gl.program_binary(program, header.format, binary.data(), header.length);
+        auto status = 0;
+        gl.get_programiv(program, GL_LINK_STATUS, &status);
+        if (!status) {
+            log(LOG_WARNING, "the driver rejected cached program " + file_name(key) + ", compiling it again");
+            return false;
+        }
+        return true;
+    }
+
+    void program_cache::store(uint64_t key, GLuint program) {
+        if (!enabled_ || store_failed_) {
+            return;
+        }
+        auto length = 0;
+        gl.get_programiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0) {
+            return;
+        }
+        auto binary = std::vector<char>(length);
+        auto format = GLenum{0};
+        auto written = GLsizei{0};
+        gl.get_program_binary(program, length, &written, &format, binary.data());
+        if (written <= 0) {
+            return;
+        }
+
+        auto header = program_binary_header{program_cache_magic, key, format, static_cast<uint32_t>(written)};
+        auto file = std::ofstream{file_name(key), std::ios::binary | std::ios::trunc};
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(binary.data(), written);
+        if (!file) {
+            // most likely the directory is missing, which does not change while the game runs
+            log(LOG_WARNING, "could not write program binaries to " + directory_);
+            store_failed_ = true;
+        }
+    }
+
+    void program_cache::record_link(bool hit) noexcept {
+        if (hit) {
+            ++statistics_.hits;
+        } else {
+            ++statistics_.misses;
+        }
+    }
+
+    void program_cache::finish_links() {
+        while (!pending_.empty()) {
+            auto finished = false;
+            for (auto i = size_t{0}; i < pending_.size();) {
+                auto program = pending_[i];
+                if (!program->link_completed()) {
+                    ++i;
+                    continue;
+                }
+                pending_.erase(pending_.begin() + i);
+                program->finish_link();
+                finished = true;
+            }
+            if (!finished) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void program_cache::add_pending(program* program) {
+        pending_.emplace_back(program);
+    }
+
+    void program_cache::remove_pending(program* program) noexcept {
+        pending_.erase(std::remove(pending_.begin(), pending_.end(), program), pending_.end());
+    }
+
+    std::string program_cache::file_name(uint64_t key) const {
+        char name[17];
+        std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(key));
+        return directory_ + "/" + name + ".bin";
+    }
+}
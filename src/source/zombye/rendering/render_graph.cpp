@@ -0,0 +1,320 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include <zombye/rendering/framebuffer.hpp>
+#include <zombye/rendering/gpu_timer.hpp>
+#include <zombye/rendering/render_graph.hpp>
+#include <zombye/rendering/texture.hpp>
+#include <zombye/utils/profiler.hpp>
+
+namespace zombye {
+    namespace {
+        bool is_depth_format(GLenum internal_format) noexcept {
+            return internal_format == GL_DEPTH_COMPONENT16 || internal_format == GL_DEPTH_COMPONENT24
+                || internal_format == GL_DEPTH_COMPONENT32 || internal_format == GL_DEPTH_COMPONENT32F;
+        }
+
+        uint64_t texel_size(GLenum internal_format) noexcept {
+            switch (internal_format) {
+                case GL_R8:
+                    return 1;
+                case GL_RG8:
+                case GL_RG8_SNORM:
+                case GL_R16F:
+                case GL_DEPTH_COMPONENT16:
+                    return 2;
+                case GL_RGB8:
+                case GL_RGB8_SNORM:
+                case GL_DEPTH_COMPONENT24:
+                    return 3;
+                case GL_RG16:
+                case GL_RG16_SNORM:
+                case GL_RG16F:
+                case GL_RGB10_A2:
+                case GL_R11F_G11F_B10F:
+                    return 4;
+                case GL_RGB16F:
+                    return 6;
+                case GL_RGBA16F:
+                case GL_RG32F:
+                    return 8;
+                case GL_RGB32F:
+                    return 12;
+                case GL_RGBA32F:
+                    return 16;
+                default:
+                    return 4;
+            }
+        }
+    }
+
+    render_graph::render_graph() noexcept
+    : frame_{0}, compiled_{false} { }
+
+    render_graph::~render_graph() noexcept = default;
+
+    void render_graph::reset() {
+        resources_.clear();
+        passes_.clear();
+        compiled_ = false;
+    }
+
+    render_resource render_graph::create(const std::string& name, const render_target_desc& desc) {
+        resources_.emplace_back(resource{name, desc, nullptr, 0, 0, 0, false});
+        return resources_.size() - 1;
+    }
+
+    render_resource render_graph::import(const std::string& name, std::shared_ptr<texture> texture) {
+        auto desc = render_target_desc{GL_NONE, static_cast<GLsizei>(texture->width()),
+            static_cast<GLsizei>(texture->height()), static_cast<GLsizei>(texture->layers())};
+        resources_.emplace_back(resource{name, desc, std::move(texture), 0, 0, 0, false});
+        return resources_.size() - 1;
+    }
+
+    void render_graph::add_pass(const std::string& name, std::vector<render_resource> reads,
+    std::vector<render_resource> writes, bool output, std::function<void()> execute) {
+        passes_.emplace_back(pass{name, std::move(reads), std::move(writes), output, std::move(execute), false});
+    }
+
+    void render_graph::compile() {
+        ++frame_;
+
+        // passes are kept from the last one backwards, when their output is used or a kept pass reads what
+        // they write
+        auto read = std::vector<bool>(resources_.size(), false);
+        for (auto p = passes_.size(); p-- > 0;) {
+            auto& pass = passes_[p];
+            pass.culled = !pass.output && std::none_of(pass.writes.begin(), pass.writes.end(),
+                [&read](render_resource resource) {
+                    return read[resource];
+                });
+            if (!pass.culled) {
+                for (auto resource : pass.reads) {
+                    read[resource] = true;
+                }
+            }
+        }
+
+        for (auto p = size_t{0}; p < passes_.size(); ++p) {
+            auto& pass = passes_[p];
+            if (pass.culled) {
+                continue;
+            }
+            auto use = [this, p](render_resource resource) {
+                auto& r = resources_[resource];
+                if (!r.live) {
+                    r.live = true;
+                    r.first_pass = p;
+                }
+                r.last_pass = p;
+            };
+            std::for_each(pass.reads.begin(), pass.reads.end(), use);
+            std::for_each(pass.writes.begin(), pass.writes.end(), use);
+        }
+
+        // transient resources take the first free texture of their description in the order they are first used
+        auto order = std::vector<render_resource>{};
+        for (auto i = render_resource{0}; i < resources_.size(); ++i) {
+            if (resources_[i].live && !resources_[i].imported) {
+                order.emplace_back(i);
+            }
+        }
+        std::stable_sort(order.begin(), order.end(), [this](render_resource a, render_resource b) {
+            return resources_[a].first_pass < resources_[b].first_pass;
+        });
+        for (auto& target : targets_) {
+            target.used = false;
+        }
+        for (auto i : order) {
+            auto& r = resources_[i];
+            auto found = std::find_if(targets_.begin(), targets_.end(), [&r](const physical_target& target) {
+                return target.desc == r.desc && (!target.used || target.busy_until < r.first_pass);
+            });
+            if (found == targets_.end()) {
+                auto format = is_depth_format(r.desc.internal_format) ? GL_DEPTH_COMPONENT : GL_RGBA;
+                auto texture = std::shared_ptr<zombye::texture>{};
+                if (r.desc.layers > 0) {
+                    texture = std::make_shared<zombye::texture>(GL_TEXTURE_2D_ARRAY, r.desc.internal_format,
+                        r.desc.width, r.desc.height, r.desc.layers, format, GL_FLOAT, nullptr);
+                } else {
+                    texture = std::make_shared<zombye::texture>(GL_TEXTURE_2D, r.desc.internal_format, r.desc.width,
+                        r.desc.height, format, GL_FLOAT);
+                }
+                targets_.emplace_back(physical_target{r.desc, std::move(texture), 0, false, 0});
+                found = targets_.end() - 1;
+            }
+            found->used = true;
+            found->busy_until = r.last_pass;
+            found->last_used = frame_;
+            r.target = found - targets_.begin();
+        }
+
+        // framebuffers keep their textures alive, so they are dropped together with them
+        auto expired = [this](const physical_target& target) {
+            return frame_ - target.last_used > max_unused_frames;
+        };
+        for (auto& target : targets_) {
+            if (!expired(target)) {
+                continue;
+            }
+            for (auto framebuffer = framebuffers_.begin(); framebuffer != framebuffers_.end();) {
+                auto& key = framebuffer->first;
+                if (std::any_of(key.begin(), key.end(), [&target](const auto& attachment) {
+                    return attachment.second == target.texture.get();
+                })) {
+                    framebuffer = framebuffers_.erase(framebuffer);
+                } else {
+                    ++framebuffer;
+                }
+            }
+        }
+        if (std::any_of(targets_.begin(), targets_.end(), expired)) {
+            // the indices of the resources of this frame point into the targets
+            auto remap = std::vector<size_t>(targets_.size());
+            auto kept = std::vector<physical_target>{};
+            for (auto i = size_t{0}; i < targets_.size(); ++i) {
+                remap[i] = kept.size();
+                if (!expired(targets_[i])) {
+                    kept.emplace_back(std::move(targets_[i]));
+                }
+            }
+            for (auto i : order) {
+                resources_[i].target = remap[resources_[i].target];
+            }
+            targets_ = std::move(kept);
+        }
+        compiled_ = true;
+    }
+
+    void render_graph::execute(profiler* profiler) {
+        if (!compiled_) {
+            throw std::logic_error("render graph executed without compiling it");
+        }
+        if (!profiler) {
+            for (auto& pass : passes_) {
+                if (!pass.culled) {
+                    pass.execute();
+                }
+            }
+            return;
+        }
+
+        for (auto& timer : timers_) {
+            if (timer.second->poll()) {
+                profiler->record("gpu/" + timer.first, timer.second->milliseconds());
+            }
+        }
+        for (auto& pass : passes_) {
+            if (pass.culled) {
+                continue;
+            }
+            auto& timer = timers_[pass.name];
+            if (!timer) {
+                timer = std::make_unique<gpu_timer>();
+            }
+            cpu_timer cpu{*profiler, "cpu/" + pass.name};
+            timer->begin();
+            pass.execute();
+            timer->end();
+        }
+    }
+
+    texture& render_graph::target(render_resource resource) const {
+        auto& r = resources_.at(resource);
+        if (r.imported) {
+            return *r.imported;
+        }
+        return *targets_.at(r.target).texture;
+    }
+
+    zombye::framebuffer& render_graph::framebuffer_of(
+    std::initializer_list<std::pair<GLenum, render_resource>> attachments) {
+        auto key = std::vector<std::pair<GLenum, const texture*>>{};
+        for (auto& attachment : attachments) {
+            key.emplace_back(attachment.first, &target(attachment.second));
+        }
+        auto& framebuffer = framebuffers_[key];
+        if (framebuffer) {
+            return *framebuffer;
+        }
+
+        framebuffer = std::make_unique<zombye::framebuffer>();
+        auto draw_buffers = std::vector<GLenum>{};
+        for (auto& attachment : attachments) {
+            auto& r = resources_[attachment.second];
+            framebuffer->attach_texture(attachment.first, r.imported ? r.imported : targets_[r.target].texture);
+            if (attachment.first != GL_DEPTH_ATTACHMENT && attachment.first != GL_STENCIL_ATTACHMENT
+            && attachment.first != GL_DEPTH_STENCIL_ATTACHMENT) {
+                draw_buffers.emplace_back(attachment.first);
+            }
+        }
+        if (draw_buffers.empty()) {
+            draw_buffers.emplace_back(GL_NONE);
+        }
+        framebuffer->bind();
+        gl.draw_buffers(draw_buffers.size(), draw_buffers.data());
+        framebuffer->bind_default();
+        return *framebuffer;
+    }
+
+    std::string render_graph::describe() const {
+        auto text = std::string{"render graph:\n"};
+        for (auto p = size_t{0}; p < passes_.size(); ++p) {
+            auto& pass = passes_[p];
+            text += "  pass " + std::to_string(p) + " " + pass.name + (pass.culled ? " (culled)" : "")
+                + (pass.output ? " (output)" : "") + "\n";
+            auto list = [this, &text](const char* label, const std::vector<render_resource>& resources) {
+                if (resources.empty()) {
+                    return;
+                }
+                text += std::string{"    "} + label;
+                for (auto resource : resources) {
+                    text += " " + resources_[resource].name;
+                }
+                text += "\n";
+            };
+            list("reads", pass.reads);
+            list("writes", pass.writes);
+        }
+        for (auto& r : resources_) {
+            text += "  " + r.name + " " + std::to_string(r.desc.width) + "x" + std::to_string(r.desc.height);
+            if (r.desc.layers > 0) {
+                text += "x" + std::to_string(r.desc.layers);
+            }
+            if (r.imported) {
+                text += " imported";
+            } else if (!r.live) {
+                text += " unused";
+            } else {
+                text += " passes " + std::to_string(r.first_pass) + "-" + std::to_string(r.last_pass) + " texture "
+                    + std::to_string(r.target);
+            }
+            text += "\n";
+        }
+        auto bytes = transient_bytes();
+        text += "  " + std::to_string(targets_.size()) + " textures, " + std::to_string(bytes.second) + " of "
+            + std::to_string(bytes.first) + " transient bytes allocated";
+        return text;
+    }
+
+    std::pair<uint64_t, uint64_t> render_graph::transient_bytes() const {
+        auto separate = uint64_t{0};
+        auto shared = uint64_t{0};
+        auto counted = std::vector<bool>(targets_.size(), false);
+        for (auto& r : resources_) {
+            if (r.imported || !r.live) {
+                continue;
+            }
+            separate += size(r.desc);
+            if (!counted[r.target]) {
+                counted[r.target] = true;
+                shared += size(r.desc);
+            }
+        }
+        return {separate, shared};
+    }
+
+    uint64_t render_graph::size(const render_target_desc& desc) noexcept {
+        return texel_size(desc.internal_format) * desc.width * desc.height * std::max(desc.layers, GLsizei{1});
+    }
+}
@@ -1,55 +1,120 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <cstddef>
+#include <limits>
 #include <string>
+#include <tuple>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtx/string_cast.hpp>
 
+#include <mesh_converter/mesh_converter.hpp>
+
 #include <zombye/config/config_system.hpp>
 #include <zombye/core/game.hpp>
 #include <zombye/ecs/entity.hpp>
+#include <zombye/physics/character_physics_component.hpp>
+#include <zombye/physics/physics_component.hpp>
 #include <zombye/rendering/animation_component.hpp>
 #include <zombye/rendering/camera_component.hpp>
 #include <zombye/rendering/directional_light_component.hpp>
 #include <zombye/rendering/framebuffer.hpp>
+#include <zombye/rendering/gl_backend.hpp>
 #include <zombye/rendering/light_component.hpp>
 #include <zombye/rendering/program.hpp>
+#include <zombye/rendering/program_cache.hpp>
 #include <zombye/rendering/screen_quad.hpp>
 #include <zombye/rendering/skinned_mesh.hpp>
 #include <zombye/rendering/staticmesh_component.hpp>
 #include <zombye/rendering/mesh.hpp>
 #include <zombye/rendering/rendering_system.hpp>
 #include <zombye/rendering/shadow_component.hpp>
+#include <zombye/rendering/static_batch_component.hpp>
+#include <zombye/rendering/static_batcher.hpp>
 #include <zombye/rendering/no_occluder_component.hpp>
 #include <zombye/scripting/scripting_system.hpp>
 #include <zombye/utils/component_helper.hpp>
 #include <zombye/utils/logger.hpp>
+#include <zombye/utils/profiler.hpp>
+#include <zombye/utils/thread_pool.hpp>
 
 namespace zombye {
+	namespace {
+		// element sizes of the position, texcoord, normal and tangent streams written by the skinning pass
+		const size_t skinned_stream_sizes[4] = {
+			sizeof(glm::vec3),
+			sizeof(glm::vec2),
+			sizeof(glm::vec2),
+			sizeof(glm::vec2)
+		};
+
+		// a static mesh component or a static batch chunk, which has no owner
+		struct static_draw {
+			const zombye::mesh* mesh;
+			glm::mat4 model;
+			lod_state* lod;
+			entity* owner;
+		};
+	}
+
+	constexpr int rendering_system::max_shadow_cascades;
+
 	rendering_system::rendering_system(game& game, SDL_Window* window)
-	: game_{game}, window_{window}, mesh_manager_{game_, *this}, shader_manager_{game_}, skinned_mesh_manager_{game_},
-	skeleton_manager_{game_}, texture_manager_{game_}, active_camera_{0}, shadow_resolution_{3072} {
-		context_ = SDL_GL_CreateContext(window_);
-		auto error = std::string{SDL_GetError()};
-		if (error != "") {
-			log(LOG_FATAL, "could not create OpenGL context with version 3.1: " + error);
-		}
-		SDL_ClearError();
+	: game_{game}, window_{window}, context_{nullptr}, mesh_manager_{game_, *this}, shader_manager_{game_}, skinned_mesh_manager_{game_},
+	skeleton_manager_{game_}, texture_manager_{game_},
+	texture_array_manager_{game_, texture_manager_}, active_camera_{0}, shadow_resolution_{3072},
+	shadow_cascades_{1}, shadow_distance_{60.f}, shadow_casting_{false}, static_shadows_dirty_{true},
+	multi_draw_indirect_{false}, indirect_offset_{0}, frame_count_{0} {
+		if (active_gl_backend() == gl_backend_type::native) {
+			context_ = SDL_GL_CreateContext(window_);
+			auto error = std::string{SDL_GetError()};
+			if (error != "") {
+				log(LOG_FATAL, "could not create OpenGL context with version 3.1: " + error);
+			}
+			SDL_ClearError();
 
-		SDL_GL_SetSwapInterval(1);
+			SDL_GL_SetSwapInterval(1);
 
-		glewExperimental = GL_TRUE;
-		if (glewInit() != GLEW_OK) {
-			log(LOG_FATAL, "could not initialize glew");
+			glewExperimental = GL_TRUE;
+			if (glewInit() != GLEW_OK) {
+				log(LOG_FATAL, "could not initialize glew");
+			}
+		} else {
+			log("using null gl backend, no draw call will reach the gpu");
 		}
 
-		auto version = std::string{reinterpret_cast<const char*>(glGetString(GL_VERSION))};
+		auto version = std::string{reinterpret_cast<const char*>(gl.get_string(GL_VERSION))};
 		log("OpenGL version " + version);
+		query_gl_capabilities();
+		if (gl_caps().buffer_storage) {
+			log("streaming per frame data through persistently mapped buffers");
+		} else {
+			log("streaming per frame data through orphaned buffers");
+		}
+
+		worker_pool_ = std::make_unique<thread_pool>(game_.config()->get("main", "render_threads").asUInt());
+		log("recording render commands on " + std::to_string(worker_pool_->worker_count()) + " worker threads");
+
+		// programs linked on an earlier start are loaded from their binaries. the others are only issued to the
+		// driver while the constructor runs and checked together at its end. every shader source the
+		// constructor may need is read up front on the worker threads.
+		auto program_start = std::chrono::steady_clock::now();
+		program_cache_ = std::make_unique<program_cache>("cache");
+		shader_manager_.preload({
+			"shader/staticmesh.vs", "shader/staticmesh.fs", "shader/animation.fs", "shader/skinning.vs",
+			"shader/screen_quad.vs", "shader/screen_quad.fs", "shader/deferred.vs", "shader/deferred.fs",
+			"shader/depth.vs", "shader/shadow.fs", "shader/shadow_evsm.fs", "shader/gaussian_blur.fs",
+			"shader/gaussian_blur_wide.fs", "shader/skybox.vs", "shader/skybox.fs", "shader/light_cube.vs",
+			"shader/light_cube.fs", "shader/directional_light.vs", "shader/point_light.fs",
+			"shader/directional_light.fs"
+		}, *worker_pool_);
 
 		width_ = static_cast<float>(game.width());
 		height_ = static_cast<float>(game.height());
 
-		glEnable(GL_DEPTH_TEST);
+		gl.enable(GL_DEPTH_TEST);
 		clear_color(0.f, 0.f, 0.f, 0.f);
 
 		auto vertex_shader = shader_manager_.load("shader/staticmesh.vs", GL_VERTEX_SHADER);
@@ -64,48 +129,109 @@ namespace zombye {
 		staticmesh_layout_.emplace_back("_normal", 3, GL_FLOAT, GL_FALSE, sizeof(vertex), 5 * sizeof(float));
 		staticmesh_layout_.emplace_back("_tangent", 3, GL_FLOAT, GL_FALSE, sizeof(vertex), 8 * sizeof(float));
 
-		staticmesh_layout_.setup_program(*staticmesh_program_, "albedo_color");
+		// meshes fetch their positions from one stream and the packed attributes from a second one. normals
+		// and tangents are octahedral encoded and decoded by the vertex shader.
+		for (auto format = uint32_t{0}; format < 4; ++format) {
+			auto& layout = packed_mesh_layouts_[format];
+			auto stride = sizeof(devtools::packed_attributes);
+			if (format & devtools::half_positions) {
+				layout.emplace_back("_position", 3, GL_HALF_FLOAT, GL_FALSE, 4 * sizeof(uint16_t), 0, 0);
+			} else {
+				layout.emplace_back("_position", 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), 0, 0);
+			}
+			if (format & devtools::unorm_texcoords) {
+				layout.emplace_back("_texcoord", 2, GL_UNSIGNED_SHORT, GL_TRUE, stride,
+					offsetof(devtools::packed_attributes, texcoord), 1);
+			} else {
+				layout.emplace_back("_texcoord", 2, GL_HALF_FLOAT, GL_FALSE, stride,
+					offsetof(devtools::packed_attributes, texcoord), 1);
+			}
+			layout.emplace_back("_normal", 2, GL_SHORT, GL_TRUE, stride, offsetof(devtools::packed_attributes, normal), 1);
+			layout.emplace_back("_tangent", 2, GL_SHORT, GL_TRUE, stride, offsetof(devtools::packed_attributes, tangent), 1);
+			layout.emplace_back("_draw_id", 1, GL_FLOAT, GL_FALSE, sizeof(float), 0, 2, 1);
+		}
+
+		depth_layout_.emplace_back("_position", 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), 0);
+		half_depth_layout_.emplace_back("_position", 3, GL_HALF_FLOAT, GL_FALSE, 4 * sizeof(uint16_t), 0);
+		mesh_depth_layouts_[0].emplace_back("_position", 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), 0, 0);
+		mesh_depth_layouts_[1].emplace_back("_position", 3, GL_HALF_FLOAT, GL_FALSE, 4 * sizeof(uint16_t), 0, 0);
+		for (auto& layout : mesh_depth_layouts_) {
+			layout.emplace_back("_draw_id", 1, GL_FLOAT, GL_FALSE, sizeof(float), 0, 1, 1);
+		}
+
+		// static meshes share the buffers of the geometry arena and fetch their transforms from the draw data
+		// buffer and their texture layers from the material table. with multi draw indirect every page and set
+		// of texture arrays is drawn with a single call, otherwise every draw passes the index of its draw
+		// record as a uniform.
+		geometry_arena_ = std::make_unique<zombye::geometry_arena>(*this);
+		draw_data_buffer_ = std::make_unique<texture_stream_buffer>(1024 * sizeof(draw_data));
+		draw_data_texture_ = std::make_unique<texture>(GL_RGBA32F, *draw_data_buffer_);
+		draw_record_buffer_ = std::make_unique<texture_stream_buffer>(1024 * sizeof(glm::ivec2));
+		draw_record_texture_ = std::make_unique<texture>(GL_RG32I, *draw_record_buffer_);
+		material_table_ = std::make_unique<zombye::material_table>();
+		multi_draw_indirect_ = gl_caps().multi_draw_indirect;
+		if (multi_draw_indirect_) {
+			indirect_buffer_ = std::make_unique<indirect_stream_buffer>(1024 * sizeof(draw_elements_indirect_command));
+			log("submitting static meshes with multi draw indirect");
+		} else {
+			log("submitting static meshes with one draw call per submesh");
+		}
+
+		skinned_stream_layout_.emplace_back("_position", 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), 0, 0);
+		skinned_stream_layout_.emplace_back("_texcoord", 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), 0, 1);
+		skinned_stream_layout_.emplace_back("_normal", 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), 0, 2);
+		skinned_stream_layout_.emplace_back("_tangent", 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), 0, 3);
+
+		packed_mesh_layouts_[0].setup_program(*staticmesh_program_, "albedo_color");
 		staticmesh_program_->bind_frag_data_location("normal_color", 1);
 		staticmesh_program_->bind_frag_data_location("specular_color", 2);
-		staticmesh_program_->link();
+		staticmesh_program_->link(program_cache_.get());
 
-		vertex_shader = shader_manager_.load("shader/animation.vs", GL_VERTEX_SHADER);
+		vertex_shader = shader_manager_.load("shader/staticmesh.vs", GL_VERTEX_SHADER);
 		fragment_shader = shader_manager_.load("shader/animation.fs", GL_FRAGMENT_SHADER);
 
 		animation_program_ = std::make_unique<program>();
 		animation_program_->attach_shader(vertex_shader);
 		animation_program_->attach_shader(fragment_shader);
+		packed_mesh_layouts_[0].setup_program(*animation_program_, "albedo_color");
+		animation_program_->bind_frag_data_location("normal_color", 1);
+		animation_program_->bind_frag_data_location("specular_color", 2);
+		animation_program_->link(program_cache_.get());
 
 		skinnedmesh_layout_.emplace_back("_position", 3, GL_FLOAT, GL_FALSE, sizeof(skinned_vertex), 0);
 		skinnedmesh_layout_.emplace_back("_texcoord", 2, GL_FLOAT, GL_FALSE, sizeof(skinned_vertex), 3 * sizeof(float));
 		skinnedmesh_layout_.emplace_back("_normal", 3, GL_FLOAT, GL_FALSE, sizeof(skinned_vertex), 5 * sizeof(float));
-		skinnedmesh_layout_.emplace_back("_tangent", 3, GL_FLOAT, GL_FALSE, sizeof(vertex), 8 * sizeof(float));
+		skinnedmesh_layout_.emplace_back("_tangent", 3, GL_FLOAT, GL_FALSE, sizeof(skinned_vertex), 8 * sizeof(float));
 		skinnedmesh_layout_.emplace_back("_index", 4, GL_INT, GL_FALSE, sizeof(skinned_vertex), 11 * sizeof(float));
 		skinnedmesh_layout_.emplace_back("_weight", 4, GL_FLOAT, GL_FALSE, sizeof(skinned_vertex), 15 * sizeof(float));
 
-		skinnedmesh_layout_.setup_program(*animation_program_, "albedo_color");
-		animation_program_->bind_frag_data_location("normal_color", 1);
-		animation_program_->bind_frag_data_location("specular_color", 2);
-		animation_program_->link();
+		// the skinning pass writes every output into its own stream, so the result can be drawn with the static
+		// mesh programs and the depth passes only fetch positions
+		skinning_program_ = std::make_unique<program>();
+		vertex_shader = shader_manager_.load("shader/skinning.vs", GL_VERTEX_SHADER);
+		if (!vertex_shader) {
+			throw std::runtime_error{"could not load skinning.vs"};
+		}
+		skinning_program_->attach_shader(vertex_shader);
+		skinnedmesh_layout_.setup_program(*skinning_program_, "frag_color");
+		skinning_program_->transform_feedback_varyings({"skinned_position", "skinned_texcoord", "skinned_normal",
+			"skinned_tangent"}, GL_SEPARATE_ATTRIBS);
+		skinning_program_->link(program_cache_.get());
+
+		skinned_vertex_capacity_ = 1;
+		skinned_vertex_count_ = 0;
+		for (auto i = 0; i < 4; ++i) {
+			skinned_streams_[i] = std::make_unique<vertex_buffer>(skinned_vertex_capacity_ * skinned_stream_sizes[i], GL_DYNAMIC_COPY);
+		}
+		pose_buffer_ = std::make_unique<texture_stream_buffer>(64 * 64 * sizeof(glm::mat4));
+		pose_texture_ = std::make_unique<texture>(GL_RGBA32F, *pose_buffer_);
 
 		ortho_projection_ = glm::ortho(0.f, width_, 0.f, height_);
 
-		g_buffer_ = std::make_unique<framebuffer>();
-		g_buffer_->attach(GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, GL_DEPTH_COMPONENT32F, width_, height_, GL_DEPTH_COMPONENT, GL_FLOAT);
-		g_buffer_->attach(GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, GL_RGB8, width_, height_, GL_RGBA, GL_FLOAT);
-		g_buffer_->attach(GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, GL_RGB8_SNORM, width_, height_, GL_RGBA, GL_FLOAT);
-		g_buffer_->attach(GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, GL_RGB32F, width_, height_, GL_RGBA, GL_FLOAT);
-
-		g_buffer_->bind();
-		glClearColor(0.f, 0.f, 0.f, 0.f);
-		GLenum buf[4] = {
-			GL_COLOR_ATTACHMENT0,
-			GL_COLOR_ATTACHMENT1,
-			GL_COLOR_ATTACHMENT2,
-			GL_NONE
-		};
-		glDrawBuffers(4, buf);
-		g_buffer_->bind_default();
+		// the g-buffer and the intermediate shadow targets are transient targets of the render graph, which
+		// allocates them for the passes of a frame that are not culled
+		render_graph_ = std::make_unique<render_graph>();
+		gl.clear_color(0.f, 0.f, 0.f, 0.f);
 
 		screen_quad_program_ = std::make_unique<program>();
 		vertex_shader = shader_manager_.load("shader/screen_quad.vs", GL_VERTEX_SHADER);
@@ -119,7 +245,7 @@ namespace zombye {
 		}
 		screen_quad_program_->attach_shader(fragment_shader);
 		staticmesh_layout_.setup_program(*screen_quad_program_, "frag_color");
-		screen_quad_program_->link();
+		screen_quad_program_->link(program_cache_.get());
 
 		for (auto i = 0; i < 4; ++i) {
 			debug_screen_quads_.emplace_back(std::make_unique<screen_quad>(
@@ -141,7 +267,7 @@ namespace zombye {
 		}
 		composition_program_->attach_shader(fragment_shader);
 		staticmesh_layout_.setup_program(*composition_program_, "frag_color");
-		composition_program_->link();
+		composition_program_->link(program_cache_.get());
 
 		screen_quad_ = std::make_unique<screen_quad>(staticmesh_layout_, glm::vec2(0.f, height_), glm::vec2(width_, 0.f));
 
@@ -150,67 +276,147 @@ namespace zombye {
 		auto quality = config->get("quality", quality_level);
 
 		shadow_resolution_ = quality["shadow_resolution"].asInt();
-		shadow_map_ = std::make_unique<framebuffer>();
-		shadow_map_->attach(GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, GL_DEPTH_COMPONENT32F, shadow_resolution_, shadow_resolution_, GL_DEPTH_COMPONENT, GL_FLOAT);
-		shadow_map_->attach(GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, GL_RG32F, shadow_resolution_, shadow_resolution_, GL_RGBA, GL_FLOAT);
-		glGenerateMipmap(GL_TEXTURE_2D);
-		shadow_map_->attachment(GL_COLOR_ATTACHMENT0).apply_settings();
-		shadow_map_->bind();
+		shadow_cascades_ = glm::clamp(quality["shadow_cascades"].asInt(), 1, max_shadow_cascades);
+		shadow_distance_ = quality["shadow_distance"].asFloat();
+		if (shadow_distance_ <= 0.f) {
+			shadow_distance_ = 60.f;
+		}
+		shadow_projections_.resize(shadow_cascades_);
+		cascade_splits_.resize(shadow_cascades_);
+		cascade_bounds_.resize(shadow_cascades_);
+
+		auto filter = quality["shadow_filter"].asString();
+		if (filter == "none") {
+			shadow_filter_ = shadow_filter::none;
+		} else if (filter == "vsm16") {
+			shadow_filter_ = shadow_filter::vsm16;
+		} else if (filter == "evsm") {
+			shadow_filter_ = shadow_filter::evsm;
+		} else {
+			if (filter != "" && filter != "vsm") {
+				log(LOG_WARNING, "unknown shadow filter " + filter + ", falling back to vsm");
+			}
+			shadow_filter_ = shadow_filter::vsm;
+		}
+
+		// the compact layout packs normals octahedral into rg16, keeps only the two used material channels and
+		// stores depth in 24 bits
+		auto normals = quality.get("g_buffer_normals", "rgb8").asString();
+		octahedral_normals_ = normals == "octahedral";
+		if (!octahedral_normals_ && normals != "rgb8") {
+			log(LOG_WARNING, "unknown g-buffer normal format " + normals + ", falling back to rgb8");
+		}
+		auto material = quality.get("g_buffer_material", "rgb32f").asString();
+		if (material != "rg8" && material != "rgb32f") {
+			log(LOG_WARNING, "unknown g-buffer material format " + material + ", falling back to rgb32f");
+		}
+		auto depth = quality.get("g_buffer_depth", "32f").asString();
+		if (depth != "24" && depth != "32f") {
+			log(LOG_WARNING, "unknown g-buffer depth format " + depth + ", falling back to 32f");
+		}
+		g_buffer_formats_[0] = GL_RGB8;
+		g_buffer_formats_[1] = octahedral_normals_ ? GL_RG16 : GL_RGB8_SNORM;
+		g_buffer_formats_[2] = material == "rg8" ? GL_RG8 : GL_RGB32F;
+		g_buffer_formats_[3] = depth == "24" ? GL_DEPTH_COMPONENT24 : GL_DEPTH_COMPONENT32F;
+
+		// dynamic resolution needs gpu timestamps to measure the frame
+		dynamic_resolution_ = quality.get("dynamic_resolution", false).asBool();
+		min_resolution_scale_ = glm::clamp(quality.get("min_resolution_scale", 0.5f).asFloat(), 0.5f, 1.f);
+		target_gpu_milliseconds_ = std::max(quality.get("target_gpu_frame_ms", 16.f).asFloat(), 1.f);
+		resolution_scale_ = 1.f;
+		viewport_width_ = static_cast<GLsizei>(width_);
+		viewport_height_ = static_cast<GLsizei>(height_);
+		frame_timer_ = std::make_unique<gpu_timer>();
+		if (dynamic_resolution_ && !gl_caps().timer_query) {
+			log(LOG_WARNING, "dynamic resolution needs timer queries, rendering at full resolution");
+			dynamic_resolution_ = false;
+		}
+
+		// textures keep their levels of at most texture_streaming_size texels per side resident and stream the
+		// finer ones in while they are drawn
+		if (quality.get("texture_streaming", true).asBool()) {
+			auto budget = std::max(quality.get("texture_budget_mb", 512).asInt(), 1);
+			auto upload = std::max(quality.get("texture_upload_kb_per_frame", 2048).asInt(), 1);
+			auto size = std::max(quality.get("texture_streaming_size", 64).asInt(), 1);
+			texture_manager_.enable_streaming(uint64_t{1024} * 1024 * budget, uint64_t{1024} * upload, size);
+			log("streaming textures with a budget of " + std::to_string(budget) + " MB");
+		}
+		texture_array_manager_.layers_per_array(std::max(quality.get("texture_array_layers", 16).asInt(), 1));
+
+		// 16 bit moments are blurred at half resolution with a wider kernel, the 32 bit ones at full resolution
+		auto moment_format = GL_RG32F;
+		auto blur_shader = std::string{"shader/gaussian_blur.fs"};
+		auto moment_shader = std::string{"shader/shadow.fs"};
+		shadow_blur_resolution_ = shadow_resolution_;
+		if (shadow_filter_ != shadow_filter::vsm) {
+			moment_format = shadow_filter_ == shadow_filter::evsm ? GL_RGBA16F : GL_RG16F;
+			blur_shader = "shader/gaussian_blur_wide.fs";
+			shadow_blur_resolution_ = std::max(shadow_resolution_ / 2, 1);
+		}
+		if (shadow_filter_ == shadow_filter::evsm) {
+			moment_shader = "shader/shadow_evsm.fs";
+		}
+
+		// the moments of the last frame are kept for layers that are not updated, so they are not transient
+		shadow_moment_format_ = moment_format;
+		shadow_moments_ = std::make_shared<texture>(GL_TEXTURE_2D_ARRAY, moment_format, shadow_resolution_, shadow_resolution_, shadow_cascades_, GL_RGBA, GL_FLOAT, nullptr);
 		GLenum shadow_buffers[2] = { GL_COLOR_ATTACHMENT0, GL_NONE };
-		glDrawBuffers(2, shadow_buffers);
-		shadow_map_->bind_default();
+
+		// the static layers cover a guard band of a quarter cascade on every side, so the cascade can follow
+		// the camera inside of them without rendering the static casters again
+		static_shadow_guard_ = shadow_resolution_ / 4;
+		static_shadow_resolution_ = shadow_resolution_ + 2 * static_shadow_guard_;
+		static_shadow_map_ = std::make_unique<framebuffer>();
+		static_shadow_map_->attach_array(GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D_ARRAY, GL_DEPTH_COMPONENT32F, static_shadow_resolution_, static_shadow_resolution_, shadow_cascades_, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+		static_shadow_map_->attach_array(GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D_ARRAY, moment_format, static_shadow_resolution_, static_shadow_resolution_, shadow_cascades_, GL_RGBA, GL_FLOAT, nullptr);
+		static_shadow_map_->bind();
+		gl.draw_buffers(2, shadow_buffers);
+		static_shadow_map_->bind_default();
+		static_shadow_projections_.resize(shadow_cascades_);
+		static_shadow_bounds_.assign(shadow_cascades_, glm::vec4{0.f});
+		static_shadow_regions_.resize(shadow_cascades_);
+		moved_shadow_layers_.assign(shadow_cascades_, false);
+		dynamic_shadow_layers_.assign(shadow_cascades_, true);
+		updated_shadow_layers_.assign(shadow_cascades_, false);
 
 		shadow_staticmesh_program_ = std::make_unique<program>();
-		vertex_shader = shader_manager_.load("shader/staticmesh.vs", GL_VERTEX_SHADER);
+		vertex_shader = shader_manager_.load("shader/depth.vs", GL_VERTEX_SHADER);
 		if (!vertex_shader) {
-			throw std::runtime_error{"could not load staticmesh.vs"};
+			throw std::runtime_error{"could not load depth.vs"};
 		}
 		shadow_staticmesh_program_->attach_shader(vertex_shader);
-		fragment_shader = shader_manager_.load("shader/shadow.fs", GL_FRAGMENT_SHADER);
+		fragment_shader = shader_manager_.load(moment_shader, GL_FRAGMENT_SHADER);
 		if (!fragment_shader) {
-			throw std::runtime_error{"could not load shadow.fs"};
+			throw std::runtime_error{"could not load " + moment_shader};
 		}
 		shadow_staticmesh_program_->attach_shader(fragment_shader);
-		staticmesh_layout_.setup_program(*shadow_staticmesh_program_, "frag_color");
-		shadow_staticmesh_program_->link();
-
-		shadow_animation_program_ = std::make_unique<program>();
-		vertex_shader = shader_manager_.load("shader/animation.vs", GL_VERTEX_SHADER);
-		if (!vertex_shader) {
-			throw std::runtime_error{"could not load animation.vs"};
-		}
-		shadow_animation_program_->attach_shader(vertex_shader);
-		fragment_shader = shader_manager_.load("shader/shadow.fs", GL_FRAGMENT_SHADER);
-		if (!fragment_shader) {
-			throw std::runtime_error{"could not load shadow.fs"};
-		}
-		shadow_animation_program_->attach_shader(fragment_shader);
-		skinnedmesh_layout_.setup_program(*shadow_animation_program_, "frag_color");
-		shadow_animation_program_->link();
-
-		shadow_map_blured_ = std::make_unique<framebuffer>();
-		shadow_map_blured_->attach(GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, GL_DEPTH_COMPONENT32F, shadow_resolution_, shadow_resolution_, GL_DEPTH_COMPONENT, GL_FLOAT);
-		shadow_map_blured_->attach(GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, GL_RG32F, shadow_resolution_, shadow_resolution_, GL_RGBA, GL_FLOAT);
-		glGenerateMipmap(GL_TEXTURE_2D);
-		shadow_map_->attachment(GL_COLOR_ATTACHMENT0).apply_settings();
-		shadow_map_blured_->bind();
-		glDrawBuffers(2, shadow_buffers);
-		shadow_map_blured_->bind_default();
-
-		shadow_blur_program_ = std::make_unique<program>();
-		vertex_shader = shader_manager_.load("shader/screen_quad.vs", GL_VERTEX_SHADER);
-		if (!vertex_shader) {
-			throw std::runtime_error("could not load screen_quad.vs");
-		}
-		shadow_blur_program_->attach_shader(vertex_shader);
-		fragment_shader = shader_manager_.load("shader/gaussian_blur.fs", GL_FRAGMENT_SHADER);
-		if (!fragment_shader) {
-			throw std::runtime_error("could not load gaussian_blur.fs");
+		mesh_depth_layouts_[0].setup_program(*shadow_staticmesh_program_, "frag_color");
+		shadow_staticmesh_program_->link(program_cache_.get());
+
+		if (shadow_filter_ == shadow_filter::none) {
+			shadow_moments_->bind(0);
+			gl.generate_mipmap(GL_TEXTURE_2D_ARRAY);
+			shadow_moments_->apply_settings();
+		} else {
+			shadow_filtered_ = std::make_shared<texture>(GL_TEXTURE_2D_ARRAY, moment_format, shadow_blur_resolution_, shadow_blur_resolution_, shadow_cascades_, GL_RGBA, GL_FLOAT, nullptr);
+			shadow_filtered_->bind(0);
+			gl.generate_mipmap(GL_TEXTURE_2D_ARRAY);
+			shadow_filtered_->apply_settings();
+
+			shadow_blur_program_ = std::make_unique<program>();
+			vertex_shader = shader_manager_.load("shader/screen_quad.vs", GL_VERTEX_SHADER);
+			if (!vertex_shader) {
+				throw std::runtime_error("could not load screen_quad.vs");
+			}
+			shadow_blur_program_->attach_shader(vertex_shader);
+			fragment_shader = shader_manager_.load(blur_shader, GL_FRAGMENT_SHADER);
+			if (!fragment_shader) {
+				throw std::runtime_error("could not load " + blur_shader);
+			}
+			shadow_blur_program_->attach_shader(fragment_shader);
+			staticmesh_layout_.setup_program(*shadow_blur_program_, "frag_color");
+			shadow_blur_program_->link(program_cache_.get());
 		}
-		shadow_blur_program_->attach_shader(fragment_shader);
-		staticmesh_layout_.setup_program(*shadow_blur_program_, "frag_color");
-		shadow_blur_program_->link();
-
 
 		skybox_program_ = std::make_unique<program>();
 		vertex_shader = shader_manager_.load("shader/skybox.vs", GL_VERTEX_SHADER);
@@ -226,7 +432,7 @@ namespace zombye {
 		staticmesh_layout_.setup_program(*skybox_program_, "albedo_color");
 		skybox_program_->bind_frag_data_location("normal_color", 1);
 		skybox_program_->bind_frag_data_location("specular_color", 2);
-		skybox_program_->link();
+		skybox_program_->link(program_cache_.get());
 
 		skybox_mesh_ = mesh_manager_.load("meshes/skybox.msh");
 		if (!skybox_mesh_) {
@@ -247,33 +453,17 @@ namespace zombye {
 		staticmesh_layout_.setup_program(*light_cube_program_, "albedo_color");
 		light_cube_program_->bind_frag_data_location("normal_color", 1);
 		light_cube_program_->bind_frag_data_location("specular_color", 2);
-		light_cube_program_->link();
+		light_cube_program_->link(program_cache_.get());
 
 		light_volume_layout_.emplace_back("_position", 3, GL_FLOAT, GL_FALSE, sizeof(vertex), offsetof(vertex, position));
 		light_volume_layout_.emplace_back("_texcoord", 2, GL_FLOAT, GL_FALSE, sizeof(vertex), offsetof(vertex, texcoord));
 		light_volume_layout_.emplace_back("_normal", 3, GL_FLOAT, GL_FALSE, sizeof(vertex), offsetof(vertex, normal));
 		light_volume_layout_.emplace_back("_tangent", 3, GL_FLOAT, GL_FALSE, sizeof(vertex), offsetof(vertex, tangent));
-		light_volume_layout_.emplace_back("position", 3, GL_FLOAT, GL_FALSE, sizeof(light_attributes), offsetof(light_attributes, position), 1, 1);
-		light_volume_layout_.emplace_back("color", 3, GL_FLOAT, GL_FALSE, sizeof(light_attributes), offsetof(light_attributes, color), 1, 1);
-		light_volume_layout_.emplace_back("radius", 1, GL_FLOAT, GL_FALSE, sizeof(light_attributes), offsetof(light_attributes, radius), 1, 1);
-		light_volume_layout_.emplace_back("exponent", 1, GL_FLOAT, GL_FALSE, sizeof(light_attributes), offsetof(light_attributes, exponent), 1, 1);
-
-		point_light_volume_ = mesh_manager_.load("meshes/point_light_volume.msh");
-		if (!point_light_volume_) {
-			throw std::runtime_error("could not load point_light_volume.msh");
-		}
-
-		point_light_instance_data_ = std::make_unique<vertex_buffer>(0, GL_DYNAMIC_DRAW);
-		const vertex_buffer* light_buffer[2] = {
-			&point_light_volume_->vbo(),
-			point_light_instance_data_.get()
-		};
-		light_volume_layout_.setup_layout(point_light_volume_->vao(), light_buffer);
 
 		point_light_program_ = std::make_unique<program>();
-		vertex_shader = shader_manager_.load("shader/point_light.vs", GL_VERTEX_SHADER);
+		vertex_shader = shader_manager_.load("shader/directional_light.vs", GL_VERTEX_SHADER);
 		if (!vertex_shader) {
-			throw std::runtime_error("could not load point_light.vs");
+			throw std::runtime_error("could not load directional_light.vs");
 		}
 		point_light_program_->attach_shader(vertex_shader);
 		fragment_shader = shader_manager_.load("shader/point_light.fs", GL_FRAGMENT_SHADER);
@@ -282,7 +472,37 @@ namespace zombye {
 		}
 		point_light_program_->attach_shader(fragment_shader);
 		light_volume_layout_.setup_program(*point_light_program_, "frag_color");
-		point_light_program_->link();
+		point_light_program_->link(program_cache_.get());
+
+		auto max_point_lights = std::max(quality["max_point_lights"].asInt(), 1);
+		auto point_light_fade_time = quality["point_light_fade_time"].asFloat();
+		light_culler_ = std::make_unique<light_culler>(16, 9, 24, max_point_lights, point_light_fade_time);
+
+		// levels of detail are picked by their error in pixels. shadows tolerate shadow_lod_bias times the error
+		// of the camera view, since their texels are spread over the scene.
+		lod_pixel_error_ = std::max(quality.get("lod_pixel_error", 1.f).asFloat(), 0.f);
+		shadow_lod_bias_ = std::max(quality.get("shadow_lod_bias", 1.f).asFloat(), 1.f);
+		lod_hysteresis_ = glm::clamp(quality.get("lod_hysteresis", 0.25f).asFloat(), 0.f, 1.f);
+
+		// the largest static meshes in view are rasterised on the cpu and hide what is behind them from the
+		// camera pass. the buffer has the aspect ratio of the window.
+		if (quality.get("occlusion_culling", true).asBool()) {
+			auto occlusion_width = std::max(quality.get("occlusion_resolution", 256).asInt(), 4);
+			auto occlusion_height = std::max(static_cast<int>(occlusion_width * height_ / width_), 1);
+			auto max_occluders = std::max(quality.get("max_occluders", 32).asInt(), 1);
+			occlusion_culler_ = std::make_unique<occlusion_culler>(occlusion_width, occlusion_height, max_occluders);
+			auto quad_width = 0.25f * width_;
+			auto quad_height = quad_width * occlusion_culler_->height() / occlusion_culler_->width();
+			occlusion_debug_quad_ = std::make_unique<screen_quad>(staticmesh_layout_,
+				glm::vec2{0.74f * width_, 0.99f * height_}, glm::vec2{0.99f * width_, 0.99f * height_ - quad_height});
+			log("occlusion culling with a " + std::to_string(occlusion_culler_->width()) + "x"
+				+ std::to_string(occlusion_culler_->height()) + " depth buffer and up to "
+				+ std::to_string(max_occluders) + " occluders");
+		}
+
+		// static meshes that opted into batching are merged per chunk of static_batch_chunk_size world units
+		static_batcher_ = std::make_unique<static_batcher>(game_, *this,
+			std::max(quality.get("static_batch_chunk_size", 32.f).asFloat(), 1.f));
 
 		directional_light_program_ = std::make_unique<program>();
 		vertex_shader = shader_manager_.load("shader/directional_light.vs", GL_VERTEX_SHADER);
@@ -296,21 +516,81 @@ namespace zombye {
 		}
 		directional_light_program_->attach_shader(fragment_shader);
 		light_volume_layout_.setup_program(*directional_light_program_, "frag_color");
-		directional_light_program_->link();
+		directional_light_program_->link(program_cache_.get());
+
+		program_cache_->finish_links();
+		shader_manager_.clear_preloaded();
+		auto& programs = program_cache_->statistics();
+		auto program_time = std::chrono::duration<double, std::milli>{std::chrono::steady_clock::now() - program_start};
+		log(std::string{programs.misses == 0 ? "warm" : "cold"} + " start: renderer set up with "
+			+ std::to_string(programs.hits + programs.misses) + " programs in " + std::to_string(program_time.count())
+			+ " ms, " + std::to_string(programs.hits) + " loaded from the program cache");
 
 		register_at_script_engine();
 	}
 
 	rendering_system::~rendering_system() {
 		window_ = nullptr;
-		SDL_GL_DeleteContext(context_);
+		if (context_) {
+			SDL_GL_DeleteContext(context_);
+		}
+
+		log("shadow cache: " + std::to_string(shadow_cache_statistics_.hits) + " hits, "
+			+ std::to_string(shadow_cache_statistics_.misses) + " misses, "
+			+ std::to_string(shadow_cache_statistics_.invalidations) + " invalidations, "
+			+ std::to_string(shadow_cache_statistics_.moving_hits) + " hits and "
+			+ std::to_string(shadow_cache_statistics_.moving_misses) + " misses while moving, "
+			+ std::to_string(shadow_cache_statistics_.recenters) + " recentered regions");
+		log("mesh memory: " + std::to_string(mesh_memory_statistics_.meshes) + " meshes, "
+			+ std::to_string(mesh_memory_statistics_.gpu_bytes) + " bytes on the gpu, "
+			+ std::to_string(mesh_memory_statistics_.uncompressed_bytes) + " bytes uncompressed");
+		log("occlusion culling: " + std::to_string(occlusion_statistics_.culled) + " of "
+			+ std::to_string(occlusion_statistics_.tested) + " tested draws culled, "
+			+ std::to_string(occlusion_statistics_.occluders) + " occluders with "
+			+ std::to_string(occlusion_statistics_.occluder_triangles) + " triangles rasterised");
+		auto textures = texture_streaming();
+		log("texture streaming: " + std::to_string(textures.textures) + " textures, "
+			+ std::to_string(textures.resident_bytes) + " of " + std::to_string(textures.budget_bytes)
+			+ " bytes resident, " + std::to_string(textures.uploaded_levels) + " levels uploaded, "
+			+ std::to_string(textures.evicted_levels) + " evicted");
+		auto transient = render_graph_->transient_bytes();
+		log("render graph: " + std::to_string(transient.second) + " bytes of transient targets allocated for "
+			+ std::to_string(transient.first) + " bytes of targets in the last frame");
+		log("texture arrays: " + std::to_string(texture_array_manager_.array_count()) + " arrays, "
+			+ std::to_string(material_table_->size() - 1) + " materials");
+		auto arena = geometry_arena_->statistics();
+		log("geometry arena: " + std::to_string(arena.pages) + " pages, " + std::to_string(arena.allocations)
+			+ " meshes, " + std::to_string(arena.used_bytes) + " of " + std::to_string(arena.capacity_bytes)
+			+ " bytes used, occupancy " + std::to_string(arena.occupancy) + ", " + std::to_string(arena.free_blocks)
+			+ " free blocks, fragmentation " + std::to_string(arena.fragmentation));
+
+		if (active_gl_backend() == gl_backend_type::null && frame_count_ > 0) {
+			log("null gl backend recorded " + std::to_string(frame_count_) + " frames");
+			log("gl calls: " + std::to_string(total_statistics_.calls)
+				+ " (" + std::to_string(total_statistics_.calls / frame_count_) + " per frame)");
+			log("draw calls: " + std::to_string(total_statistics_.draw_calls)
+				+ " (" + std::to_string(total_statistics_.draw_calls / frame_count_) + " per frame)");
+			log("state changes: " + std::to_string(total_statistics_.state_changes)
+				+ " (" + std::to_string(total_statistics_.state_changes / frame_count_) + " per frame)");
+			log("uniform uploads: " + std::to_string(total_statistics_.uniform_uploads)
+				+ " (" + std::to_string(total_statistics_.uniform_uploads / frame_count_) + " per frame)");
+			log("bytes uploaded: " + std::to_string(total_statistics_.bytes_uploaded)
+				+ " (" + std::to_string(total_statistics_.bytes_uploaded / frame_count_) + " per frame)");
+		}
 	}
 
 	void rendering_system::begin_scene() {
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		gl.clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 	}
 
 	void rendering_system::end_scene() {
+		if (active_gl_backend() == gl_backend_type::null) {
+			frame_statistics_ = gl_stats();
+			total_statistics_ += frame_statistics_;
+			++frame_count_;
+			reset_gl_stats();
+			return;
+		}
 		SDL_GL_SwapWindow(window_);
 	}
 
@@ -318,23 +598,117 @@ namespace zombye {
 		auto camera = camera_components_.find(active_camera_);
 		auto projection_view = glm::mat4{1.f};
 		auto view_vector = glm::vec3{1.f};
+		const camera_component* active_camera = nullptr;
 		if (camera != camera_components_.end()) {
 			projection_view = camera->second->projection_view();
 			view_vector = camera->second->owner().position();
+			active_camera = camera->second;
 		}
 
-		render_shadowmap();
-		apply_gaussian_blur();
+		record_commands(active_camera, delta_time);
+		build_draw_batches();
+		stream_textures();
+
+		skin_meshes();
+		if (!shadow_casting_) {
+			static_shadows_dirty_ = true;
+		}
+		update_resolution_scale();
 
-		glEnable(GL_DEPTH_TEST);
-		g_buffer_->bind();
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-		glCullFace(GL_BACK);
-		glEnable(GL_CULL_FACE);
+		// the passes are declared anew every frame and culled when nothing reads their results
+		static auto debug_mode = game_.config()->get("main", "deferred_shading_debug_draw").asBool();
+		static auto occlusion_debug_mode = game_.config()->get("main", "occlusion_debug_draw").asBool();
+		static auto print_graph = game_.config()->get("main", "print_render_graph").asBool();
+		auto& graph = *render_graph_;
+		graph.reset();
+		auto width = static_cast<GLsizei>(width_);
+		auto height = static_cast<GLsizei>(height_);
+		g_buffer_[0] = graph.create("albedo", render_target_desc{g_buffer_formats_[0], width, height});
+		g_buffer_[1] = graph.create("normal", render_target_desc{g_buffer_formats_[1], width, height});
+		g_buffer_[2] = graph.create("specular", render_target_desc{g_buffer_formats_[2], width, height});
+		g_buffer_[3] = graph.create("depth", render_target_desc{g_buffer_formats_[3], width, height});
+		auto g_buffer = std::vector<render_resource>{g_buffer_[0], g_buffer_[1], g_buffer_[2], g_buffer_[3]};
+		auto shadow_depth = graph.create("shadow depth", render_target_desc{GL_DEPTH_COMPONENT32F, shadow_resolution_,
+			shadow_resolution_});
+		auto shadow_moments = graph.import("shadow moments", shadow_moments_);
+		auto shadow = shadow_moments;
+		auto shadow_blurred = shadow_moments;
+		auto filter_writes = std::vector<render_resource>{shadow_moments};
+		if (shadow_filter_ != shadow_filter::none) {
+			// one layer is blurred at a time, so the horizontal pass only needs a single one
+			shadow_blurred = graph.create("shadow blurred", render_target_desc{shadow_moment_format_,
+				shadow_blur_resolution_, shadow_blur_resolution_, 1});
+			shadow = graph.import("shadow filtered", shadow_filtered_);
+			filter_writes = {shadow_blurred, shadow};
+		}
+
+		graph.add_pass("shadow map", {}, {shadow_depth, shadow_moments}, false, [this, shadow_depth, shadow_moments]() {
+			render_shadowmap(shadow_depth, shadow_moments);
+		});
+		graph.add_pass("shadow filter", {shadow_moments}, filter_writes, false, [this, shadow_blurred, shadow]() {
+			filter_shadowmap(shadow_blurred, shadow);
+		});
+		graph.add_pass("geometry", {}, g_buffer, false, [this, projection_view, view_vector]() {
+			render_geometry(projection_view, view_vector);
+		});
+		auto light_reads = g_buffer;
+		if (shadow_casting_) {
+			light_reads.emplace_back(shadow);
+		}
+		// point lights are blended onto what the directional lights wrote
+		auto light_writes = std::vector<render_resource>{};
+		auto point_light_reads = g_buffer;
+		if (dynamic_resolution_) {
+			scene_color_ = graph.create("scene color", render_target_desc{GL_RGB8, width, height});
+			light_writes.emplace_back(scene_color_);
+			point_light_reads.emplace_back(scene_color_);
+		}
+		graph.add_pass("directional lights", light_reads, light_writes, !dynamic_resolution_, [this]() {
+			render_lights(false);
+		});
+		graph.add_pass("point lights", point_light_reads, light_writes, !dynamic_resolution_, [this]() {
+			render_lights(true);
+		});
+		if (dynamic_resolution_) {
+			graph.add_pass("upscale", {scene_color_}, {}, true, [this]() {
+				render_upscale();
+			});
+		}
+		graph.add_pass("deferred shading debug", g_buffer, {}, debug_mode, [this]() {
+			render_debug_screen_quads();
+		});
+		graph.add_pass("occlusion debug", {}, {}, occlusion_debug_mode, [this]() {
+			render_occlusion_buffer();
+		});
+
+		graph.compile();
+		if (print_graph) {
+			auto description = graph.describe();
+			if (description != render_graph_description_) {
+				log(description);
+				render_graph_description_ = description;
+			}
+		}
+		frame_timer_->begin();
+		graph.execute(&game_.profiler());
+		frame_timer_->end();
+	}
+
+	void rendering_system::render_geometry(const glm::mat4& projection_view, const glm::vec3& view_vector) {
+		auto& g_buffer = render_graph_->framebuffer_of({{GL_COLOR_ATTACHMENT0, g_buffer_[0]},
+			{GL_COLOR_ATTACHMENT1, g_buffer_[1]}, {GL_COLOR_ATTACHMENT2, g_buffer_[2]},
+			{GL_DEPTH_ATTACHMENT, g_buffer_[3]}});
+		gl.enable(GL_DEPTH_TEST);
+		g_buffer.bind();
+		gl.viewport(0, 0, viewport_width_, viewport_height_);
+		gl.clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		gl.cull_face(GL_BACK);
+		gl.enable(GL_CULL_FACE);
 
 		render_skybox();
 
 		light_cube_program_->use();
+		light_cube_program_->uniform("octahedral_normals", octahedral_normals_);
 		for (auto& l : light_components_) {
 			auto mesh = l->owner().component<staticmesh_component>();
 			if (!mesh) {
@@ -354,47 +728,539 @@ namespace zombye {
 		staticmesh_program_->uniform("diffuse_texture", 0);
 		staticmesh_program_->uniform("specular_texture", 1);
 		staticmesh_program_->uniform("normal_texture", 2);
+		staticmesh_program_->uniform("draw_data", 8);
+		staticmesh_program_->uniform("draw_records", 9);
+		staticmesh_program_->uniform("material_table", 10);
+		staticmesh_program_->uniform("projection_view", false, projection_view);
 		staticmesh_program_->uniform("view_vector", view_vector);
+		staticmesh_program_->uniform("octahedral_normals", octahedral_normals_);
 		staticmesh_program_->uniform("disp_map_scale", disp_map_scale);
 		staticmesh_program_->uniform("disp_map_bias", -base_bias + base_bias * disp_map_offset);
-		for (auto& s : staticmesh_components_) {
-			if (s->owner().component<light_component>()) {
-				continue;
-			}
-			auto model = s->owner().transform();
-			auto model_it = glm::inverse(glm::transpose(model));
-			staticmesh_program_->uniform("m", false, model);
-			staticmesh_program_->uniform("mit", false, model_it);
-			staticmesh_program_->uniform("mvp", false, projection_view * model);
-			staticmesh_program_->uniform("parallax_mapping", s->mesh()->parallax_mapping());
-			s->draw();
-		}
+		draw_data_texture_->bind(8);
+		draw_record_texture_->bind(9);
+		material_table_->bind(10);
+		draw_batches(geometry_batches_, *staticmesh_program_, false);
 
 		animation_program_->use();
 		animation_program_->uniform("diffuse_texture", 0);
 		animation_program_->uniform("specular_texture", 1);
 		animation_program_->uniform("normal_texture", 2);
+		animation_program_->uniform("draw_data", 8);
+		animation_program_->uniform("draw_records", 9);
+		animation_program_->uniform("material_table", 10);
+		animation_program_->uniform("projection_view", false, projection_view);
 		animation_program_->uniform("view_vector", view_vector);
+		animation_program_->uniform("octahedral_normals", octahedral_normals_);
 		animation_program_->uniform("disp_map_scale", disp_map_scale);
-		for (auto& a: animation_components_) {
-			auto model = a->owner().transform();
+		auto draw_offset_location = animation_program_->uniform_location("draw_offset");
+		for (auto& command : animation_commands_) {
+			if (!command.mesh) {
+				continue;
+			}
+			animation_program_->uniform(draw_offset_location, static_cast<int>(command.draw));
+			command.mesh->draw_skinned(command.base_vertex, command.lod);
+		}
+
+		gl.disable(GL_CULL_FACE);
+		gl.disable(GL_DEPTH_TEST);
+		g_buffer.bind_default();
+		gl.viewport(0, 0, width_, height_);
+	}
+
+	void rendering_system::record_commands(const camera_component* camera, float delta_time) {
+		const static auto grain = size_t{32};
+
+		shadow_casting_ = false;
+		if (camera && directional_light_components_.size() != 0) {
+			auto& owner = directional_light_components_.front()->owner();
+			if (owner.component<shadow_component>()) {
+				fit_shadow_cascades(*camera, owner.position());
+				shadow_casting_ = true;
+			}
+		}
+
+		// casters are tested per cascade with a bounding sphere in light space. a caster is culled if it is
+		// outside the cascade sideways or behind it. casters between light and cascade are kept because
+		// depth clamping flattens them onto the near plane.
+		// static casters are tested against the static region of the cascade, since they are cached for all of it.
+		auto cast_into = [this](const glm::mat4& model, const bounding_box& bounds, float growth,
+		const std::vector<glm::vec4>& cascade_bounds, bool* cascades) {
+			auto scale = std::max(glm::length(glm::vec3{model[0]}),
+				std::max(glm::length(glm::vec3{model[1]}), glm::length(glm::vec3{model[2]})));
+			auto radius = glm::length(bounds.extent()) * scale * growth;
+			auto center = glm::vec3{shadow_view_ * model * glm::vec4{bounds.center(), 1.f}};
+			for (auto k = 0; k < shadow_cascades_; ++k) {
+				auto& cascade = cascade_bounds[k];
+				cascades[k] = std::abs(center.x - cascade.x) <= cascade.w + radius
+					&& std::abs(center.y - cascade.y) <= cascade.w + radius
+					&& center.z + radius >= cascade.z - cascade.w;
+			}
+		};
+
+		// static draws are the static mesh components followed by the static batch chunks. components merged
+		// into a chunk are skipped.
+		static_batcher_->update(staticmesh_components_);
+		auto& chunks = static_batcher_->chunks();
+		auto component_count = staticmesh_components_.size();
+		auto static_count = component_count + chunks.size();
+		auto static_draw_at = [this, &chunks, component_count](size_t i) {
+			if (i < component_count) {
+				auto component = staticmesh_components_[i];
+				auto& owner = component->owner();
+				auto mesh = component->batched() ? nullptr : component->mesh().get();
+				return static_draw{mesh, owner.transform(), &component->lod(), &owner};
+			}
+			auto& chunk = chunks[i - component_count];
+			return static_draw{chunk.mesh.get(), glm::mat4{1.f}, &chunk.lod, nullptr};
+		};
+
+		shadow_staticmesh_commands_.resize(shadow_casting_ ? shadow_cascades_ * static_count : 0);
+		shadow_animation_commands_.resize(shadow_casting_ ? shadow_cascades_ * animation_components_.size() : 0);
+		staticmesh_commands_.resize(static_count);
+		animation_commands_.resize(animation_components_.size());
+		point_light_instances_.resize(light_components_.size());
+
+		// static draws have the draw data at their index, skinned meshes follow them
+		draw_data_.resize(static_count + animation_components_.size());
+		auto write_draw_data = [this](size_t index, const glm::mat4& model, bool parallax_mapping) {
 			auto model_it = glm::inverse(glm::transpose(model));
-			animation_program_->uniform("m", false, model);
-			animation_program_->uniform("mit", false, model_it);
-			animation_program_->uniform("mvp", false, projection_view * model);
-			animation_program_->uniform("pose", a->pose().size(), false, a->pose());
-			animation_program_->uniform("parallax_mapping", a->mesh()->parallax_mapping());
-			a->draw();
+			auto& data = draw_data_[index];
+			data.model = model;
+			data.model_it[0] = glm::vec4{glm::vec3{model_it[0]}, parallax_mapping ? 1.f : 0.f};
+			data.model_it[1] = glm::vec4{glm::vec3{model_it[1]}, 0.f};
+			data.model_it[2] = glm::vec4{glm::vec3{model_it[2]}, 0.f};
+		};
+
+		// pixels per model unit at the point of the bounds nearest to the camera. the error of a level of detail
+		// times this is its error on screen.
+		auto camera_position = camera ? camera->owner().position() : glm::vec3{0.f};
+		auto projection_scale = camera ? 0.5f * viewport_height_ * camera->projection()[1][1] : 0.f;
+		auto pixels_per_unit = [camera, camera_position, projection_scale](const glm::mat4& model, const bounding_box& bounds) {
+			if (!camera) {
+				return std::numeric_limits<float>::max();
+			}
+			auto scale = std::max(glm::length(glm::vec3{model[0]}),
+				std::max(glm::length(glm::vec3{model[1]}), glm::length(glm::vec3{model[2]})));
+			auto center = glm::vec3{model * glm::vec4{bounds.center(), 1.f}};
+			auto distance = glm::length(center - camera_position) - glm::length(bounds.extent()) * scale;
+			return scale * projection_scale / std::max(distance, 0.001f);
+		};
+
+		auto caster_count = shadow_casting_ ? static_count : 0;
+		worker_pool_->parallel_for(caster_count, grain, [this, &cast_into, &pixels_per_unit, &static_draw_at,
+		static_count](size_t begin, size_t end) {
+			for (auto i = begin; i < end; ++i) {
+				auto draw = static_draw_at(i);
+				bool cascades[max_shadow_cascades] = {false};
+				auto dynamic = draw.owner && is_dynamic_caster(*draw.owner);
+				if (draw.mesh) {
+					if (!draw.owner || !draw.owner->component<no_occluder_component>()) {
+						cast_into(draw.model, draw.mesh->bounds(), 1.f, dynamic ? cascade_bounds_ : static_shadow_bounds_,
+							cascades);
+					}
+					draw.lod->shadow_lod = select_lod(draw.mesh->lods(), draw.lod->shadow_lod,
+						pixels_per_unit(draw.model, draw.mesh->bounds()), lod_pixel_error_ * shadow_lod_bias_,
+						lod_hysteresis_);
+				}
+				for (auto k = 0; k < shadow_cascades_; ++k) {
+					auto& command = shadow_staticmesh_commands_[k * static_count + i];
+					command.mesh = cascades[k] ? draw.mesh : nullptr;
+					command.base_vertex = 0;
+					command.lod = draw.lod->shadow_lod;
+					command.draw = static_cast<uint32_t>(i);
+					command.dynamic = dynamic;
+				}
+			}
+		});
+
+		caster_count = shadow_casting_ ? animation_components_.size() : 0;
+		worker_pool_->parallel_for(caster_count, grain, [this, &cast_into, &pixels_per_unit, static_count](size_t begin,
+		size_t end) {
+			auto count = animation_components_.size();
+			for (auto i = begin; i < end; ++i) {
+				auto& owner = animation_components_[i]->owner();
+				bool cascades[max_shadow_cascades] = {false};
+				auto mesh = animation_components_[i]->mesh().get();
+				auto model = owner.transform();
+				// the bind pose bounds are grown, since animations move vertices outside of them
+				if (!owner.component<no_occluder_component>()) {
+					cast_into(model, mesh->bounds(), 1.5f, cascade_bounds_, cascades);
+				}
+				auto& lod = animation_components_[i]->lod();
+				lod.shadow_lod = select_lod(mesh->lods(), lod.shadow_lod, pixels_per_unit(model, mesh->bounds()),
+					lod_pixel_error_ * shadow_lod_bias_, lod_hysteresis_);
+				for (auto k = 0; k < shadow_cascades_; ++k) {
+					auto& command = shadow_animation_commands_[k * count + i];
+					command.mesh = cascades[k] ? mesh : nullptr;
+					command.lod = lod.shadow_lod;
+					command.draw = static_cast<uint32_t>(static_count + i);
+					command.dynamic = true;
+				}
+			}
+		});
+
+		// occluders are drawn before any draw is tested against them. only the camera pass is culled, since
+		// hidden objects still cast visible shadows.
+		if (camera && occlusion_culler_) {
+			occluders_.resize(static_count);
+			worker_pool_->parallel_for(static_count, grain, [this, &static_draw_at](size_t begin, size_t end) {
+				for (auto i = begin; i < end; ++i) {
+					auto draw = static_draw_at(i);
+					occluders_[i].mesh = nullptr;
+					if (!draw.mesh) {
+						continue;
+					}
+					if (draw.owner && (draw.owner->component<no_occluder_component>()
+					|| draw.owner->component<light_component>())) {
+						continue;
+					}
+					occluders_[i] = occluder{&draw.mesh->occluder(), draw.model, draw.mesh->bounds()};
+				}
+			});
+			occlusion_culler_->render(occluders_, *camera, *worker_pool_);
+		} else if (occlusion_culler_) {
+			occlusion_culler_->disable();
+		}
+
+		// the draw data of meshes that are only drawn into the shadow map is written here as well
+		worker_pool_->parallel_for(staticmesh_commands_.size(), grain, [this, &pixels_per_unit, &write_draw_data,
+		&static_draw_at](size_t begin, size_t end) {
+			for (auto i = begin; i < end; ++i) {
+				auto draw = static_draw_at(i);
+				auto& command = staticmesh_commands_[i];
+				command.mesh = nullptr;
+				if (!draw.mesh) {
+					continue;
+				}
+				write_draw_data(i, draw.model, draw.mesh->parallax_mapping());
+				if (draw.owner && draw.owner->component<light_component>()) {
+					continue;
+				}
+				if (occlusion_culler_ && !occlusion_culler_->visible(draw.model, draw.mesh->bounds())) {
+					continue;
+				}
+				command.mesh = draw.mesh;
+				command.base_vertex = 0;
+				draw.lod->lod = select_lod(draw.mesh->lods(), draw.lod->lod, pixels_per_unit(draw.model,
+					draw.mesh->bounds()), lod_pixel_error_, lod_hysteresis_);
+				command.lod = draw.lod->lod;
+				command.draw = static_cast<uint32_t>(i);
+				command.pixels = 2.f * glm::length(draw.mesh->bounds().extent()) * pixels_per_unit(draw.model,
+					draw.mesh->bounds());
+			}
+		});
+
+		worker_pool_->parallel_for(animation_commands_.size(), grain, [this, &pixels_per_unit, &write_draw_data,
+		static_count](size_t begin, size_t end) {
+			for (auto i = begin; i < end; ++i) {
+				auto& command = animation_commands_[i];
+				command.mesh = animation_components_[i]->mesh().get();
+				auto model = animation_components_[i]->owner().transform();
+				write_draw_data(static_count + i, model, command.mesh->parallax_mapping());
+				auto& lod = animation_components_[i]->lod();
+				auto pixels = pixels_per_unit(model, command.mesh->bounds());
+				lod.lod = select_lod(command.mesh->lods(), lod.lod, pixels, lod_pixel_error_, lod_hysteresis_);
+				command.lod = lod.lod;
+				command.draw = static_cast<uint32_t>(static_count + i);
+				command.pixels = 2.f * glm::length(command.mesh->bounds().extent()) * pixels;
+				// like for shadows the bind pose bounds are grown
+				auto& bounds = command.mesh->bounds();
+				auto grown = bounding_box{bounds.center() - 1.5f * bounds.extent(), bounds.center() + 1.5f * bounds.extent()};
+				if (occlusion_culler_ && !occlusion_culler_->visible(model, grown)) {
+					command.mesh = nullptr;
+				}
+			}
+		});
+
+		// only skinned meshes with a geometry or shadow command this frame get a range in the shared skinned
+		// vertex buffer, the others are not skinned at all
+		auto animation_count = animation_components_.size();
+		auto shadow_passes = shadow_casting_ ? shadow_cascades_ : 0;
+		skinned_base_vertices_.resize(animation_count);
+		skinned_vertex_count_ = 0;
+		for (auto i = size_t{0}; i < animation_count; ++i) {
+			auto drawn = animation_commands_[i].mesh != nullptr;
+			for (auto k = 0; k < shadow_passes && !drawn; ++k) {
+				drawn = shadow_animation_commands_[k * animation_count + i].mesh != nullptr;
+			}
+			skinned_base_vertices_[i] = drawn ? static_cast<int32_t>(skinned_vertex_count_) : -1;
+			if (drawn) {
+				skinned_vertex_count_ += animation_components_[i]->mesh()->vertex_count();
+			}
+			animation_commands_[i].base_vertex = skinned_base_vertices_[i];
+		}
+		for (auto i = size_t{0}; i < shadow_animation_commands_.size(); ++i) {
+			shadow_animation_commands_[i].base_vertex = skinned_base_vertices_[i % animation_count];
 		}
 
-		glDisable(GL_CULL_FACE);
-		glDisable(GL_DEPTH_TEST);
-		g_buffer_->bind_default();
+		if (camera && occlusion_culler_) {
+			auto occlusion = occlusion_culler_->statistics();
+			occlusion_statistics_.occluders += occlusion.occluders;
+			occlusion_statistics_.occluder_triangles += occlusion.occluder_triangles;
+			occlusion_statistics_.tested += occlusion.tested;
+			occlusion_statistics_.culled += occlusion.culled;
+		}
 
-		render_lights();
-		static auto debug_mode = game_.config()->get("main", "deferred_shading_debug_draw").asBool();
-		if (debug_mode) {
-			render_debug_screen_quads();
+		worker_pool_->parallel_for(point_light_instances_.size(), grain, [this](size_t begin, size_t end) {
+			for (auto i = begin; i < end; ++i) {
+				auto light = light_components_[i];
+				// the light is shaded with its distance, but binned only up to where it fades out
+				auto extent = std::min(light->distance(), calculate_point_light_extend(*light));
+				point_light_instances_[i] = light_attributes{
+					light->owner().position(),
+					light->color(),
+					light->distance(),
+					extent > 0.f ? extent : 0.f,
+					light->exponent(),
+					light
+				};
+			}
+		});
+
+		if (camera) {
+			light_culler_->cull(point_light_instances_, *camera, delta_time, *worker_pool_);
+		}
+	}
+
+	void rendering_system::stream_textures() {
+		auto streamer = texture_manager_.streamer();
+		if (!streamer) {
+			return;
+		}
+		// static meshes stream the arrays their layers live in
+		auto request = [streamer](const std::vector<submesh>& submeshes, const mesh_lod& level, float pixels) {
+			for (auto i = level.first_submesh; i < level.first_submesh + level.submesh_count; ++i) {
+				auto& sub = submeshes[i];
+				if (sub.diffuse_layer) {
+					streamer->request(&sub.diffuse_layer->array(), pixels);
+					streamer->request(&sub.normal_layer->array(), pixels);
+					streamer->request(&sub.material_layer->array(), pixels);
+				} else {
+					streamer->request(sub.diffuse.get(), pixels);
+					streamer->request(sub.normal.get(), pixels);
+					streamer->request(sub.material.get(), pixels);
+				}
+			}
+		};
+		for (auto& command : staticmesh_commands_) {
+			if (command.mesh) {
+				request(command.mesh->submeshes(), command.mesh->lods()[command.lod], command.pixels);
+			}
+		}
+		for (auto& command : animation_commands_) {
+			if (command.mesh) {
+				request(command.mesh->submeshes(), command.mesh->lods()[command.lod], command.pixels);
+			}
+		}
+		// the skybox surrounds the camera
+		auto& skybox_lods = skybox_mesh_->lods();
+		request(skybox_mesh_->submeshes(), skybox_lods.front(), std::numeric_limits<float>::max());
+		streamer->update();
+	}
+
+	void rendering_system::build_draw_batches() {
+		// the draw data is written once per frame and read by every pass
+		draw_data_buffer_->next_frame();
+		if (!draw_data_.empty()) {
+			auto size = draw_data_.size() * sizeof(draw_data);
+			auto offset = draw_data_buffer_->write(draw_data_.data(), size);
+			draw_data_texture_->view(GL_RGBA32F, *draw_data_buffer_, offset, size);
+		}
+
+		// every submesh draw gets a record pairing the draw data of its object with its material. the
+		// records of whole objects come first, so draw ids below draw_data_.size() still address objects.
+		draw_records_.clear();
+		for (auto i = size_t{0}; i < draw_data_.size(); ++i) {
+			draw_records_.emplace_back(static_cast<int32_t>(i), 0);
+		}
+		indirect_commands_.clear();
+		geometry_batches_.clear();
+		for (auto& command : staticmesh_commands_) {
+			if (!command.mesh) {
+				continue;
+			}
+			auto& geometry = command.mesh->geometry();
+			auto& level = command.mesh->lods()[command.lod];
+			auto& submeshes = command.mesh->submeshes();
+			for (auto i = level.first_submesh; i < level.first_submesh + level.submesh_count; ++i) {
+				auto& sub = submeshes[i];
+				auto record = static_cast<uint32_t>(draw_records_.size());
+				draw_records_.emplace_back(static_cast<int32_t>(command.draw), static_cast<int32_t>(sub.material_id));
+				batch_entries_.emplace_back(batch_entry{geometry.page, &sub, draw_elements_indirect_command{
+					static_cast<uint32_t>(sub.index_count), 1, static_cast<uint32_t>(geometry.first_index + sub.offset),
+					geometry.base_vertex, record}});
+			}
+		}
+		append_batches(geometry_batches_);
+
+		draw_record_buffer_->next_frame();
+		if (!draw_records_.empty()) {
+			auto size = draw_records_.size() * sizeof(glm::ivec2);
+			auto offset = draw_record_buffer_->write(draw_records_.data(), size);
+			draw_record_texture_->view(GL_RG32I, *draw_record_buffer_, offset, size);
+		}
+		geometry_arena_->reserve_draws(draw_records_.size());
+
+		// static and dynamic casters are batched separately per cascade, since the static ones are cached
+		auto count = staticmesh_commands_.size();
+		for (auto k = 0; k < max_shadow_cascades; ++k) {
+			for (auto dynamic = 0; dynamic < 2; ++dynamic) {
+				shadow_batches_[k][dynamic].clear();
+				if (!shadow_casting_ || k >= shadow_cascades_) {
+					continue;
+				}
+				for (auto i = k * count; i < (k + 1) * count; ++i) {
+					auto& command = shadow_staticmesh_commands_[i];
+					if (!command.mesh || command.dynamic != (dynamic != 0)) {
+						continue;
+					}
+					auto& geometry = command.mesh->geometry();
+					auto& level = command.mesh->lods()[command.lod];
+					batch_entries_.emplace_back(batch_entry{geometry.page, nullptr, draw_elements_indirect_command{
+						static_cast<uint32_t>(level.index_count), 1,
+						static_cast<uint32_t>(geometry.first_index + level.first_index), geometry.base_vertex,
+						command.draw}});
+				}
+				append_batches(shadow_batches_[k][dynamic]);
+			}
+		}
+
+		if (multi_draw_indirect_) {
+			indirect_buffer_->next_frame();
+			if (!indirect_commands_.empty()) {
+				indirect_offset_ = indirect_buffer_->write(indirect_commands_.data(),
+					indirect_commands_.size() * sizeof(draw_elements_indirect_command));
+			}
+		}
+	}
+
+	void rendering_system::append_batches(std::vector<draw_batch>& batches) {
+		using batch_key = std::tuple<const geometry_page*, const texture*, const texture*, const texture*>;
+		auto key = [](const geometry_page* page, const submesh* textures) {
+			if (!textures) {
+				return batch_key{page, nullptr, nullptr, nullptr};
+			}
+			return batch_key{page, &textures->diffuse_layer->array(), &textures->material_layer->array(),
+				&textures->normal_layer->array()};
+		};
+		std::sort(batch_entries_.begin(), batch_entries_.end(), [&key](const batch_entry& lhs, const batch_entry& rhs) {
+			return key(lhs.page, lhs.textures) < key(rhs.page, rhs.textures);
+		});
+
+		for (auto& entry : batch_entries_) {
+			if (batches.empty() || key(entry.page, entry.textures) != key(batches.back().page, batches.back().textures)) {
+				batches.emplace_back(draw_batch{entry.page, entry.textures, indirect_commands_.size(), 0});
+			}
+			indirect_commands_.emplace_back(entry.command);
+			++batches.back().command_count;
+		}
+		batch_entries_.clear();
+	}
+
+	void rendering_system::draw_batches(const std::vector<draw_batch>& batches, program& program, bool depth) const {
+		// with multi draw indirect the draw id stream carries the index of the draw record, otherwise it reads 0
+		// and the index is passed per draw. depth passes index the draw data of their objects directly.
+		auto draw_offset_location = program.uniform_location("draw_offset");
+		if (multi_draw_indirect_) {
+			program.uniform(draw_offset_location, 0);
+			indirect_buffer_->bind();
+		}
+		for (auto& batch : batches) {
+			auto& page = *batch.page;
+			if (depth) {
+				page.depth_vao.bind();
+			} else {
+				page.vao.bind();
+			}
+			if (batch.textures) {
+				batch.textures->diffuse_layer->array().bind(0);
+				batch.textures->material_layer->array().bind(1);
+				batch.textures->normal_layer->array().bind(2);
+			}
+			if (multi_draw_indirect_) {
+				auto offset = indirect_offset_ + batch.first_command * sizeof(draw_elements_indirect_command);
+				gl.multi_draw_elements_indirect(GL_TRIANGLES, page.index_type, reinterpret_cast<const void*>(offset),
+					batch.command_count, 0);
+				continue;
+			}
+			for (auto i = batch.first_command; i < batch.first_command + batch.command_count; ++i) {
+				auto& command = indirect_commands_[i];
+				program.uniform(draw_offset_location, static_cast<int32_t>(command.base_instance));
+				gl.draw_elements_base_vertex(GL_TRIANGLES, command.count, page.index_type,
+					reinterpret_cast<void*>(command.first_index * page.index_size), command.base_vertex);
+			}
+		}
+	}
+
+	void rendering_system::fit_shadow_cascades(const camera_component& camera, const glm::vec3& light_direction) {
+		const static auto split_weight = 0.75f;
+
+		auto& projection = camera.projection();
+		auto near_plane = projection[3][2] / (projection[2][2] - 1.f);
+		auto far_plane = std::min(projection[3][2] / (projection[2][2] + 1.f), shadow_distance_);
+		auto tan_half_x = 1.f / projection[0][0];
+		auto tan_half_y = 1.f / projection[1][1];
+		auto camera_transform = camera.owner().transform();
+
+		auto direction = glm::normalize(light_direction);
+		auto up = std::abs(direction.y) > 0.99f ? glm::vec3{0.f, 0.f, 1.f} : glm::vec3{0.f, 1.f, 0.f};
+		shadow_view_ = glm::lookAt(glm::vec3{0.f}, -direction, up);
+
+		auto split_near = near_plane;
+		for (auto k = 0; k < shadow_cascades_; ++k) {
+			auto s = static_cast<float>(k + 1) / shadow_cascades_;
+			auto logarithmic = near_plane * std::pow(far_plane / near_plane, s);
+			auto uniform = near_plane + (far_plane - near_plane) * s;
+			auto split_far = split_weight * logarithmic + (1.f - split_weight) * uniform;
+
+			// the slice of the view frustum is enclosed by a sphere, which keeps the cascade size constant
+			// when the camera rotates.
+			glm::vec3 corners[8];
+			auto center = glm::vec3{0.f};
+			for (auto c = 0; c < 8; ++c) {
+				auto d = c < 4 ? split_near : split_far;
+				auto x = (c & 1) ? 1.f : -1.f;
+				auto y = (c & 2) ? 1.f : -1.f;
+				corners[c] = glm::vec3{x * d * tan_half_x, y * d * tan_half_y, -d};
+				center += corners[c] / 8.f;
+			}
+			auto radius = 0.f;
+			for (auto& corner : corners) {
+				radius = std::max(radius, glm::length(corner - center));
+			}
+			radius = std::ceil(radius * 16.f) / 16.f;
+
+			// snapping the center to whole texels keeps the shadow edges from swimming while the camera moves
+			auto texel_size = 2.f * radius / shadow_resolution_;
+			auto light_center = glm::vec3{shadow_view_ * camera_transform * glm::vec4{center, 1.f}};
+			light_center.x = std::floor(light_center.x / texel_size) * texel_size;
+			light_center.y = std::floor(light_center.y / texel_size) * texel_size;
+			light_center.z = std::floor(light_center.z / texel_size) * texel_size;
+
+			// the static region is snapped to the same texels and only moves when the cascade leaves its guard
+			// band, so the cached static layer stays valid while the camera moves inside of it
+			auto guard = static_shadow_guard_ * texel_size;
+			auto& region = static_shadow_bounds_[k];
+			if (region.w != radius + guard || std::abs(light_center.x - region.x) > guard
+			|| std::abs(light_center.y - region.y) > guard || std::abs(light_center.z - region.z) > guard) {
+				region = glm::vec4{light_center, radius + guard};
+				++shadow_cache_statistics_.recenters;
+			}
+
+			// cascade and static region share their depth range, so the static depths and moments can be
+			// copied into the cascade unchanged
+			auto near_depth = -region.z - 2.f * radius - guard;
+			auto far_depth = -region.z + radius + guard;
+			static_shadow_regions_[k] = glm::ortho(region.x - region.w, region.x + region.w,
+				region.y - region.w, region.y + region.w, near_depth, far_depth) * shadow_view_;
+			auto cascade_projection = glm::ortho(light_center.x - radius, light_center.x + radius,
+				light_center.y - radius, light_center.y + radius, near_depth, far_depth) * shadow_view_;
+			moved_shadow_layers_[k] = cascade_projection != shadow_projections_[k];
+			shadow_projections_[k] = cascade_projection;
+			cascade_bounds_[k] = glm::vec4{light_center, radius};
+			cascade_splits_[k] = split_far;
+
+			split_near = split_far;
 		}
 	}
 
@@ -411,9 +1277,12 @@ namespace zombye {
 		screen_quad_program_->uniform("near_plane", 0.1f);
 		screen_quad_program_->uniform("far_plane", 1000.f);
 		screen_quad_program_->uniform("color_texture", 0);
+		auto scale = glm::vec2{viewport_width_ / width_, viewport_height_ / height_};
+		screen_quad_program_->uniform("texcoord_scale", scale);
+		screen_quad_program_->uniform("texcoord_max", scale);
 
 		for (auto i = 0; i < 4; ++i) {
-			g_buffer_->attachment(attachments[i]).bind(0);
+			render_graph_->target(g_buffer_[i]).bind(0);
 
 			screen_quad_program_->uniform("linearize", false);
 			if (attachments[i] == GL_DEPTH_ATTACHMENT) {
@@ -424,23 +1293,27 @@ namespace zombye {
 		}
 	}
 
-	void rendering_system::render_screen_quad()  {
-		const static GLenum attachments[4] = {
-			GL_COLOR_ATTACHMENT0,
-			GL_COLOR_ATTACHMENT1,
-			GL_COLOR_ATTACHMENT2,
-			GL_DEPTH_ATTACHMENT
-		};
-
-		std::vector<glm::vec3> point_light_positions;
-		std::vector<glm::vec3> point_light_colors;
-		std::vector<float> point_light_radii;
-		for (auto& l : light_components_) {
-			point_light_positions.emplace_back(l->owner().position());
-			point_light_colors.emplace_back(l->color());
-			point_light_radii.emplace_back(l->distance());
+	void rendering_system::render_occlusion_buffer() {
+		if (!occlusion_culler_) {
+			return;
 		}
+		auto& depth = occlusion_culler_->depth();
+		occlusion_texture_ = std::make_unique<texture>(GL_TEXTURE_2D, GL_R32F, occlusion_culler_->width(),
+			occlusion_culler_->height(), GL_RED, GL_FLOAT, depth.data());
+
+		screen_quad_program_->use();
+		screen_quad_program_->uniform("projection", false, ortho_projection_);
+		screen_quad_program_->uniform("near_plane", 0.1f);
+		screen_quad_program_->uniform("far_plane", 1000.f);
+		screen_quad_program_->uniform("color_texture", 0);
+		screen_quad_program_->uniform("linearize", true);
+		screen_quad_program_->uniform("texcoord_scale", glm::vec2{1.f});
+		screen_quad_program_->uniform("texcoord_max", glm::vec2{1.f});
+		occlusion_texture_->bind(0);
+		occlusion_debug_quad_->draw();
+	}
 
+	void rendering_system::render_screen_quad()  {
 		std::vector<glm::vec3> directional_light_directions;
 		std::vector<glm::vec3> directional_light_colors;
 		std::vector<float> directional_light_energy;
@@ -452,9 +1325,11 @@ namespace zombye {
 
 		auto camera = camera_components_.find(active_camera_);
 		auto projection_view = glm::mat4{1.f};
+		auto view = glm::mat4{1.f};
 		auto camera_position = glm::vec3{0.f};
 		if (camera != camera_components_.end()) {
 			projection_view = camera->second->projection_view();
+			view = camera->second->view();
 			camera_position = camera->second->owner().position();
 		}
 
@@ -464,122 +1339,252 @@ namespace zombye {
 		composition_program_->uniform("normal_texture", 1);
 		composition_program_->uniform("specular_texture", 2);
 		composition_program_->uniform("depth_texture", 3);
+		composition_program_->uniform("octahedral_normals", octahedral_normals_);
 		composition_program_->uniform("shadow_texture", 4);
 		composition_program_->uniform("inv_view_projection", false, glm::inverse(projection_view));
 		composition_program_->uniform("view_vector", camera_position);
-		composition_program_->uniform("point_light_num", static_cast<int32_t>(light_components_.size()));
-		composition_program_->uniform("point_light_positions", light_components_.size(), point_light_positions);
-		composition_program_->uniform("point_light_colors", light_components_.size(), point_light_colors);
-		composition_program_->uniform("point_light_radii", light_components_.size(), point_light_radii);
+		composition_program_->uniform("view", false, view);
+		composition_program_->uniform("light_texture", 5);
+		composition_program_->uniform("cluster_texture", 6);
+		composition_program_->uniform("light_index_texture", 7);
+		light_culler_->setup_program(*composition_program_);
 		composition_program_->uniform("directional_light_num", static_cast<int32_t>(directional_light_components_.size()));
 		composition_program_->uniform("directional_light_directions", directional_light_components_.size(), directional_light_directions);
 		composition_program_->uniform("directional_light_colors", directional_light_components_.size(), directional_light_colors);
 		composition_program_->uniform("directional_light_energy", directional_light_components_.size(), directional_light_energy);
-		composition_program_->uniform("shadow_projection", false, shadow_projection_);
+		composition_program_->uniform("shadow_projection", false, shadow_projections_.front());
 		composition_program_->uniform("ambient_term", glm::vec3(0.1));
 
 		for (auto i = 0; i < 4; ++i) {
-			g_buffer_->attachment(attachments[i]).bind(i);
+			render_graph_->target(g_buffer_[i]).bind(i);
 		}
-		shadow_map_->attachment(GL_COLOR_ATTACHMENT0).bind(4);
+		shadow_texture().bind(4);
+		light_culler_->upload();
+		light_culler_->bind(5, 6, 7);
 		screen_quad_->draw();
 	}
 
-	void rendering_system::render_shadowmap()  {
-		if (directional_light_components_.size() == 0) {
+	void rendering_system::skin_meshes() {
+		auto count = animation_components_.size();
+		if (skinned_vertex_count_ == 0) {
 			return;
 		}
-		auto dir_light = directional_light_components_.front();
-		auto& owner = dir_light->owner();
-		auto dir_light_shadow = owner.component<shadow_component>();
-		if (!dir_light_shadow) {
-			return;
+
+		// all poses share one palette in a buffer texture, so the bone count is not bound by uniform limits
+		pose_data_.clear();
+		auto pose_offsets = std::vector<int32_t>(count);
+		for (auto i = size_t{0}; i < count; ++i) {
+			if (skinned_base_vertices_[i] < 0) {
+				continue;
+			}
+			auto& pose = animation_components_[i]->pose();
+			pose_offsets[i] = static_cast<int32_t>(pose_data_.size());
+			pose_data_.insert(pose_data_.end(), pose.begin(), pose.end());
+		}
+		if (!pose_data_.empty()) {
+			auto pose_size = pose_data_.size() * sizeof(glm::mat4);
+			pose_buffer_->next_frame();
+			auto pose_buffer_offset = pose_buffer_->write(pose_data_.data(), pose_size);
+			pose_texture_->view(GL_RGBA32F, *pose_buffer_, pose_buffer_offset, pose_size);
 		}
 
-		glEnable(GL_DEPTH_TEST);
-		glEnable(GL_DEPTH_CLAMP);
-		glFrontFace(GL_CCW);
-		glCullFace(GL_BACK);
-		glEnable(GL_CULL_FACE);
-		glViewport(0, 0, shadow_resolution_, shadow_resolution_);
+		if (skinned_vertex_count_ > skinned_vertex_capacity_) {
+			while (skinned_vertex_capacity_ < skinned_vertex_count_) {
+				skinned_vertex_capacity_ *= 2;
+			}
+			for (auto s = 0; s < 4; ++s) {
+				skinned_streams_[s]->data(skinned_vertex_capacity_ * skinned_stream_sizes[s], nullptr);
+			}
+		}
 
-		shadow_map_->bind();
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		gl.enable(GL_RASTERIZER_DISCARD);
+		skinning_program_->use();
+		skinning_program_->uniform("pose_texture", 0);
+		auto pose_offset_location = skinning_program_->uniform_location("pose_offset");
+		pose_texture_->bind(0);
+		for (auto i = size_t{0}; i < count; ++i) {
+			auto& mesh = *animation_components_[i]->mesh();
+			if (skinned_base_vertices_[i] < 0 || mesh.vertex_count() == 0) {
+				continue;
+			}
+			skinning_program_->uniform(pose_offset_location, pose_offsets[i]);
+			for (auto s = 0; s < 4; ++s) {
+				skinned_streams_[s]->bind_range(GL_TRANSFORM_FEEDBACK_BUFFER, s, skinned_base_vertices_[i] * skinned_stream_sizes[s],
+					mesh.vertex_count() * skinned_stream_sizes[s]);
+			}
+			gl.begin_transform_feedback(GL_POINTS);
+			mesh.skin();
+			gl.end_transform_feedback();
+		}
+		gl.disable(GL_RASTERIZER_DISCARD);
+	}
 
-		shadow_projection_ = glm::ortho(-30.f, 30.f, -30.f, 30.f, -30.f, 30.f);
-		shadow_projection_ *= glm::lookAt(owner.position(), glm::vec3{0.f}, glm::vec3{0.f, 1.f, 0.f});
+	void rendering_system::render_shadowmap(render_resource depth, render_resource moments)  {
+		auto& shadow_map = render_graph_->framebuffer_of({{GL_COLOR_ATTACHMENT0, moments}, {GL_DEPTH_ATTACHMENT, depth}});
+		gl.enable(GL_DEPTH_TEST);
+		gl.enable(GL_DEPTH_CLAMP);
+		gl.front_face(GL_CCW);
+		gl.cull_face(GL_BACK);
+		gl.enable(GL_CULL_FACE);
+		gl.viewport(0, 0, shadow_resolution_, shadow_resolution_);
 
 		shadow_staticmesh_program_->use();
-		shadow_staticmesh_program_->uniform("diffuse_texture", 0);
-		shadow_staticmesh_program_->uniform("specular_texture", 1);
-		shadow_staticmesh_program_->uniform("normal_texture", 2);
-		shadow_staticmesh_program_->uniform("m", false, glm::mat4{1.f});
-		shadow_staticmesh_program_->uniform("mit", false, glm::mat4{1.f});
-		for (auto& s : staticmesh_components_) {
-			auto& owner = s->owner();
-			if (!owner.component<no_occluder_component>()) {
-				auto model = owner.transform();
-				shadow_staticmesh_program_->uniform("mvp", false, shadow_projection_ * model);
-				s->draw();
-			}
+		shadow_staticmesh_program_->uniform("draw_data", 8);
+		draw_data_texture_->bind(8);
+		auto projection_view_location = shadow_staticmesh_program_->uniform_location("projection_view");
+		auto draw_offset_location = shadow_staticmesh_program_->uniform_location("draw_offset");
+
+		auto draw_static_casters = [&](size_t cascade, bool dynamic) {
+			shadow_staticmesh_program_->uniform(projection_view_location, false,
+				dynamic ? shadow_projections_[cascade] : static_shadow_regions_[cascade]);
+			draw_batches(shadow_batches_[cascade][dynamic ? 1 : 0], *shadow_staticmesh_program_, true);
+		};
+
+		// static casters are rendered into their own layer, which is reused until a static caster moves or
+		// the cascade leaves the static region. every layer that has dynamic casters starts as a copy of the
+		// part of the static layer under the cascade.
+		// a layer without dynamic casters in this and the last frame keeps its blurred result as well.
+		auto static_count = staticmesh_commands_.size();
+		auto animation_count = animation_components_.size();
+
+		// cleared texels have to read as fully lit after filtering, so they get the moments of the far plane
+		if (shadow_filter_ == shadow_filter::evsm) {
+			auto positive = std::exp(5.f);
+			auto negative = -std::exp(-5.f);
+			gl.clear_color(positive, positive * positive, negative, negative * negative);
+		} else {
+			gl.clear_color(1.f, 1.f, 0.f, 0.f);
 		}
 
-		shadow_animation_program_->use();
-		shadow_animation_program_->uniform("diffuse_texture", 0);
-		shadow_animation_program_->uniform("specular_texture", 1);
-		shadow_animation_program_->uniform("normal_texture", 2);
-		shadow_animation_program_->uniform("m", false, glm::mat4{1.f});
-		shadow_animation_program_->uniform("mit", false, glm::mat4{1.f});
-		for (auto& a : animation_components_) {
-			auto& owner = a->owner();
-			if (!owner.component<no_occluder_component>()) {
-				auto model = owner.transform();
-				shadow_animation_program_->uniform("mvp", false, shadow_projection_ * model);
-				shadow_animation_program_->uniform("pose", a->pose().size(), false, a->pose());
-				a->draw();
+		for (auto k = 0; k < shadow_cascades_; ++k) {
+			auto has_dynamic = false;
+			for (auto i = k * static_count; i < (k + 1) * static_count && !has_dynamic; ++i) {
+				has_dynamic = shadow_staticmesh_commands_[i].mesh && shadow_staticmesh_commands_[i].dynamic;
+			}
+			for (auto i = k * animation_count; i < (k + 1) * animation_count && !has_dynamic; ++i) {
+				has_dynamic = shadow_animation_commands_[i].mesh != nullptr;
 			}
-		}
 
-		shadow_map_->bind_default();
+			auto cached = !static_shadows_dirty_ && static_shadow_projections_[k] == static_shadow_regions_[k];
+			// a cascade that moved inside of its static region is still cached, but its layer is copied again
+			updated_shadow_layers_[k] = !cached || has_dynamic || dynamic_shadow_layers_[k] || moved_shadow_layers_[k];
+			dynamic_shadow_layers_[k] = has_dynamic;
+			if (cached) {
+				++shadow_cache_statistics_.hits;
+				shadow_cache_statistics_.moving_hits += moved_shadow_layers_[k] ? 1 : 0;
+			} else {
+				++shadow_cache_statistics_.misses;
+				shadow_cache_statistics_.moving_misses += moved_shadow_layers_[k] ? 1 : 0;
+			}
+			if (!updated_shadow_layers_[k]) {
+				continue;
+			}
 
-		shadow_map_->attachment(GL_COLOR_ATTACHMENT0).bind(0);
-		glGenerateMipmap(GL_TEXTURE_2D);
+			if (!cached) {
+				static_shadow_map_->bind();
+				static_shadow_map_->select_layer(GL_DEPTH_ATTACHMENT, k);
+				static_shadow_map_->select_layer(GL_COLOR_ATTACHMENT0, k);
+				gl.viewport(0, 0, static_shadow_resolution_, static_shadow_resolution_);
+				gl.clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+				draw_static_casters(k, false);
+				gl.viewport(0, 0, shadow_resolution_, shadow_resolution_);
+				static_shadow_projections_[k] = static_shadow_regions_[k];
+			}
 
-		glDisable(GL_DEPTH_TEST);
-		glDisable(GL_CULL_FACE);
-		glViewport(0, 0, width_, height_);
+			// both are snapped to the same texels, so the cascade starts at a whole texel inside of the region
+			auto& region = static_shadow_bounds_[k];
+			auto& cascade = cascade_bounds_[k];
+			auto texel_size = 2.f * cascade.w / shadow_resolution_;
+			auto x = static_cast<GLint>(std::round((cascade.x - cascade.w - region.x + region.w) / texel_size));
+			auto y = static_cast<GLint>(std::round((cascade.y - cascade.w - region.y + region.w) / texel_size));
+
+			shadow_map.bind();
+			shadow_map.select_layer(GL_COLOR_ATTACHMENT0, k);
+			static_shadow_map_->bind_read();
+			static_shadow_map_->select_layer(GL_DEPTH_ATTACHMENT, k, GL_READ_FRAMEBUFFER);
+			static_shadow_map_->select_layer(GL_COLOR_ATTACHMENT0, k, GL_READ_FRAMEBUFFER);
+			gl.blit_framebuffer(x, y, x + shadow_resolution_, y + shadow_resolution_, 0, 0, shadow_resolution_,
+				shadow_resolution_, GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+			shadow_map.bind();
+
+			if (!has_dynamic) {
+				continue;
+			}
+
+			draw_static_casters(k, true);
+
+			for (auto i = k * animation_count; i < (k + 1) * animation_count; ++i) {
+				auto& command = shadow_animation_commands_[i];
+				if (!command.mesh) {
+					continue;
+				}
+				shadow_staticmesh_program_->uniform(draw_offset_location, static_cast<int>(command.draw));
+				command.mesh->draw_skinned_depth(command.base_vertex, command.lod);
+			}
+		}
+		static_shadows_dirty_ = false;
+		gl.clear_color(0.f, 0.f, 0.f, 0.f);
+
+		shadow_map.bind_default();
+
+		gl.disable(GL_DEPTH_TEST);
+		gl.disable(GL_CULL_FACE);
+		gl.viewport(0, 0, width_, height_);
 	}
 
-	void rendering_system::apply_gaussian_blur() {
-		glViewport(0, 0, shadow_resolution_, shadow_resolution_);
-		shadow_map_blured_->bind();
-		glClear(GL_COLOR_BUFFER_BIT);
+	void rendering_system::filter_shadowmap(render_resource blurred, render_resource filtered) {
+		auto any_updated = false;
+		for (auto k = 0; k < shadow_cascades_; ++k) {
+			any_updated = any_updated || updated_shadow_layers_[k];
+		}
+		if (!any_updated) {
+			return;
+		}
+
+		if (shadow_filter_ != shadow_filter::none) {
+			// the horizontal pass also downsamples, so the vertical pass and the lighting only touch
+			// blur resolution texels
+			gl.viewport(0, 0, shadow_blur_resolution_, shadow_blur_resolution_);
 
-		shadow_blur_program_->use();
-		shadow_blur_program_->uniform("projection", false, ortho_projection_);
-		shadow_blur_program_->uniform("shadow_texture", 0);
-		shadow_blur_program_->uniform("blur_scale", glm::vec2(1.f / shadow_resolution_, 0.f));
-		shadow_map_->attachment(GL_COLOR_ATTACHMENT0).bind(0);
-		screen_quad_->draw();
+			shadow_blur_program_->use();
+			shadow_blur_program_->uniform("projection", false, ortho_projection_);
+			shadow_blur_program_->uniform("shadow_texture", 0);
 
-		shadow_map_->attachment(GL_COLOR_ATTACHMENT0).bind(0);
-		glGenerateMipmap(GL_TEXTURE_2D);
+			auto& horizontal = render_graph_->framebuffer_of({{GL_COLOR_ATTACHMENT0, blurred}});
+			auto& vertical = render_graph_->framebuffer_of({{GL_COLOR_ATTACHMENT0, filtered}});
+			for (auto k = 0; k < shadow_cascades_; ++k) {
+				if (!updated_shadow_layers_[k]) {
+					continue;
+				}
 
-		shadow_map_->bind();
-		glClear(GL_COLOR_BUFFER_BIT);
+				horizontal.bind();
+				shadow_blur_program_->uniform("layer", static_cast<float>(k));
+				shadow_blur_program_->uniform("blur_scale", glm::vec2(1.f / shadow_resolution_, 0.f));
+				shadow_moments_->bind(0);
+				screen_quad_->draw();
+
+				vertical.bind();
+				vertical.select_layer(GL_COLOR_ATTACHMENT0, k);
+				shadow_blur_program_->uniform("layer", 0.f);
+				shadow_blur_program_->uniform("blur_scale", glm::vec2(0.f, 1.f / shadow_blur_resolution_));
+				render_graph_->target(blurred).bind(0);
+				screen_quad_->draw();
+			}
 
-		shadow_blur_program_->use();
-		shadow_blur_program_->uniform("projection", false, ortho_projection_);
-		shadow_blur_program_->uniform("shadow_texture", 0);
-		shadow_blur_program_->uniform("blur_scale", glm::vec2(0.f, 1.f / shadow_resolution_));
-		shadow_map_blured_->attachment(GL_COLOR_ATTACHMENT0).bind(0);
-		screen_quad_->draw();
+			vertical.bind_default();
+			gl.viewport(0, 0, width_, height_);
+		}
 
-		shadow_map_blured_->attachment(GL_COLOR_ATTACHMENT0).bind(0);
-		glGenerateMipmap(GL_TEXTURE_2D);
+		// the whole array is mipmapped once per frame, after every updated layer is final
+		shadow_texture().bind(0);
+		gl.generate_mipmap(GL_TEXTURE_2D_ARRAY);
+	}
 
-		shadow_map_blured_->bind_default();
-		glViewport(0, 0, width_, height_);
+	const texture& rendering_system::shadow_texture() const {
+		if (shadow_filter_ == shadow_filter::none) {
+			return *shadow_moments_;
+		}
+		return *shadow_filtered_;
 	}
 
 	void rendering_system::render_skybox() const {
@@ -598,16 +1603,19 @@ namespace zombye {
 		skybox_program_->use();
 		skybox_program_->uniform("mvp", false, projection_view * glm::scale(glm::mat4{1.f}, glm::vec3{100.f}));
 		skybox_program_->uniform("sun_intensity", intensity);
+		skybox_program_->uniform("octahedral_normals", octahedral_normals_);
 		skybox_mesh_->draw();
 	}
 
-	void rendering_system::render_lights() const {
-		const static GLenum attachments[4] = {
-			GL_COLOR_ATTACHMENT0,
-			GL_COLOR_ATTACHMENT1,
-			GL_COLOR_ATTACHMENT2,
-			GL_DEPTH_ATTACHMENT
-		};
+	void rendering_system::render_lights(bool point_lights) const {
+		// the upscale pass binds the backbuffer again
+		if (dynamic_resolution_) {
+			render_graph_->framebuffer_of({{GL_COLOR_ATTACHMENT0, scene_color_}}).bind();
+			gl.viewport(0, 0, viewport_width_, viewport_height_);
+			if (!point_lights) {
+				gl.clear(GL_COLOR_BUFFER_BIT);
+			}
+		}
 
 		auto camera = camera_components_.find(active_camera_);
 		if (camera == camera_components_.end()) {
@@ -615,24 +1623,60 @@ namespace zombye {
 		}
 
 		for (auto i = 0; i < 4; ++i) {
-			g_buffer_->attachment(attachments[i]).bind(i);
+			render_graph_->target(g_buffer_[i]).bind(i);
 		}
-		shadow_map_->attachment(GL_COLOR_ATTACHMENT0).bind(4);
 
-		render_directional_lights(*camera->second);
-
-		glEnable(GL_BLEND);
-		glBlendEquation(GL_FUNC_ADD);
-		glBlendFunc(GL_ONE, GL_ONE);
+		if (!point_lights) {
+			shadow_texture().bind(4);
+			render_directional_lights(*camera->second);
+			return;
+		}
 
-		glCullFace(GL_FRONT);
-		glEnable(GL_CULL_FACE);
+		gl.enable(GL_BLEND);
+		gl.blend_equation(GL_FUNC_ADD);
+		gl.blend_func(GL_ONE, GL_ONE);
 
 		render_point_lights(*camera->second);
 
-		glDisable(GL_CULL_FACE);
+		gl.disable(GL_BLEND);
+	}
+
+	void rendering_system::render_upscale() const {
+		framebuffer::bind_default();
+		gl.viewport(0, 0, width_, height_);
 
-		glDisable(GL_BLEND);
+		// the last half texel of the viewport is not filtered with the texels outside of it
+		auto size = glm::vec2{width_, height_};
+		auto viewport = glm::vec2{static_cast<float>(viewport_width_), static_cast<float>(viewport_height_)};
+		screen_quad_program_->use();
+		screen_quad_program_->uniform("projection", false, ortho_projection_);
+		screen_quad_program_->uniform("color_texture", 0);
+		screen_quad_program_->uniform("linearize", false);
+		screen_quad_program_->uniform("texcoord_scale", viewport / size);
+		screen_quad_program_->uniform("texcoord_max", (viewport - 0.5f) / size);
+		render_graph_->target(scene_color_).bind(0);
+		screen_quad_->draw();
+	}
+
+	void rendering_system::update_resolution_scale() {
+		// the shaded pixels grow with the square of the scale. the scale follows a slow frame quickly, but only
+		// creeps back up once the frame is clearly below the target, so it does not oscillate around it.
+		auto measured = frame_timer_->poll();
+		if (measured) {
+			game_.profiler().record("gpu/frame", frame_timer_->milliseconds());
+		}
+		if (dynamic_resolution_ && measured) {
+			auto milliseconds = std::max(frame_timer_->milliseconds(), 0.001f);
+			auto ideal = resolution_scale_ * std::sqrt(target_gpu_milliseconds_ / milliseconds);
+			if (ideal < resolution_scale_) {
+				resolution_scale_ += 0.5f * (ideal - resolution_scale_);
+			} else if (ideal > 1.05f * resolution_scale_) {
+				resolution_scale_ += 0.1f * (ideal - resolution_scale_);
+			}
+			resolution_scale_ = glm::clamp(resolution_scale_, min_resolution_scale_, 1.f);
+		}
+		viewport_width_ = std::max(static_cast<GLsizei>(std::round(width_ * resolution_scale_)), GLsizei{1});
+		viewport_height_ = std::max(static_cast<GLsizei>(std::round(height_ * resolution_scale_)), GLsizei{1});
 	}
 
 	void rendering_system::render_directional_lights(const camera_component& camera) const {
@@ -643,13 +1687,21 @@ namespace zombye {
 		directional_light_program_->uniform("normal_texture", 1);
 		directional_light_program_->uniform("specular_texture", 2);
 		directional_light_program_->uniform("depth_texture", 3);
+		directional_light_program_->uniform("octahedral_normals", octahedral_normals_);
 		directional_light_program_->uniform("shadow_texture", 4);
 		directional_light_program_->uniform("projection", false, ortho_projection_);
 		directional_light_program_->uniform("inv_view_projection", false, inv_view_projection);
 		directional_light_program_->uniform("view_vector", camera.owner().position());
-		directional_light_program_->uniform("shadow_projection", false, shadow_projection_);
+		directional_light_program_->uniform("shadow_projections", shadow_projections_.size(), false, shadow_projections_);
+		directional_light_program_->uniform("cascade_splits", cascade_splits_.size(), cascade_splits_);
+		directional_light_program_->uniform("cascade_count", shadow_casting_ ? shadow_cascades_ : 0);
+		directional_light_program_->uniform("shadow_filter", shadow_filter_ == shadow_filter::evsm ? 1 : 0);
+		// 16 bit moments lose precision in the second moment and need a larger variance floor
+		directional_light_program_->uniform("min_variance", shadow_filter_ == shadow_filter::vsm ? 0.000002f : 0.00002f);
+		directional_light_program_->uniform("view", false, camera.view());
 		directional_light_program_->uniform("ambient_term", 0.1f);
-		directional_light_program_->uniform("resolution", glm::vec2(width_, height_));
+		directional_light_program_->uniform("resolution", glm::vec2(viewport_width_, viewport_height_));
+		directional_light_program_->uniform("g_buffer_size", glm::vec2(width_, height_));
 		for (auto& dl : directional_light_components_) {
 			auto sc = dl->owner().component<shadow_component>();
 			if (sc) {
@@ -667,38 +1719,29 @@ namespace zombye {
 	}
 
 	void rendering_system::render_point_lights(const camera_component& camera) const {
-		auto inv_view_projection = glm::inverse(camera.projection_view());
-
-		std::vector<light_attributes> instance_data;
-		for (auto& pl : light_components_) {
-			auto extend = calculate_point_light_extend(*pl);
-			auto scale = glm::scale(glm::mat4{1.f}, glm::vec3{2.f * pl->distance()});
-			auto rotation = glm::toMat4(camera.owner().rotation());
-			auto translation = glm::translate(glm::mat4{1.f}, pl->owner().position());
-			auto model_matrix = translation * rotation * scale;
-			instance_data.emplace_back(
-				light_attributes{
-					pl->owner().position(),
-					pl->color(),
-					pl->distance(),
-					pl->exponent()
-				}
-			);
+		if (light_culler_->visible_lights() == 0) {
+			return;
 		}
-		point_light_instance_data_->data(instance_data.size() * sizeof(light_attributes), instance_data.data());
+		light_culler_->upload();
+		light_culler_->bind(5, 6, 7);
 
 		point_light_program_->use();
 		point_light_program_->uniform("albedo_texture", 0);
 		point_light_program_->uniform("normal_texture", 1);
 		point_light_program_->uniform("specular_texture", 2);
 		point_light_program_->uniform("depth_texture", 3);
-		point_light_program_->uniform("inv_view_projection", false, inv_view_projection);
-		point_light_program_->uniform("view_projection", false, camera.projection_view());
-		point_light_program_->uniform("camera_rotation", false, glm::toMat4(camera.owner().rotation()));
+		point_light_program_->uniform("octahedral_normals", octahedral_normals_);
+		point_light_program_->uniform("light_texture", 5);
+		point_light_program_->uniform("cluster_texture", 6);
+		point_light_program_->uniform("light_index_texture", 7);
+		point_light_program_->uniform("projection", false, ortho_projection_);
+		point_light_program_->uniform("inv_view_projection", false, glm::inverse(camera.projection_view()));
+		point_light_program_->uniform("view", false, camera.view());
 		point_light_program_->uniform("view_vector", camera.owner().position());
-		point_light_program_->uniform("resolution", glm::vec2(width_, height_));
-		point_light_volume_->vao().bind();
-		glDrawElementsInstanced(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0, light_components_.size());
+		point_light_program_->uniform("resolution", glm::vec2(viewport_width_, viewport_height_));
+		point_light_program_->uniform("g_buffer_size", glm::vec2(width_, height_));
+		light_culler_->setup_program(*point_light_program_);
+		screen_quad_->draw();
 	}
 
 	float rendering_system::calculate_point_light_extend(const light_component& light) const {
@@ -716,8 +1759,41 @@ namespace zombye {
 		return extend;
 	}
 
+	void rendering_system::transform_changed(entity& entity) {
+		if (!entity.component<staticmesh_component>() || is_dynamic_caster(entity)) {
+			return;
+		}
+		if (entity.component<static_batch_component>()) {
+			invalidate_static_batches();
+		}
+		if (entity.component<no_occluder_component>()) {
+			return;
+		}
+		invalidate_static_shadows();
+	}
+
+	void rendering_system::invalidate_static_shadows() noexcept {
+		if (!static_shadows_dirty_) {
+			static_shadows_dirty_ = true;
+			++shadow_cache_statistics_.invalidations;
+		}
+	}
+
+	void rendering_system::invalidate_static_batches() noexcept {
+		static_batcher_->invalidate();
+		invalidate_static_shadows();
+	}
+
+	bool rendering_system::is_dynamic_caster(entity& entity) {
+		if (entity.component<animation_component>() || entity.component<character_physics_component>()) {
+			return true;
+		}
+		auto physics = entity.component<physics_component>();
+		return physics && !physics->is_static();
+	}
+
 	void rendering_system::clear_color(float red, float green, float blue, float alpha) {
-		glClearColor(red, green, blue, alpha);
+		gl.clear_color(red, green, blue, alpha);
 	}
 
 	void rendering_system::register_at_script_engine() {
@@ -765,10 +1841,15 @@ namespace zombye {
 
 	void rendering_system::register_component(staticmesh_component* component) {
 		staticmesh_components_.emplace_back(component);
+		invalidate_static_shadows();
 	}
 
 	void rendering_system::unregister_component(staticmesh_component* component) {
 		remove(staticmesh_components_, component);
+		if (component->batched()) {
+			invalidate_static_batches();
+		}
+		invalidate_static_shadows();
 	}
 
 	void rendering_system::register_component(shadow_component* component) {
@@ -778,4 +1859,12 @@ namespace zombye {
 	void rendering_system::unregister_component(shadow_component* component) {
 		remove(shadow_components_, component);
 	}
+
+	void rendering_system::register_component(static_batch_component*) {
+		invalidate_static_batches();
+	}
+
+	void rendering_system::unregister_component(static_batch_component*) {
+		invalidate_static_batches();
+	}
 }
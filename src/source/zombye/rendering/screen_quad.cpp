@@ -1,5 +1,6 @@
 #include <glm/glm.hpp>
 
+#include <zombye/rendering/gl_backend.hpp>
 #include <zombye/rendering/rendering_system.hpp>
 #include <zombye/rendering/screen_quad.hpp>
 #include <zombye/rendering/mesh.hpp>
@@ -22,6 +23,6 @@ namespace zombye {
 
 	void screen_quad::draw() const {
 		vao_.bind();
-		glDrawArrays(GL_TRIANGLES, 0, 6);
+		gl.draw_arrays(GL_TRIANGLES, 0, 6);
 	}
 }
@@ -1,47 +1,68 @@
 #include <vector>
 
+#include <zombye/rendering/gl_backend.hpp>
 #include <zombye/rendering/shader.hpp>
 #include <zombye/utils/logger.hpp>
 
 namespace zombye {
-    shader::shader(const std::string& name, GLenum type, const std::string& source) {
-        id_ = glCreateShader(type);
-
-        auto source_ptr = source.c_str();
-        glShaderSource(id_, 1, &source_ptr, nullptr);
-
-        glCompileShader(id_);
-
-        auto length = 0;
-        glGetShaderiv(id_, GL_INFO_LOG_LENGTH, &length);
-        if (length > 1) {
-            auto log_buffer = std::vector<char>(length);
-            glGetShaderInfoLog(id_, length, nullptr, log_buffer.data());
-            log("compilation log of " + name + ":");
-            log(std::string{log_buffer.begin(), log_buffer.end()});
-        }
-
-        auto status = 0;
-        glGetShaderiv(id_, GL_COMPILE_STATUS, &status);
-        if (!status) {
-            glDeleteShader(id_);
-            log(LOG_FATAL, "an error occured during compilation of " + name);
-        }
-    }
+    shader::shader(const std::string& name, GLenum type, const std::string& source)
+    : name_{name}, type_{type}, source_{source}, id_{0}, checked_{false} {}
 
     shader::shader(shader&& other) noexcept
-    : id_{other.id_} {
+    : name_{std::move(other.name_)}, type_{other.type_}, source_{std::move(other.source_)}, id_{other.id_},
+    checked_{other.checked_} {
         other.id_ = 0;
     }
 
     shader::~shader() noexcept {
-        glDeleteShader(id_);
+        if (id_) {
+            gl.delete_shader(id_);
+        }
     }
 
     shader& shader::operator=(shader&& other) noexcept {
+        name_ = std::move(other.name_);
+        type_ = other.type_;
+        source_ = std::move(other.source_);
         id_ = other.id_;
+        checked_ = other.checked_;
         other.id_ = 0;
 
         return *this;
     }
+
+    GLuint shader::compile() const {
+        if (id_) {
+            return id_;
+        }
+        id_ = gl.create_shader(type_);
+
+        auto source_ptr = source_.c_str();
+        gl.shader_source(id_, 1, &source_ptr, nullptr);
+
+        gl.compile_shader(id_);
+        return id_;
+    }
+
+    void shader::check() const {
+        if (checked_ || !id_) {
+            return;
+        }
+        checked_ = true;
+
+        auto length = 0;
+        gl.get_shaderiv(id_, GL_INFO_LOG_LENGTH, &length);
+        if (length > 1) {
+            auto log_buffer = std::vector<char>(length);
+            gl.get_shader_info_log(id_, length, nullptr, log_buffer.data());
+            log("compilation log of " + name_ + ":");
+            log(std::string{log_buffer.begin(), log_buffer.end()});
+        }
+
+        auto status = 0;
+        gl.get_shaderiv(id_, GL_COMPILE_STATUS, &status);
+        if (!status) {
+            log(LOG_FATAL, "an error occured during compilation of " + name_);
+        }
+    }
 }
@@ -3,12 +3,39 @@
 #include <zombye/core/game.hpp>
 #include <zombye/rendering/shader.hpp>
 #include <zombye/rendering/shader_manager.hpp>
+#include <zombye/utils/thread_pool.hpp>
 
 namespace zombye {
     shader_manager::shader_manager(game& game) noexcept
     : game_{game} { }
 
+    void shader_manager::preload(const std::vector<std::string>& names, thread_pool& pool) {
+        auto sources = std::vector<std::shared_ptr<asset>>(names.size());
+        pool.parallel_for(names.size(), 1, [this, &names, &sources](size_t begin, size_t end) {
+            for (auto i = begin; i < end; ++i) {
+                sources[i] = game_.asset_manager().load(names[i]);
+            }
+        });
+        for (auto i = size_t{0}; i < names.size(); ++i) {
+            if (sources[i]) {
+                auto& content = sources[i]->content();
+                sources_[names[i]] = std::string{content.begin(), content.end()};
+            }
+        }
+    }
+
+    void shader_manager::clear_preloaded() noexcept {
+        sources_.clear();
+    }
+
     shader_ptr shader_manager::load_new(const std::string& name, GLenum type) {
+        auto preloaded = sources_.find(name);
+        if (preloaded != sources_.end()) {
+            auto source = std::move(preloaded->second);
+            sources_.erase(preloaded);
+            return std::make_shared<const shader>(name, type, source);
+        }
+
         auto asset = game_.asset_manager().load(name);
         if (!asset) {
             return nullptr;
@@ -1,5 +1,6 @@
 #include <mesh_converter/mesh_converter.hpp>
 
+#include <zombye/rendering/gl_backend.hpp>
 #include <zombye/rendering/rendering_system.hpp>
 #include <zombye/rendering/skinned_mesh.hpp>
 #include <zombye/utils/logger.hpp>
@@ -8,36 +9,72 @@
 
 namespace zombye {
     skinned_mesh::skinned_mesh(rendering_system& rendering_system, const std::vector<char>& source, const std::string& file_name) noexcept
-    : vbo_{0, GL_STATIC_DRAW}, ibo_{0, GL_STATIC_DRAW}, parallax_mapping_{false} {
+    : vbo_{0, GL_STATIC_DRAW}, ibo_{0, GL_STATIC_DRAW}, vertex_count_{0}, index_count_{0}, index_type_{GL_UNSIGNED_INT},
+    parallax_mapping_{false} {
         auto data_ptr = source.data();
 
-        auto head = *reinterpret_cast<const header*>(data_ptr);
-        if (head.magic != 0x31424D5A) {
+        // version 2 files only differ from version 1 in the header, the size of the indices and the levels of detail
+        auto magic = *reinterpret_cast<const uint32_t*>(data_ptr);
+        auto index_size = uint32_t{sizeof(uint32_t)};
+        auto submesh_count = uint64_t{0};
+        auto lod_count = uint64_t{0};
+        auto header_size = size_t{0};
+        if (magic == 0x32424D5A) {
+            auto head = *reinterpret_cast<const devtools::packed_header*>(data_ptr);
+            if (head.version != 2 && head.version != 3) {
+                throw std::runtime_error(file_name + " has the unsupported mesh version " + std::to_string(head.version));
+            }
+            if (head.index_size != sizeof(uint16_t) && head.index_size != sizeof(uint32_t)) {
+                throw std::runtime_error(file_name + " has an invalid index size " + std::to_string(head.index_size));
+            }
+            parallax_mapping_ = head.parallax_mapping;
+            vertex_count_ = head.vertex_count;
+            index_count_ = head.index_count;
+            submesh_count = head.submesh_count;
+            index_size = head.index_size;
+            lod_count = head.version >= 3 ? head.lod_count : 0;
+            header_size = sizeof(devtools::packed_header);
+        } else if (magic == 0x31424D5A) {
+            auto head = *reinterpret_cast<const header*>(data_ptr);
+            parallax_mapping_ = head.parallax_mapping;
+            vertex_count_ = head.vertex_count;
+            index_count_ = head.index_count;
+            submesh_count = head.submesh_count;
+            header_size = sizeof(header);
+        } else {
             throw std::runtime_error(file_name + " is not an zombye mesh file");
         }
 
-        parallax_mapping_ = head.parallax_mapping;
-
-        auto vertex_size = head.vertex_count * sizeof(skinned_vertex);
-        auto index_size = head.index_count * sizeof(uint32_t);
-        auto size = sizeof(header)
+        auto vertex_size = vertex_count_ * sizeof(skinned_vertex);
+        auto size = header_size
             + vertex_size
-            + index_size
-            + head.submesh_count * sizeof(devtools::submesh);
+            + index_count_ * index_size
+            + submesh_count * sizeof(devtools::submesh)
+            + lod_count * sizeof(devtools::lod);
 
         if (size != source.size()) {
             throw std::runtime_error(file_name + " has not the apropriate size. expected size: "
                 + std::to_string(source.size()) + " calculated size: " + std::to_string(size));
         }
-        data_ptr += sizeof(header);
+        data_ptr += header_size;
+
+        auto vertices = reinterpret_cast<const skinned_vertex*>(data_ptr);
+        bounds_ = bounding_box{glm::vec3{0.f}, glm::vec3{0.f}};
+        if (vertex_count_ > 0) {
+            bounds_ = bounding_box{vertices[0].pos, vertices[0].pos};
+        }
+        for (auto i = uint64_t{0}; i < vertex_count_; ++i) {
+            bounds_.min = glm::min(bounds_.min, vertices[i].pos);
+            bounds_.max = glm::max(bounds_.max, vertices[i].pos);
+        }
 
         vbo_.data(vertex_size, data_ptr);
         data_ptr += vertex_size;
 
-        ibo_.data(index_size, data_ptr);
-        data_ptr += index_size;
+        index_type_ = upload_indices(ibo_, data_ptr, index_count_, index_size, vertex_count_);
+        data_ptr += index_count_ * index_size;
 
-        for (auto i = 0; i < head.submesh_count; ++i) {
+        for (auto i = 0; i < submesh_count; ++i) {
             submesh s;
 
             s.index_count = *reinterpret_cast<const uint64_t*>(data_ptr);
@@ -71,19 +108,58 @@ namespace zombye {
 
             submeshes_.emplace_back(s);
         }
+        lods_ = read_lods(data_ptr, lod_count, submeshes_, file_name);
+        auto uploaded_index_size = index_type_ == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+        rendering_system.record_mesh_memory(vertex_size + lods_[0].index_count * sizeof(uint32_t),
+            vertex_size + index_count_ * uploaded_index_size);
 
         vao_.bind_index_buffer(ibo_);
         rendering_system.skinnedmesh_layout().setup_layout(vao_, &vbo_);
+
+        skinned_vao_.bind_index_buffer(ibo_);
+        rendering_system.skinned_stream_layout().setup_layout(skinned_vao_, rendering_system.skinned_streams());
+
+        skinned_depth_vao_.bind_index_buffer(ibo_);
+        rendering_system.depth_layout().setup_layout(skinned_depth_vao_, rendering_system.skinned_streams());
     }
 
     void skinned_mesh::draw() const noexcept {
+        auto index_size = index_type_ == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+        auto& level = lods_[0];
         vao_.bind();
-        for (auto& sub : submeshes_) {
+        for (auto i = level.first_submesh; i < level.first_submesh + level.submesh_count; ++i) {
+            auto& sub = submeshes_[i];
             sub.diffuse->bind(0);
             sub.material->bind(1);
             sub.normal->bind(2);
-            glDrawElements(GL_TRIANGLES, sub.index_count, GL_UNSIGNED_INT,
-                reinterpret_cast<void*>(sub.offset * sizeof(unsigned int)));
+            gl.draw_elements(GL_TRIANGLES, sub.index_count, index_type_, reinterpret_cast<void*>(sub.offset * index_size));
         }
     }
+
+    void skinned_mesh::skin() const noexcept {
+        vao_.bind();
+        gl.draw_arrays(GL_POINTS, 0, vertex_count_);
+    }
+
+    void skinned_mesh::draw_skinned(GLint base_vertex, size_t lod) const noexcept {
+        auto index_size = index_type_ == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+        auto& level = lods_[lod];
+        skinned_vao_.bind();
+        for (auto i = level.first_submesh; i < level.first_submesh + level.submesh_count; ++i) {
+            auto& sub = submeshes_[i];
+            sub.diffuse->bind(0);
+            sub.material->bind(1);
+            sub.normal->bind(2);
+            gl.draw_elements_base_vertex(GL_TRIANGLES, sub.index_count, index_type_,
+                reinterpret_cast<void*>(sub.offset * index_size), base_vertex);
+        }
+    }
+
+    void skinned_mesh::draw_skinned_depth(GLint base_vertex, size_t lod) const noexcept {
+        auto index_size = index_type_ == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+        auto& level = lods_[lod];
+        skinned_depth_vao_.bind();
+        gl.draw_elements_base_vertex(GL_TRIANGLES, level.index_count, index_type_,
+            reinterpret_cast<void*>(level.first_index * index_size), base_vertex);
+    }
 }
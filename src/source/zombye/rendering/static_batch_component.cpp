@@ -0,0 +1,30 @@
+#include <zombye/ecs/entity.hpp>
+#include <zombye/core/game.hpp>
+#include <zombye/rendering/rendering_system.hpp>
+#include <zombye/rendering/static_batch_component.hpp>
+#include <zombye/scripting/scripting_system.hpp>
+
+namespace zombye {
+	static_batch_component::static_batch_component(game& game, entity& owner)
+	: reflective{game, owner} {
+		game_.rendering_system().register_component(this);
+	}
+
+	static_batch_component::~static_batch_component() noexcept {
+		game_.rendering_system().unregister_component(this);
+	}
+
+	void static_batch_component::register_at_script_engine(game& game) {
+		auto& scripting_system = game.scripting_system();
+
+		scripting_system.register_type<static_batch_component>("static_batch_component");
+
+		scripting_system.register_member_function("entity_impl",
+			"static_batch_component& add_static_batch_component()",
+			+[](entity& owner) -> static_batch_component& {
+				return owner.emplace<static_batch_component>();
+			});
+		scripting_system.register_member_function("entity_impl", "static_batch_component@ get_static_batch_component()",
+			+[](entity& owner) { return owner.component<static_batch_component>(); });
+	}
+}
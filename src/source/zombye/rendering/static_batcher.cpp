@@ -0,0 +1,186 @@
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+
+#include <glm/glm.hpp>
+
+#include <zombye/assets/asset.hpp>
+#include <zombye/assets/asset_manager.hpp>
+#include <zombye/core/game.hpp>
+#include <zombye/ecs/entity.hpp>
+#include <zombye/rendering/light_component.hpp>
+#include <zombye/rendering/no_occluder_component.hpp>
+#include <zombye/rendering/rendering_system.hpp>
+#include <zombye/rendering/static_batch_component.hpp>
+#include <zombye/rendering/static_batcher.hpp>
+#include <zombye/rendering/staticmesh_component.hpp>
+#include <zombye/utils/logger.hpp>
+
+namespace zombye {
+    namespace {
+        struct piece {
+            const mesh_data* data;
+            glm::mat4 model;
+        };
+
+        mesh_data merge(const std::vector<piece>& pieces, bool parallax_mapping) {
+            auto merged = mesh_data{};
+            merged.parallax_mapping = parallax_mapping;
+            merged.vertex_format = devtools::unorm_texcoords;
+            auto level_count = size_t{1};
+            auto vertex_count = uint64_t{0};
+            for (auto& piece : pieces) {
+                if (!(piece.data->vertex_format & devtools::unorm_texcoords)) {
+                    merged.vertex_format = 0;
+                }
+                level_count = std::max(level_count, piece.data->lods.size());
+                vertex_count += piece.data->vertex_count;
+            }
+            auto unorm_texcoords = merged.vertex_format == devtools::unorm_texcoords;
+
+            merged.vertex_count = vertex_count;
+            merged.positions.resize(vertex_count * sizeof(glm::vec3));
+            merged.attributes.resize(vertex_count);
+            auto positions = reinterpret_cast<glm::vec3*>(merged.positions.data());
+            auto base_vertices = std::vector<uint32_t>{};
+            auto v = uint64_t{0};
+            for (auto& piece : pieces) {
+                base_vertices.emplace_back(static_cast<uint32_t>(v));
+                auto& data = *piece.data;
+                auto model_it = glm::inverse(glm::transpose(glm::mat3{piece.model}));
+                auto piece_unorm = (data.vertex_format & devtools::unorm_texcoords) != 0;
+                for (auto i = uint64_t{0}; i < data.vertex_count; ++i, ++v) {
+                    positions[v] = glm::vec3{piece.model * glm::vec4{data.position(i), 1.f}};
+                    auto texcoord = glm::vec2{};
+                    auto normal = glm::vec3{};
+                    auto tangent = glm::vec3{};
+                    devtools::unpack_attributes(data.attributes[i], piece_unorm, texcoord, normal, tangent);
+                    merged.attributes[v] = devtools::pack_attributes(texcoord, glm::normalize(model_it * normal),
+                        glm::normalize(model_it * tangent), unorm_texcoords);
+                }
+            }
+
+            merged.bounds = bounding_box{positions[0], positions[0]};
+            for (auto i = uint64_t{0}; i < vertex_count; ++i) {
+                merged.bounds.min = glm::min(merged.bounds.min, positions[i]);
+                merged.bounds.max = glm::max(merged.bounds.max, positions[i]);
+            }
+
+            // the indices of every level are grouped by the textures of the submeshes they belong to
+            using texture_set = std::tuple<uint64_t, uint64_t, uint64_t>;
+            for (auto level = size_t{0}; level < level_count; ++level) {
+                auto groups = std::map<texture_set, std::vector<uint32_t>>{};
+                auto error = 0.f;
+                for (auto p = size_t{0}; p < pieces.size(); ++p) {
+                    auto& data = *pieces[p].data;
+                    auto first_submesh = size_t{0};
+                    auto submesh_count = data.submeshes.size();
+                    if (!data.lods.empty()) {
+                        auto& lod = data.lods[std::min(level, data.lods.size() - 1)];
+                        first_submesh = lod.first_submesh;
+                        submesh_count = lod.submesh_count;
+                        auto& model = pieces[p].model;
+                        auto scale = std::max(glm::length(glm::vec3{model[0]}),
+                            std::max(glm::length(glm::vec3{model[1]}), glm::length(glm::vec3{model[2]})));
+                        error = std::max(error, lod.error * scale);
+                    }
+                    for (auto s = first_submesh; s < first_submesh + submesh_count; ++s) {
+                        auto& sub = data.submeshes[s];
+                        auto& indices = groups[texture_set{sub.diffuse, sub.normal, sub.material}];
+                        for (auto i = sub.offset; i < sub.offset + sub.index_count; ++i) {
+                            indices.emplace_back(base_vertices[p] + data.indices[i]);
+                        }
+                    }
+                }
+
+                auto lod = devtools::lod{};
+                lod.first_submesh = merged.submeshes.size();
+                lod.submesh_count = groups.size();
+                lod.error = error;
+                for (auto& group : groups) {
+                    auto sub = devtools::submesh{};
+                    sub.index_count = group.second.size();
+                    sub.offset = merged.indices.size();
+                    std::tie(sub.diffuse, sub.normal, sub.material) = group.first;
+                    merged.submeshes.emplace_back(sub);
+                    merged.indices.insert(merged.indices.end(), group.second.begin(), group.second.end());
+                }
+                merged.lods.emplace_back(lod);
+            }
+            return merged;
+        }
+    }
+
+    static_batcher::static_batcher(game& game, rendering_system& rendering_system, float chunk_size) noexcept
+    : game_(game), rendering_system_(rendering_system), chunk_size_{chunk_size}, dirty_{true} {}
+
+    void static_batcher::update(const std::vector<staticmesh_component*>& components) {
+        if (!dirty_) {
+            return;
+        }
+        dirty_ = false;
+        chunks_.clear();
+
+        // every mesh file is read once, the vertices on the gpu can not be read back
+        using cell = std::tuple<int, int, int, bool>;
+        auto sources = std::unordered_map<std::string, mesh_data>{};
+        auto cells = std::map<cell, std::vector<piece>>{};
+        auto merged_components = std::vector<staticmesh_component*>{};
+        for (auto component : components) {
+            component->batched() = false;
+            auto& owner = component->owner();
+            if (!owner.component<static_batch_component>() || !component->mesh()) {
+                continue;
+            }
+            // lights draw their mesh themselves and meshes that do not occlude must not cast shadows
+            if (owner.component<light_component>() || owner.component<no_occluder_component>()) {
+                continue;
+            }
+            if (rendering_system::is_dynamic_caster(owner)) {
+                log(LOG_WARNING, "entity " + std::to_string(owner.id()) + " is not static and can not be batched");
+                continue;
+            }
+
+            auto& name = component->mesh()->name();
+            auto source = sources.find(name);
+            if (source == sources.end()) {
+                auto asset = game_.asset_manager().load(name);
+                if (!asset) {
+                    log(LOG_ERROR, "could not read " + name + " for static batching");
+                    continue;
+                }
+                source = sources.emplace(name, read_mesh(asset->content(), name)).first;
+            }
+            auto& data = source->second;
+            if (data.vertex_count == 0) {
+                continue;
+            }
+
+            auto model = owner.transform();
+            auto center = glm::floor(glm::vec3{model * glm::vec4{data.bounds.center(), 1.f}} / chunk_size_);
+            auto key = cell{static_cast<int>(center.x), static_cast<int>(center.y), static_cast<int>(center.z),
+                data.parallax_mapping};
+            cells[key].emplace_back(piece{&data, model});
+            merged_components.emplace_back(component);
+        }
+
+        for (auto& entry : cells) {
+            auto& key = entry.first;
+            auto name = "static chunk " + std::to_string(std::get<0>(key)) + " " + std::to_string(std::get<1>(key))
+                + " " + std::to_string(std::get<2>(key));
+            auto data = merge(entry.second, std::get<3>(key));
+            chunks_.emplace_back(static_chunk{std::make_shared<const mesh>(rendering_system_, data, name), lod_state{}});
+        }
+        for (auto component : merged_components) {
+            component->batched() = true;
+        }
+
+        if (!merged_components.empty()) {
+            log("static batching merged " + std::to_string(merged_components.size()) + " meshes into "
+                + std::to_string(chunks_.size()) + " chunks");
+        }
+    }
+}
@@ -1,14 +1,16 @@
 #include <zombye/core/game.hpp>
 #include <zombye/ecs/component.hpp>
+#include <zombye/ecs/entity.hpp>
 #include <zombye/rendering/mesh.hpp>
 #include <zombye/rendering/staticmesh_component.hpp>
 #include <zombye/rendering/rendering_system.hpp>
+#include <zombye/rendering/static_batch_component.hpp>
 #include <zombye/scripting/scripting_system.hpp>
 #include <zombye/utils/logger.hpp>
 
 namespace zombye {
     staticmesh_component::staticmesh_component(game& game, entity& owner, const std::string& mesh)
-    : reflective{game, owner} {
+    : reflective{game, owner}, batched_{false} {
         game_.rendering_system().register_component(this);
         load(mesh);
     }
@@ -28,6 +30,9 @@ namespace zombye {
         if (!mesh_) {
             log(LOG_FATAL, "could not load mesh from file " + mesh);
         }
+        if (batched_ || owner_.component<static_batch_component>()) {
+            rendering_system.invalidate_static_batches();
+        }
     }
 
     void staticmesh_component::register_at_script_engine(game& game) {
@@ -45,7 +50,7 @@ namespace zombye {
     }
 
     staticmesh_component::staticmesh_component(game& game, entity& owner)
-    : reflective(game, owner) {
+    : reflective(game, owner), batched_{false} {
         game_.rendering_system().register_component(this);
     }
 
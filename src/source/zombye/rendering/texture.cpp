@@ -1,68 +1,130 @@
+#include <vector>
+
+#include <zombye/rendering/gl_backend.hpp>
 #include <zombye/rendering/texture.hpp>
 
 namespace zombye {
-    texture::texture(const gli::texture2D& texture) noexcept
-    : width_{texture.dimensions().x}, height_{texture.dimensions().y}, target_{GL_TEXTURE_2D} {
-        glGenTextures(1, &id_);
-        glBindTexture(target_, id_);
-        apply_settings();
-        // adapted from http://gli.g-truc.net/0.5.1/code.html
-        if (gli::is_compressed(texture.format())) {
-            for (gli::texture2D::size_type level = 0; level < texture.levels(); ++level) {
-                glCompressedTexImage2D(target_,
-                static_cast<GLint>(level),
-                static_cast<GLenum>(gli::internal_format(texture.format())),
-                static_cast<GLsizei>(texture[level].dimensions().x),
-                static_cast<GLsizei>(texture[level].dimensions().y),
-                0,
-                static_cast<GLsizei>(texture[level].size()),
-                texture[level].data());
-            }
-        } else {
-            for (gli::texture2D::size_type level = 0; level < texture.levels(); ++level) {
-                glTexImage2D(target_,
-                static_cast<GLint>(level),
-                static_cast<GLenum>(gli::internal_format(texture.format())),
-                static_cast<GLsizei>(texture[level].dimensions().x),
-                static_cast<GLsizei>(texture[level].dimensions().y),
-                0,
-                static_cast<GLenum>(gli::external_format(texture.format())),
-                static_cast<GLenum>(gli::type_format(texture.format())),
-                texture[level].data());
+    namespace {
+        struct gl_texture_format {
+            GLenum internal_format;
+            GLenum format;
+            GLenum type;
+        };
+
+        bool is_compressed(dds_format format) noexcept {
+            return format <= dds_format::bc7;
+        }
+
+        gl_texture_format texture_format(dds_format format) noexcept {
+            switch (format) {
+                case dds_format::bc1_rgb:
+                    return {GL_COMPRESSED_RGB_S3TC_DXT1_EXT, GL_NONE, GL_NONE};
+                case dds_format::bc1_rgba:
+                    return {GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, GL_NONE, GL_NONE};
+                case dds_format::bc2:
+                    return {GL_COMPRESSED_RGBA_S3TC_DXT3_EXT, GL_NONE, GL_NONE};
+                case dds_format::bc3:
+                    return {GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, GL_NONE, GL_NONE};
+                case dds_format::bc4:
+                    return {GL_COMPRESSED_RED_RGTC1, GL_NONE, GL_NONE};
+                case dds_format::bc5:
+                    return {GL_COMPRESSED_RG_RGTC2, GL_NONE, GL_NONE};
+                case dds_format::bc7:
+                    return {GL_COMPRESSED_RGBA_BPTC_UNORM_ARB, GL_NONE, GL_NONE};
+                case dds_format::rgba8:
+                    return {GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE};
+                case dds_format::bgra8:
+                    return {GL_RGBA8, GL_BGRA, GL_UNSIGNED_BYTE};
+                case dds_format::rgb8:
+                    return {GL_RGB8, GL_RGB, GL_UNSIGNED_BYTE};
+                default:
+                    return {GL_RGB8, GL_BGR, GL_UNSIGNED_BYTE};
             }
         }
     }
 
+    texture::texture(const dds_image& image, size_t first_level) noexcept
+    : width_{image.dimensions().x}, height_{image.dimensions().y}, layers_{1}, target_{GL_TEXTURE_2D} {
+        gl.gen_textures(1, &id_);
+        gl.bind_texture(target_, id_);
+        apply_settings();
+        if (first_level > 0) {
+            gl.tex_parameteri(target_, GL_TEXTURE_BASE_LEVEL, static_cast<GLint>(first_level));
+        }
+        gl.tex_parameteri(target_, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(image.levels.size() - 1));
+        for (auto level = first_level; level < image.levels.size(); ++level) {
+            auto& data = image.levels[level];
+            upload_level(image.format, level, data.dimensions, data.data, data.size);
+        }
+    }
+
+    texture::texture(dds_format format, glm::uvec2 dimensions, size_t levels, size_t layers, size_t first_level) noexcept
+    : width_{dimensions.x}, height_{dimensions.y}, layers_{layers}, target_{GL_TEXTURE_2D_ARRAY} {
+        gl.gen_textures(1, &id_);
+        gl.bind_texture(target_, id_);
+        apply_settings();
+        gl.tex_parameteri(target_, GL_TEXTURE_BASE_LEVEL, static_cast<GLint>(first_level));
+        gl.tex_parameteri(target_, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(levels - 1));
+        for (auto level = first_level; level < levels; ++level) {
+            allocate_level(format, level, glm::max(dimensions >> glm::uvec2{static_cast<unsigned>(level)}, glm::uvec2{1}));
+        }
+    }
+
     texture::texture(GLenum target, GLint internal_format, GLsizei width, GLsizei height, GLenum format, GLenum type, const GLvoid* data) noexcept
-    : width_{static_cast<size_t>(width)}, height_{static_cast<size_t>(height)}, target_{target} {
-        glGenTextures(1, &id_);
-        glBindTexture(target_, id_);
-        glTexImage2D(target_, 0, internal_format, width_, height_, 0, format, type, data);
-        glTexParameteri(target_, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(target_, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(target_, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(target_, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    : width_{static_cast<size_t>(width)}, height_{static_cast<size_t>(height)}, layers_{1}, target_{target} {
+        gl.gen_textures(1, &id_);
+        gl.bind_texture(target_, id_);
+        gl.tex_image_2d(target_, 0, internal_format, width_, height_, 0, format, type, data);
+        gl.tex_parameteri(target_, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        gl.tex_parameteri(target_, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        gl.tex_parameteri(target_, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        gl.tex_parameteri(target_, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     }
 
     texture::texture(GLint internal_format, GLsizei width, GLsizei height, GLenum format, GLenum type, const GLvoid* data) noexcept
-    : target_{GL_TEXTURE_CUBE_MAP}, width_{static_cast<size_t>(width)}, height_{static_cast<size_t>(height)} {
-        glGenTextures(1, &id_);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, id_);
+    : target_{GL_TEXTURE_CUBE_MAP}, width_{static_cast<size_t>(width)}, height_{static_cast<size_t>(height)}, layers_{6} {
+        gl.gen_textures(1, &id_);
+        gl.bind_texture(GL_TEXTURE_CUBE_MAP, id_);
         for (auto i = 0; i < 6; ++i) {
-            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, internal_format, width_, height_, 0, format, type, data);
+            gl.tex_image_2d(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, internal_format, width_, height_, 0, format, type, data);
         }
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        gl.tex_parameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        gl.tex_parameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        gl.tex_parameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        gl.tex_parameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+
+    texture::texture(GLenum target, GLint internal_format, GLsizei width, GLsizei height, GLsizei layers, GLenum format, GLenum type, const GLvoid* data) noexcept
+    : width_{static_cast<size_t>(width)}, height_{static_cast<size_t>(height)}, layers_{static_cast<size_t>(layers)}, target_{target} {
+        gl.gen_textures(1, &id_);
+        gl.bind_texture(target_, id_);
+        gl.tex_image_3d(target_, 0, internal_format, width_, height_, layers_, 0, format, type, data);
+        gl.tex_parameteri(target_, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        gl.tex_parameteri(target_, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        gl.tex_parameteri(target_, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        gl.tex_parameteri(target_, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+
+    texture::texture(GLenum internal_format, const texture_buffer& buffer) noexcept
+    : width_{0}, height_{1}, layers_{1}, target_{GL_TEXTURE_BUFFER} {
+        gl.gen_textures(1, &id_);
+        gl.bind_texture(target_, id_);
+        gl.tex_buffer(target_, internal_format, buffer.id_);
+    }
+
+    texture::texture(GLenum internal_format, const texture_stream_buffer& buffer) noexcept
+    : width_{0}, height_{1}, layers_{1}, target_{GL_TEXTURE_BUFFER} {
+        gl.gen_textures(1, &id_);
+        gl.bind_texture(target_, id_);
+        gl.tex_buffer(target_, internal_format, buffer.id_);
     }
 
     texture::~texture() {
-        glDeleteTextures(1, &id_);
+        gl.delete_textures(1, &id_);
     }
 
     texture::texture(texture&& rhs) noexcept
-    : id_{rhs.id_}, target_{rhs.target_}, width_{rhs.width_}, height_{rhs.height_} {
+    : id_{rhs.id_}, target_{rhs.target_}, width_{rhs.width_}, height_{rhs.height_}, layers_{rhs.layers_} {
         rhs.id_ = 0;
     }
 
@@ -71,20 +133,89 @@ namespace zombye {
         target_ = rhs.target_;
         width_ = rhs.width_;
         height_ = rhs.height_;
+        layers_ = rhs.layers_;
         rhs.id_ = 0;
         return *this;
     }
 
     void texture::bind(uint32_t unit) const noexcept {
-        glActiveTexture(GL_TEXTURE0 + unit);
-        glBindTexture(target_, id_);
+        gl.active_texture(GL_TEXTURE0 + unit);
+        gl.bind_texture(target_, id_);
+    }
+
+    void texture::upload_level(dds_format format, size_t level, glm::uvec2 dimensions, const void* data,
+    size_t size) noexcept {
+        auto gl_format = texture_format(format);
+        gl.bind_texture(target_, id_);
+        if (is_compressed(format)) {
+            gl.compressed_tex_image_2d(target_, level, gl_format.internal_format, dimensions.x, dimensions.y, 0, size,
+                data);
+        } else {
+            gl.pixel_storei(GL_UNPACK_ALIGNMENT, 1);
+            gl.tex_image_2d(target_, level, gl_format.internal_format, dimensions.x, dimensions.y, 0, gl_format.format,
+                gl_format.type, data);
+        }
+    }
+
+    void texture::upload_layer(dds_format format, size_t level, size_t layer, glm::uvec2 dimensions, const void* data,
+    size_t size) noexcept {
+        auto gl_format = texture_format(format);
+        gl.bind_texture(target_, id_);
+        if (is_compressed(format)) {
+            gl.compressed_tex_sub_image_3d(target_, level, 0, 0, layer, dimensions.x, dimensions.y, 1,
+                gl_format.internal_format, size, data);
+        } else {
+            gl.pixel_storei(GL_UNPACK_ALIGNMENT, 1);
+            gl.tex_sub_image_3d(target_, level, 0, 0, layer, dimensions.x, dimensions.y, 1, gl_format.format,
+                gl_format.type, data);
+        }
+    }
+
+    void texture::allocate_level(dds_format format, size_t level, glm::uvec2 dimensions) noexcept {
+        if (target_ != GL_TEXTURE_2D_ARRAY) {
+            auto size = dimensions.x > 0 ? detail::dds_level_size(format, dimensions) : 0;
+            if (is_compressed(format) && size > 0) {
+                // compressed levels can only be specified together with their data
+                auto zeros = std::vector<char>(size);
+                upload_level(format, level, dimensions, zeros.data(), size);
+            } else {
+                upload_level(format, level, dimensions, nullptr, size);
+            }
+            return;
+        }
+        auto gl_format = texture_format(format);
+        auto layers = dimensions.x > 0 ? layers_ : 0;
+        gl.bind_texture(target_, id_);
+        if (is_compressed(format)) {
+            auto size = dimensions.x > 0 ? layers * detail::dds_level_size(format, dimensions) : 0;
+            gl.compressed_tex_image_3d(target_, level, gl_format.internal_format, dimensions.x, dimensions.y, layers, 0,
+                size, nullptr);
+        } else {
+            gl.tex_image_3d(target_, level, gl_format.internal_format, dimensions.x, dimensions.y, layers, 0,
+                gl_format.format, gl_format.type, nullptr);
+        }
+    }
+
+    void texture::base_level(size_t level) noexcept {
+        gl.bind_texture(target_, id_);
+        gl.tex_parameteri(target_, GL_TEXTURE_BASE_LEVEL, static_cast<GLint>(level));
+    }
+
+    void texture::view(GLenum internal_format, const texture_stream_buffer& buffer, intptr_t offset,
+    size_t size) noexcept {
+        gl.bind_texture(target_, id_);
+        if (gl_caps().texture_buffer_range) {
+            gl.tex_buffer_range(target_, internal_format, buffer.id_, offset, size);
+        } else {
+            gl.tex_buffer(target_, internal_format, buffer.id_);
+        }
     }
 
     void texture::apply_settings() const noexcept {
-        glTexParameteri(target_, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(target_, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        gl.tex_parameteri(target_, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        gl.tex_parameteri(target_, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
         auto max_aniso = 0.f;
-        glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &max_aniso);
-        glTexParameteri(target_, GL_TEXTURE_MAX_ANISOTROPY_EXT, max_aniso);
+        gl.get_floatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &max_aniso);
+        gl.tex_parameteri(target_, GL_TEXTURE_MAX_ANISOTROPY_EXT, max_aniso);
     }
 }
@@ -0,0 +1,91 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include <zombye/assets/asset.hpp>
+#include <zombye/assets/asset_manager.hpp>
+#include <zombye/core/game.hpp>
+#include <zombye/rendering/texture.hpp>
+#include <zombye/rendering/texture_array_manager.hpp>
+#include <zombye/rendering/texture_manager.hpp>
+#include <zombye/utils/logger.hpp>
+
+namespace zombye {
+    texture_layer::texture_layer(std::shared_ptr<texture_array_page> page, size_t layer) noexcept
+    : page_{std::move(page)}, layer_{layer} { }
+
+    texture_layer::~texture_layer() noexcept {
+        (*page_->names)[layer_].clear();
+    }
+
+    texture_array_manager::texture_array_manager(game& game, zombye::texture_manager& texture_manager) noexcept
+    : game_{game}, texture_manager_(texture_manager), layers_per_array_{16} { }
+
+    void texture_array_manager::layers_per_array(size_t layers) noexcept {
+        layers_per_array_ = std::max(layers, size_t{1});
+    }
+
+    size_t texture_array_manager::array_count() noexcept {
+        pages_.erase(std::remove_if(pages_.begin(), pages_.end(), [](const auto& page) {
+            return page.expired();
+        }), pages_.end());
+        return pages_.size();
+    }
+
+    texture_layer_ptr texture_array_manager::load_new(const std::string& name) {
+        auto asset = game_.asset_manager().load(name);
+        if (!asset) {
+            return nullptr;
+        }
+
+        auto image = dds_image{};
+        try {
+            image = read_dds(asset->content().data(), asset->content().size(), name);
+        } catch (const std::runtime_error& error) {
+            log(LOG_ERROR, error.what());
+            return nullptr;
+        }
+
+        // the first array of the same kind with a free layer takes the texture
+        auto page = std::shared_ptr<texture_array_page>{};
+        auto layer = size_t{0};
+        array_count();
+        for (auto& candidate : pages_) {
+            auto p = candidate.lock();
+            if (p->format != image.format || p->dimensions != image.dimensions() || p->levels != image.levels.size()) {
+                continue;
+            }
+            auto free = std::find(p->names->begin(), p->names->end(), std::string{});
+            if (free != p->names->end()) {
+                page = p;
+                layer = free - p->names->begin();
+                break;
+            }
+        }
+
+        auto streamer = texture_manager_.streamer();
+        if (!page) {
+            auto coarse_level = texture_manager_.coarse_level(image);
+            page = std::make_shared<texture_array_page>(texture_array_page{
+                std::make_shared<texture>(image.format, image.dimensions(), image.levels.size(), layers_per_array_,
+                    coarse_level),
+                std::make_shared<std::vector<std::string>>(layers_per_array_),
+                image.format, image.dimensions(), image.levels.size()});
+            if (coarse_level > 0) {
+                streamer->add_array(page->array, page->names, image.format, image.levels, coarse_level);
+            }
+            pages_.emplace_back(page);
+        }
+
+        // the layer gets every level the other layers of the array have on the gpu
+        (*page->names)[layer] = name;
+        auto first_level = streamer ? streamer->resident_level(page->array.get()) : size_t{0};
+        for (auto level = first_level; level < image.levels.size(); ++level) {
+            auto& data = image.levels[level];
+            page->array->upload_layer(image.format, level, layer, data.dimensions, data.data, data.size);
+        }
+        if (streamer) {
+            streamer->layers_changed(page->array.get());
+        }
+        return std::make_shared<const texture_layer>(page, layer);
+    }
+}
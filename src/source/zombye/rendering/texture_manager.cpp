@@ -1,13 +1,35 @@
+#include <algorithm>
+#include <stdexcept>
+
 #include <zombye/assets/asset.hpp>
 #include <zombye/assets/asset_manager.hpp>
 #include <zombye/core/game.hpp>
 #include <zombye/rendering/texture.hpp>
 #include <zombye/rendering/texture_manager.hpp>
 #include <zombye/utils/load_dds.hpp>
+#include <zombye/utils/logger.hpp>
 
 namespace zombye {
     texture_manager::texture_manager(game& game) noexcept
-    : game_{game} { }
+    : game_{game}, streaming_size_{0} { }
+
+    texture_streamer& texture_manager::enable_streaming(uint64_t budget_bytes, uint64_t upload_bytes_per_frame,
+    size_t streaming_size) {
+        streamer_ = std::make_unique<texture_streamer>(game_.asset_manager(), budget_bytes, upload_bytes_per_frame);
+        streaming_size_ = std::max(streaming_size, size_t{1});
+        return *streamer_;
+    }
+
+    size_t texture_manager::coarse_level(const dds_image& image) const noexcept {
+        auto level = size_t{0};
+        if (streamer_) {
+            while (level + 1 < image.levels.size()
+            && std::max(image.levels[level].dimensions.x, image.levels[level].dimensions.y) > streaming_size_) {
+                ++level;
+            }
+        }
+        return level;
+    }
 
     texture_ptr texture_manager::load_new(const std::string& name) {
         auto asset = game_.asset_manager().load(name);
@@ -15,11 +37,23 @@ namespace zombye {
             return nullptr;
         }
 
-        auto texture = gli::texture2D{gli::load_dds(asset->content())};
-        if (texture.empty()) {
+        // the levels are uploaded straight from the content of the asset
+        auto image = dds_image{};
+        try {
+            image = read_dds(asset->content().data(), asset->content().size(), name);
+        } catch (const std::runtime_error& error) {
+            log(LOG_ERROR, error.what());
             return nullptr;
         }
 
-        return std::make_shared<const zombye::texture>(texture);
+        // textures without finer levels than the coarse ones are not streamed
+        auto coarse_level = this->coarse_level(image);
+        if (coarse_level == 0) {
+            return std::make_shared<const zombye::texture>(image);
+        }
+
+        auto streamed = std::make_shared<zombye::texture>(image, coarse_level);
+        streamer_->add(streamed, name, image, coarse_level);
+        return streamed;
     }
 }
@@ -0,0 +1,352 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include <zombye/assets/asset.hpp>
+#include <zombye/assets/asset_manager.hpp>
+#include <zombye/rendering/texture.hpp>
+#include <zombye/rendering/texture_streamer.hpp>
+#include <zombye/utils/logger.hpp>
+
+namespace zombye {
+    texture_streamer::texture_streamer(asset_manager& asset_manager, uint64_t budget_bytes,
+    uint64_t upload_bytes_per_frame)
+    : asset_manager_(asset_manager), budget_bytes_{budget_bytes}, upload_bytes_per_frame_{upload_bytes_per_frame},
+    max_pending_loads_{4}, generation_{0}, frame_{1}, resident_bytes_{0}, pending_levels_{0}, pending_bytes_{0},
+    pending_loads_{0}, stop_{false} {
+        loader_ = std::thread{[this]() {
+            load();
+        }};
+    }
+
+    texture_streamer::~texture_streamer() {
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            stop_ = true;
+        }
+        condition_.notify_one();
+        loader_.join();
+    }
+
+    void texture_streamer::add(const std::shared_ptr<texture>& texture, const std::string& name,
+    const dds_image& image, size_t coarse_level) {
+        auto entry = texture_streamer::entry{};
+        entry.names = std::make_shared<const std::vector<std::string>>(1, name);
+        entry.format = image.format;
+        for (auto& level : image.levels) {
+            entry.levels.emplace_back(texture_streamer::level{level.dimensions, level.size});
+        }
+        entry.array = false;
+        entry.coarse_level = coarse_level;
+        insert(texture, std::move(entry));
+    }
+
+    void texture_streamer::add_array(const std::shared_ptr<texture>& texture,
+    std::shared_ptr<const std::vector<std::string>> names, dds_format format, const std::vector<dds_level>& levels,
+    size_t coarse_level) {
+        auto entry = texture_streamer::entry{};
+        entry.format = format;
+        for (auto& level : levels) {
+            entry.levels.emplace_back(texture_streamer::level{level.dimensions, names->size() * level.size});
+        }
+        entry.names = std::move(names);
+        entry.array = true;
+        entry.coarse_level = coarse_level;
+        insert(texture, std::move(entry));
+    }
+
+    void texture_streamer::layers_changed(const texture* texture) noexcept {
+        auto found = entries_.find(texture);
+        if (found != entries_.end() && found->second.loading) {
+            found->second.stale = true;
+        }
+    }
+
+    size_t texture_streamer::resident_level(const texture* texture) const noexcept {
+        auto found = entries_.find(texture);
+        return found == entries_.end() ? 0 : found->second.resident_level;
+    }
+
+    void texture_streamer::request(const texture* texture, float pixels) noexcept {
+        auto found = entries_.find(texture);
+        if (found == entries_.end()) {
+            return;
+        }
+        auto& entry = found->second;
+        auto& finest = entry.levels.front().dimensions;
+        auto size = static_cast<float>(std::max(finest.x, finest.y));
+        auto level = size_t{0};
+        if (pixels < size) {
+            level = static_cast<size_t>(std::log2(size / std::max(pixels, 1.f)));
+        }
+        level = std::min(level, entry.coarse_level);
+        if (entry.last_used != frame_) {
+            entry.last_used = frame_;
+            entry.requested_level = level;
+        } else {
+            entry.requested_level = std::min(entry.requested_level, level);
+        }
+    }
+
+    void texture_streamer::update() {
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            for (auto& result : results_) {
+                ready_.emplace_back(std::move(result));
+            }
+            results_.clear();
+        }
+
+        for (auto entry = entries_.begin(); entry != entries_.end();) {
+            if (entry->second.texture.expired()) {
+                resident_bytes_ -= resident_size(entry->second);
+                entry = entries_.erase(entry);
+            } else {
+                ++entry;
+            }
+        }
+
+        // levels of one result are uploaded from coarse to fine, each one extending the resident range
+        auto uploaded = uint64_t{0};
+        while (!ready_.empty() && (uploaded == 0 || uploaded < upload_bytes_per_frame_)) {
+            auto& result = ready_.front();
+            auto found = entries_.find(result.key);
+            if (result.levels.empty() || found == entries_.end() || found->second.generation != result.generation
+            || found->second.stale || result.levels.front().level + 1 != found->second.resident_level) {
+                finish(result);
+                ready_.pop_front();
+                continue;
+            }
+
+            auto& entry = found->second;
+            auto& data = result.levels.front();
+            upload(entry, *entry.texture.lock(), data);
+
+            auto size = entry.levels[data.level].size;
+            resident_bytes_ += size;
+            uploaded += size;
+            pending_bytes_ -= std::min(size, result.bytes);
+            result.bytes -= std::min(size, result.bytes);
+            --pending_levels_;
+            --result.level_count;
+            ++statistics_.uploaded_levels;
+            result.levels.pop_front();
+            if (result.levels.empty()) {
+                finish(result);
+                ready_.pop_front();
+            }
+        }
+
+        evict(budget_bytes_);
+
+        // the textures missing the most levels are read first
+        auto candidates = std::vector<std::pair<const texture*, entry*>>{};
+        for (auto& entry : entries_) {
+            auto& e = entry.second;
+            if (e.last_used == frame_ && !e.loading && e.requested_level < e.resident_level) {
+                candidates.emplace_back(entry.first, &e);
+            }
+        }
+        std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) {
+            return a.second->resident_level - a.second->requested_level
+                > b.second->resident_level - b.second->requested_level;
+        });
+
+        for (auto& candidate : candidates) {
+            if (pending_loads_ >= max_pending_loads_) {
+                break;
+            }
+            auto& entry = *candidate.second;
+            auto first_level = entry.requested_level;
+            auto bytes = uint64_t{0};
+            for (auto level = first_level; level < entry.resident_level; ++level) {
+                bytes += entry.levels[level].size;
+            }
+            // the finest levels are left out until the request fits
+            while (first_level < entry.resident_level) {
+                auto reserved = pending_bytes_ + bytes;
+                if (reserved <= budget_bytes_ && evict(budget_bytes_ - reserved)) {
+                    break;
+                }
+                bytes -= entry.levels[first_level].size;
+                ++first_level;
+            }
+            if (first_level == entry.resident_level) {
+                continue;
+            }
+
+            entry.loading = true;
+            ++pending_loads_;
+            pending_levels_ += entry.resident_level - first_level;
+            pending_bytes_ += bytes;
+            {
+                std::lock_guard<std::mutex> lock{mutex_};
+                requests_.emplace_back(load_request{candidate.first, entry.generation, *entry.names, first_level,
+                    entry.resident_level, bytes});
+            }
+            condition_.notify_one();
+        }
+
+        ++frame_;
+    }
+
+    texture_streaming_statistics texture_streamer::statistics() const noexcept {
+        auto statistics = statistics_;
+        statistics.textures = entries_.size();
+        statistics.resident_bytes = resident_bytes_;
+        statistics.budget_bytes = budget_bytes_;
+        statistics.pending_uploads = pending_levels_;
+        return statistics;
+    }
+
+    bool texture_streamer::evict(uint64_t target) {
+        if (resident_bytes_ <= target) {
+            return true;
+        }
+
+        auto evictable = [this](const entry& entry) {
+            return !entry.loading && entry.resident_level < entry.coarse_level
+                && (entry.last_used != frame_ || entry.resident_level < entry.requested_level);
+        };
+        auto candidates = std::vector<entry*>{};
+        for (auto& entry : entries_) {
+            if (evictable(entry.second)) {
+                candidates.emplace_back(&entry.second);
+            }
+        }
+        std::sort(candidates.begin(), candidates.end(), [](const entry* a, const entry* b) {
+            return a->last_used < b->last_used;
+        });
+
+        for (auto entry : candidates) {
+            auto texture = entry->texture.lock();
+            while (resident_bytes_ > target && evictable(*entry)) {
+                // the level is no longer sampled before its storage is freed
+                auto level = entry->resident_level;
+                texture->base_level(level + 1);
+                texture->allocate_level(entry->format, level, glm::uvec2{0});
+                entry->resident_level = level + 1;
+                resident_bytes_ -= entry->levels[level].size;
+                ++statistics_.evicted_levels;
+            }
+            if (resident_bytes_ <= target) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void texture_streamer::finish(load_result& result) {
+        pending_bytes_ -= std::min(result.bytes, pending_bytes_);
+        pending_levels_ -= std::min<uint64_t>(result.level_count, pending_levels_);
+        --pending_loads_;
+        auto found = entries_.find(result.key);
+        if (found == entries_.end() || found->second.generation != result.generation) {
+            return;
+        }
+        auto& entry = found->second;
+        entry.loading = false;
+        entry.stale = false;
+        // files that can not be read again keep the levels they have
+        if (result.level_count > 0 && result.levels.empty()) {
+            entry.coarse_level = entry.resident_level;
+        }
+    }
+
+    void texture_streamer::load() {
+        while (true) {
+            auto request = load_request{};
+            {
+                std::unique_lock<std::mutex> lock{mutex_};
+                condition_.wait(lock, [this]() {
+                    return stop_ || !requests_.empty();
+                });
+                if (stop_) {
+                    return;
+                }
+                request = std::move(requests_.front());
+                requests_.pop_front();
+            }
+
+            auto result = load_result{request.key, request.generation, {}, {}, request.bytes,
+                request.last_level - request.first_level};
+            auto levels = std::vector<level_data>(request.last_level - request.first_level);
+            try {
+                for (auto layer = size_t{0}; layer < request.names.size(); ++layer) {
+                    auto& name = request.names[layer];
+                    for (auto& level : levels) {
+                        level.layers.emplace_back(dds_level{glm::uvec2{0}, nullptr, 0});
+                    }
+                    if (name.empty()) {
+                        continue;
+                    }
+                    auto file = asset_manager_.load(name);
+                    if (!file) {
+                        throw std::runtime_error("could not read " + name);
+                    }
+                    auto image = read_dds(file->content().data(), file->content().size(), name);
+                    if (image.levels.size() < request.last_level) {
+                        throw std::runtime_error(name + " has less levels than when it was loaded");
+                    }
+                    for (auto level = request.first_level; level < request.last_level; ++level) {
+                        levels[level - request.first_level].layers.back() = image.levels[level];
+                    }
+                    result.files.emplace_back(std::move(file));
+                }
+                for (auto level = request.last_level; level-- > request.first_level;) {
+                    levels[level - request.first_level].level = level;
+                    result.levels.emplace_back(std::move(levels[level - request.first_level]));
+                }
+            } catch (const std::runtime_error& error) {
+                log(LOG_WARNING, std::string{"could not stream texture levels: "} + error.what());
+            }
+
+            std::lock_guard<std::mutex> lock{mutex_};
+            results_.emplace_back(std::move(result));
+        }
+    }
+
+    void texture_streamer::insert(const std::shared_ptr<texture>& texture, entry entry) {
+        // a new texture may reuse the address of an expired one
+        auto found = entries_.find(texture.get());
+        if (found != entries_.end()) {
+            resident_bytes_ -= resident_size(found->second);
+            entries_.erase(found);
+        }
+        entry.texture = texture;
+        entry.generation = ++generation_;
+        entry.resident_level = entry.coarse_level;
+        entry.requested_level = entry.coarse_level;
+        entry.last_used = 0;
+        entry.loading = false;
+        entry.stale = false;
+        resident_bytes_ += resident_size(entry);
+        entries_.emplace(texture.get(), std::move(entry));
+    }
+
+    void texture_streamer::upload(entry& entry, texture& texture, const level_data& data) {
+        auto& dimensions = entry.levels[data.level].dimensions;
+        if (entry.array) {
+            texture.allocate_level(entry.format, data.level, dimensions);
+            for (auto layer = size_t{0}; layer < data.layers.size(); ++layer) {
+                auto& source = data.layers[layer];
+                if (source.data) {
+                    texture.upload_layer(entry.format, data.level, layer, dimensions, source.data, source.size);
+                }
+            }
+        } else {
+            auto& source = data.layers.front();
+            texture.upload_level(entry.format, data.level, dimensions, source.data, source.size);
+        }
+        texture.base_level(data.level);
+        entry.resident_level = data.level;
+    }
+
+    uint64_t texture_streamer::resident_size(const entry& entry) noexcept {
+        auto size = uint64_t{0};
+        for (auto level = entry.resident_level; level < entry.levels.size(); ++level) {
+            size += entry.levels[level].size;
+        }
+        return size;
+    }
+}
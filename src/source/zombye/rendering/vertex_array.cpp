@@ -1,8 +1,9 @@
+#include <zombye/rendering/gl_backend.hpp>
 #include <zombye/rendering/vertex_array.hpp>
 
 namespace zombye {
     vertex_array::vertex_array() noexcept {
-        glGenVertexArrays(1, &id_);
+        gl.gen_vertex_arrays(1, &id_);
         bind();
     }
 
@@ -12,7 +13,7 @@ namespace zombye {
     }
 
     vertex_array::~vertex_array() noexcept {
-        glDeleteVertexArrays(1, &id_);
+        gl.delete_vertex_arrays(1, &id_);
     }
 
     vertex_array& vertex_array::operator=(vertex_array&& other) noexcept {
@@ -23,7 +24,7 @@ namespace zombye {
     }
 
     void vertex_array::bind() const noexcept {
-        glBindVertexArray(id_);
+        gl.bind_vertex_array(id_);
     }
 
     void vertex_array::bind_index_buffer(const index_buffer& buffer) {
@@ -31,18 +32,16 @@ namespace zombye {
         buffer.bind();
     }
 
-    void vertex_array::bind_vertex_attribute(const vertex_buffer& buffer, uint32_t index, int32_t size, GLenum type,
-    bool normalized, size_t stride, intptr_t offset) const noexcept {
-        buffer.bind();
-        glEnableVertexAttribArray(index);
-        glVertexAttribPointer(index, size, type, normalized, stride, reinterpret_cast<GLvoid*>(offset));
+    void vertex_array::bind_vertex_attribute(uint32_t index, int32_t size, GLenum type, bool normalized, size_t stride,
+    intptr_t offset) const noexcept {
+        gl.enable_vertex_attrib_array(index);
+        gl.vertex_attrib_pointer(index, size, type, normalized, stride, reinterpret_cast<GLvoid*>(offset));
     }
 
-    void vertex_array::bind_vertex_attributei(const vertex_buffer& buffer, uint32_t index, int32_t size, GLenum type,
-    size_t stride, intptr_t offset) const noexcept {
-        buffer.bind();
-        glEnableVertexAttribArray(index);
-        glVertexAttribIPointer(index, size, type, stride, reinterpret_cast<GLvoid*>(offset));
+    void vertex_array::bind_vertex_attributei(uint32_t index, int32_t size, GLenum type, size_t stride,
+    intptr_t offset) const noexcept {
+        gl.enable_vertex_attrib_array(index);
+        gl.vertex_attrib_i_pointer(index, size, type, stride, reinterpret_cast<GLvoid*>(offset));
     }
 
 }
@@ -1,3 +1,4 @@
+#include <zombye/rendering/gl_backend.hpp>
 #include <zombye/rendering/program.hpp>
 #include <zombye/rendering/vertex_array.hpp>
 #include <zombye/rendering/vertex_layout.hpp>
@@ -22,13 +23,13 @@ namespace zombye {
             for (auto j = 0; j < attribute.factor; ++j) {
                 buffers[attribute.index]->bind();
                 if (attribute.type == GL_INT) {
-                    vertex_array.bind_vertex_attributei(*(buffers[attribute.index]), i, attribute.size, attribute.type,
+                    vertex_array.bind_vertex_attributei(i, attribute.size, attribute.type,
                         attribute.stride, attribute.offset + j * attribute.component_offset);
                 } else {
-                    vertex_array.bind_vertex_attribute(*(buffers[attribute.index]), i, attribute.size, attribute.type,
+                    vertex_array.bind_vertex_attribute(i, attribute.size, attribute.type,
                         attribute.normalized, attribute.stride, attribute.offset + j * attribute.component_offset);
                 }
-                glVertexAttribDivisor(i, attribute.divisor);
+                gl.vertex_attrib_divisor(i, attribute.divisor);
                 ++i;
             }
         }
@@ -41,13 +42,13 @@ namespace zombye {
             buffers[attribute.index].bind();
             for (auto j = 0; j < attribute.factor; ++j) {
                 if (attribute.type == GL_INT) {
-                    vertex_array.bind_vertex_attributei(buffers[attribute.index], i, attribute.size, attribute.type,
+                    vertex_array.bind_vertex_attributei(i, attribute.size, attribute.type,
                         attribute.stride, attribute.offset + j * attribute.component_offset);
                 } else {
-                    vertex_array.bind_vertex_attribute(buffers[attribute.index], i, attribute.size, attribute.type,
+                    vertex_array.bind_vertex_attribute(i, attribute.size, attribute.type,
                         attribute.normalized, attribute.stride, attribute.offset + j * attribute.component_offset);
                 }
-                glVertexAttribDivisor(i, attribute.divisor);
+                gl.vertex_attrib_divisor(i, attribute.divisor);
                 ++i;
             }
         }
@@ -60,13 +61,32 @@ namespace zombye {
             buffers[attribute.index]->bind();
             for (auto j = 0; j < attribute.factor; ++j) {
                 if (attribute.type == GL_INT) {
-                    vertex_array.bind_vertex_attributei(*buffers[attribute.index], i, attribute.size, attribute.type,
+                    vertex_array.bind_vertex_attributei(i, attribute.size, attribute.type,
                         attribute.stride, attribute.offset + j * attribute.component_offset);
                 } else {
-                    vertex_array.bind_vertex_attribute(*buffers[attribute.index], i, attribute.size, attribute.type,
+                    vertex_array.bind_vertex_attribute(i, attribute.size, attribute.type,
                         attribute.normalized, attribute.stride, attribute.offset + j * attribute.component_offset);
                 }
-                glVertexAttribDivisor(i, attribute.divisor);
+                gl.vertex_attrib_divisor(i, attribute.divisor);
+                ++i;
+            }
+        }
+    }
+
+    void vertex_layout::setup_layout(const vertex_array& vertex_array, const vertex_stream_buffer& buffer) noexcept {
+        vertex_array.bind();
+        buffer.bind();
+        auto i = uint32_t{0};
+        for (auto& attribute : vertex_attributes_) {
+            for (auto j = 0; j < attribute.factor; ++j) {
+                if (attribute.type == GL_INT) {
+                    vertex_array.bind_vertex_attributei(i, attribute.size, attribute.type,
+                        attribute.stride, attribute.offset + j * attribute.component_offset);
+                } else {
+                    vertex_array.bind_vertex_attribute(i, attribute.size, attribute.type,
+                        attribute.normalized, attribute.stride, attribute.offset + j * attribute.component_offset);
+                }
+                gl.vertex_attrib_divisor(i, attribute.divisor);
                 ++i;
             }
         }
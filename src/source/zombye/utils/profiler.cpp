@@ -0,0 +1,68 @@
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+#include <zombye/utils/logger.hpp>
+#include <zombye/utils/profiler.hpp>
+
+namespace zombye {
+    profiler::profiler(size_t history_length, float log_threshold) noexcept
+    : history_length_{std::max(history_length, size_t{1})}, log_threshold_{log_threshold} { }
+
+    void profiler::record(const std::string& name, float milliseconds) {
+        auto& history = histories_[name];
+        if (history.samples.empty()) {
+            history.samples.resize(history_length_);
+        }
+        history.samples[history.next] = milliseconds;
+        history.next = (history.next + 1) % history.samples.size();
+        history.count = std::min(history.count + 1, history.samples.size());
+
+        if (log_threshold_ > 0.f && milliseconds > log_threshold_) {
+            auto stream = std::ostringstream{};
+            stream << std::fixed << std::setprecision(2) << name << " took " << milliseconds << " ms, "
+                << timing(name).average << " ms on average";
+            log(LOG_WARNING, stream.str());
+        }
+    }
+
+    profile_timing profiler::timing(const std::string& name) const noexcept {
+        auto timing = profile_timing{};
+        auto found = histories_.find(name);
+        if (found == histories_.end() || found->second.count == 0) {
+            return timing;
+        }
+        auto& history = found->second;
+        // the oldest measurements are overwritten first, so the history starts at next once it is full
+        auto first = history.count < history.samples.size() ? 0 : history.next;
+        auto total = 0.f;
+        for (auto i = size_t{0}; i < history.count; ++i) {
+            auto sample = history.samples[(first + i) % history.samples.size()];
+            total += sample;
+            timing.maximum = std::max(timing.maximum, sample);
+        }
+        timing.last = history.samples[(history.next + history.samples.size() - 1) % history.samples.size()];
+        timing.average = total / history.count;
+        timing.samples = history.count;
+        return timing;
+    }
+
+    std::string profiler::report() const {
+        auto stream = std::ostringstream{};
+        stream << std::fixed << std::setprecision(2);
+        for (auto& history : histories_) {
+            auto t = timing(history.first);
+            stream << history.first << ": last " << t.last << " ms, average " << t.average << " ms, max "
+                << t.maximum << " ms over " << t.samples << " measurements\n";
+        }
+        return stream.str();
+    }
+
+    cpu_timer::cpu_timer(profiler& profiler, std::string name) noexcept
+    : profiler_(profiler), name_{std::move(name)}, start_{std::chrono::steady_clock::now()} { }
+
+    cpu_timer::~cpu_timer() noexcept {
+        auto time = std::chrono::duration<float, std::milli>{std::chrono::steady_clock::now() - start_};
+        profiler_.record(name_, time.count());
+    }
+}
@@ -0,0 +1,86 @@
+#include <algorithm>
+
+#include <zombye/utils/thread_pool.hpp>
+
+zombye::thread_pool::thread_pool(size_t worker_count)
+: job_size_{0}, chunk_size_{1}, next_chunk_{0}, pending_chunks_{0}, running_{true} {
+    if (worker_count == 0) {
+        auto hardware_threads = std::thread::hardware_concurrency();
+        worker_count = hardware_threads > 1 ? hardware_threads - 1 : 0;
+    }
+
+    for (auto i = size_t{0}; i < worker_count; ++i) {
+        workers_.emplace_back([this]() { work(); });
+    }
+}
+
+zombye::thread_pool::~thread_pool() noexcept {
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        running_ = false;
+    }
+    work_available_.notify_all();
+
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+void zombye::thread_pool::parallel_for(size_t count, size_t grain,
+const std::function<void(size_t, size_t)>& function) {
+    if (count == 0) {
+        return;
+    }
+    grain = std::max(grain, size_t{1});
+
+    if (workers_.empty() || count <= grain) {
+        function(0, count);
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock{mutex_};
+    job_ = function;
+    job_size_ = count;
+    chunk_size_ = grain;
+    next_chunk_ = 0;
+    pending_chunks_ = (count + grain - 1) / grain;
+    work_available_.notify_all();
+
+    while (run_chunk(lock)) {
+    }
+    work_done_.wait(lock, [this]() { return pending_chunks_ == 0; });
+
+    job_ = nullptr;
+    job_size_ = 0;
+}
+
+void zombye::thread_pool::work() {
+    std::unique_lock<std::mutex> lock{mutex_};
+    while (true) {
+        work_available_.wait(lock, [this]() { return !running_ || next_chunk_ * chunk_size_ < job_size_; });
+        if (!running_) {
+            return;
+        }
+
+        while (run_chunk(lock)) {
+        }
+    }
+}
+
+bool zombye::thread_pool::run_chunk(std::unique_lock<std::mutex>& lock) {
+    auto begin = next_chunk_ * chunk_size_;
+    if (begin >= job_size_) {
+        return false;
+    }
+    ++next_chunk_;
+    auto end = std::min(begin + chunk_size_, job_size_);
+
+    lock.unlock();
+    job_(begin, end);
+    lock.lock();
+
+    if (--pending_chunks_ == 0) {
+        work_done_.notify_all();
+    }
+    return true;
+}
@@ -0,0 +1,83 @@
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gli/gli.hpp>
+
+#include <zombye/utils/load_dds.hpp>
+
+// compares loading dds files through gli, which copies every level into its own storage, with reading them
+// into one buffer and viewing their levels in place like the texture manager does. the levels are not uploaded,
+// since both paths hand the same bytes to gl.
+//
+// usage: texture_benchmark [-n iterations] assets/texture/*.dds
+namespace {
+    std::vector<char> read_file(const std::string& file_name) {
+        std::ifstream stream(file_name, std::ios::binary | std::ios::ate);
+        if (!stream) {
+            throw std::runtime_error("could not open " + file_name);
+        }
+        auto content = std::vector<char>(static_cast<size_t>(stream.tellg()));
+        stream.seekg(0, std::ios::beg);
+        stream.read(content.data(), content.size());
+        return content;
+    }
+
+    template <typename function>
+    double milliseconds(size_t iterations, function&& load) {
+        auto start = std::chrono::steady_clock::now();
+        for (auto i = size_t{0}; i < iterations; ++i) {
+            load();
+        }
+        auto time = std::chrono::duration<double, std::milli>{std::chrono::steady_clock::now() - start};
+        return time.count() / iterations;
+    }
+}
+
+int main(int argc, char const* argv[]) {
+    auto iterations = size_t{20};
+    auto files = std::vector<std::string>{};
+    for (auto i = 1; i < argc; ++i) {
+        if (std::string{argv[i]} == "-n" && i + 1 < argc) {
+            iterations = std::max(std::stoul(argv[++i]), 1ul);
+        } else {
+            files.emplace_back(argv[i]);
+        }
+    }
+    if (files.empty()) {
+        throw std::runtime_error("no dds files passed to texture_benchmark");
+    }
+
+    auto total_gli = 0.0;
+    auto total_native = 0.0;
+    auto total_bytes = size_t{0};
+    for (auto& file : files) {
+        auto level_bytes = size_t{0};
+        auto gli_time = milliseconds(iterations, [&file]() {
+            auto texture = gli::texture2D{gli::load_dds(file.c_str())};
+            if (texture.empty()) {
+                throw std::runtime_error("gli could not load " + file);
+            }
+        });
+        auto native_time = milliseconds(iterations, [&file, &level_bytes]() {
+            auto content = read_file(file);
+            auto image = zombye::read_dds(content.data(), content.size(), file);
+            level_bytes = 0;
+            for (auto& level : image.levels) {
+                level_bytes += level.size;
+            }
+        });
+        std::cout << file << ": " << level_bytes << " bytes, gli " << gli_time << " ms, in place "
+            << native_time << " ms" << std::endl;
+        total_gli += gli_time;
+        total_native += native_time;
+        total_bytes += level_bytes;
+    }
+    std::cout << files.size() << " files with " << total_bytes << " bytes: gli " << total_gli << " ms, in place "
+        << total_native << " ms" << std::endl;
+    return 0;
+}